@@ -0,0 +1,94 @@
+# Writes firmware.bin.hs next to every built firmware.bin: the image compressed with heatshrink
+# (window 10, lookahead 5, as OTA_HEATSHRINK_WINDOW_BITS / OTA_HEATSHRINK_LOOKAHEAD_BITS) for /api/update.
+# Runs as a PlatformIO post script, or by hand: python3 compress_firmware.py firmware.bin firmware.bin.hs
+
+import hashlib
+import sys
+
+WINDOW_BITS = 10
+LOOKAHEAD_BITS = 5
+
+WINDOW = 1 << WINDOW_BITS
+LOOKAHEAD = 1 << LOOKAHEAD_BITS
+BACKREF_BITS = 1 + WINDOW_BITS + LOOKAHEAD_BITS
+
+
+class BitWriter:
+    def __init__(self):
+        self.output = bytearray()
+        self.bits = 0
+        self.count = 0
+
+    def push(self, value, count):
+        self.bits = (self.bits << count) | (value & ((1 << count) - 1))
+        self.count += count
+
+        while self.count >= 8:
+            self.count -= 8
+            self.output.append((self.bits >> self.count) & 0xff)
+
+        self.bits &= (1 << self.count) - 1
+
+    def finish(self):
+        if self.count > 0: self.push(0, 8 - self.count)
+        return bytes(self.output)
+
+
+# Greedy longest match, the nearest one on ties, same as the reference encoder of the ota scenario
+def heatshrink_encode(data):
+    writer = BitWriter()
+    pos = 0
+
+    while pos < len(data):
+        start = max(0, pos - WINDOW)
+        max_length = min(LOOKAHEAD, len(data) - pos)
+
+        best_length = 0
+        best_offset = 0
+
+        # A match may run on into the bytes it is copying, so the haystack ends inside the lookahead
+        length = 1
+        while length <= max_length:
+            found = data.rfind(data[pos:pos + length], start, pos + length - 1)
+            if found < 0: break
+
+            best_length = length
+            best_offset = pos - found
+            length += 1
+
+        if best_length * 9 > BACKREF_BITS:
+            writer.push(0, 1)
+            writer.push(best_offset - 1, WINDOW_BITS)
+            writer.push(best_length - 1, LOOKAHEAD_BITS)
+            pos += best_length
+        else:
+            writer.push(1, 1)
+            writer.push(data[pos], 8)
+            pos += 1
+
+    return writer.finish()
+
+
+def compress(source, target):
+    with open(source, "rb") as file:
+        image = file.read()
+
+    compressed = heatshrink_encode(image)
+    with open(target, "wb") as file:
+        file.write(compressed)
+
+    print("heatshrink: %s, %u -> %u bytes (%.1f%%), sha256 %s" % (
+        target, len(image), len(compressed), 100.0 * len(compressed) / max(1, len(image)),
+        hashlib.sha256(compressed).hexdigest()))
+
+
+if __name__ == "__main__" and len(sys.argv) == 3:
+    compress(sys.argv[1], sys.argv[2])
+else:
+    Import("env")
+
+    def _post_build(target, source, env):
+        image = str(target[0])
+        compress(image, image + ".hs")
+
+    env.AddPostAction("$BUILD_DIR/${PROGNAME}.bin", _post_build)
@@ -0,0 +1,69 @@
+#include "animation.h"
+
+#include <algorithm>
+
+#include "utils/math.h"
+
+AnimationStep animation_step(const AnimationInput &input) {
+    AnimationStep step;
+
+    switch (input.state) {
+        case AppState::UNINITIALIZED:
+            break;
+
+        case AppState::INITIALIZATION:
+            // Keep the light steady during the first flash period, so fast connections don't blink at all
+            if (input.power && input.elapsed >= input.flash_timeout) {
+                // Start the wave from its peak to avoid a sudden drop of the brightness
+                const auto factor = map16(
+                    (input.elapsed + input.flash_timeout / 2) % input.flash_timeout,
+                    input.flash_timeout,
+                    PWM_MAX_VALUE
+                );
+
+                step.write = true;
+                step.brightness = input.brightness * quad_wave16(factor, PWM_MAX_VALUE) / PWM_MAX_VALUE;
+            }
+            break;
+
+        case AppState::TURNING_ON: {
+            uint16_t factor = std::min<unsigned long>(PWM_MAX_VALUE,
+                input.elapsed * PWM_MAX_VALUE / input.power_change_timeout);
+
+            step.write = true;
+            step.brightness = input.brightness * ease_quad16(factor, PWM_MAX_VALUE) / PWM_MAX_VALUE;
+            step.finished = factor == PWM_MAX_VALUE;
+            break;
+        }
+
+        case AppState::TURNING_OFF: {
+            uint16_t factor = PWM_MAX_VALUE - std::min<unsigned long>(PWM_MAX_VALUE,
+                input.elapsed * PWM_MAX_VALUE / input.power_change_timeout);
+
+            step.write = true;
+            step.brightness = input.brightness * ease_quad16(factor, PWM_MAX_VALUE) / PWM_MAX_VALUE;
+            step.finished = factor == 0;
+            break;
+        }
+
+        case AppState::TRANSITION: {
+            uint16_t factor = std::min<unsigned long>(PWM_MAX_VALUE,
+                input.elapsed * PWM_MAX_VALUE / input.transition_duration);
+
+            step.write = true;
+            step.brightness = input.transition_from + ((int32_t) input.brightness - input.transition_from)
+                * ease_quad16(factor, PWM_MAX_VALUE) / PWM_MAX_VALUE;
+            step.finished = factor == PWM_MAX_VALUE;
+            break;
+        }
+
+        case AppState::STAND_BY:
+            if (input.power && input.night) {
+                step.write = true;
+                step.brightness = input.night_brightness;
+            }
+            break;
+    }
+
+    return step;
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+
+#include "app/config.h"
+
+// Everything a pass of the app loop needs to animate the main light
+struct AnimationInput {
+    AppState state;
+    unsigned long elapsed;              // ms since the state change
+    bool power;
+    uint16_t brightness;                // Target brightness of the current state
+    uint16_t transition_from;
+    unsigned long transition_duration;
+    unsigned long power_change_timeout;
+    unsigned long flash_timeout;        // Wave period while connecting
+    bool night;
+    uint16_t night_brightness;
+};
+
+struct AnimationStep {
+    bool write = false;                 // Brightness has to be applied
+    uint16_t brightness = 0;
+    bool finished = false;              // The animated state is over, go to STAND_BY
+};
+
+// Brightness of the main light for one pass of the app loop. Pure, so it can be driven by the native simulation
+AnimationStep animation_step(const AnimationInput &input);
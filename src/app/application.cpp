@@ -2,6 +2,8 @@
 
 #include <utils/color.h>
 
+const PropertyActionTable PROPERTY_ACTION_TABLE PROGMEM = build_property_action_table();
+
 void Application::begin() {
     D_PRINT("Starting application...");
 
@@ -9,9 +11,39 @@ void Application::begin() {
         D_PRINT("Unable to initialize FS");
     }
 
-    _bootstrap = std::make_unique<Bootstrap<Config, PacketType>>(&LittleFS);
+    _boot_timings.fs_mount = millis();
+
+    _bootstrap.emplace(&LittleFS);
+    _boot_timings.config_load = millis();
 
     auto &sys_config = _bootstrap->config().sys_config;
+
+    if (config().preset >= PRESET_COUNT) config().preset = 0;
+    _active_preset = config().preset;
+    _led.create(sys_config).begin();
+
+    _check_zone_pins();
+    for (uint8_t i = 0; i < ZONE_COUNT - 1; ++i) {
+        auto &zone_config = _bootstrap->config().zones.items[i];
+        if (_zone_pins[i] != ZonePinStatus::OK) continue;
+
+        _zones[i].emplace(i + 1, this, zone_config, sys_config);
+        _zones[i]->begin();
+
+        if (_zones[i]->follows_night()) _night_zones |= 1u << i;
+    }
+    _night_mode_manager.emplace(_bootstrap->config());
+    _ntp_time.emplace();
+
+    // Restore saved output state before any network bring-up
+    change_state(AppState::STAND_BY);
+    load();
+
+    _boot_timings.led_on = millis();
+    D_PRINTF("Light restored in %lu ms\r\n", _boot_timings.led_on);
+
+    if (sys_config.wifi_mode == WIFI_STA_MODE) _wifi_cache.begin(sys_config);
+
     _bootstrap->begin({
         .mdns_name = sys_config.mdns_name,
         .wifi_mode = sys_config.wifi_mode,
@@ -25,136 +57,564 @@ void Application::begin() {
         .mqtt_password = sys_config.mqtt_password,
     });
 
-    if (sys_config.led_type == LedType::RGB) {
-        _led = std::make_unique<LedController>(sys_config.led_r_pin, sys_config.led_g_pin, sys_config.led_b_pin);
-    } else if (sys_config.led_type == LedType::CCT) {
-        _led = std::make_unique<LedController>(sys_config.led_r_pin, sys_config.led_g_pin);
-    } else {
-        _led = std::make_unique<LedController>(sys_config.led_r_pin);
-    }
+    if (sys_config.wifi_mode == WIFI_STA_MODE) _wifi_cache.connect(sys_config);
 
-    _led->begin();
-    _night_mode_manager = std::make_unique<NightModeManager>(_bootstrap->config());
-    _ntp_time = std::make_unique<NtpTime>();
-
-    _api = std::make_unique<ApiWebServer>(*this);
+    _api.emplace(*this);
     _api->begin(_bootstrap->web_server());
+    _feed.begin(_bootstrap->web_server());
 
     if (sys_config.button_enabled) {
-        _btn = std::make_unique<Button>(sys_config.button_pin, sys_config.button_high_state);
-
-        _btn->set_on_click([this](auto cnt) {
-            if (cnt == 1) {
-                this->set_power(!config().power);
-            } else if (cnt == 2) {
-                trigger_temperature();
-            }
-        });
-
-        _btn->set_on_hold([this](auto cnt) {
-            if (cnt == 1) {
-                this->brightness_increase();
-            } else if (cnt == 2) {
-                this->brightness_decrease();
-            }
-        });
-
-        _btn->set_on_hold_release([this](auto cnt) {
-            if (cnt <= 2) {
-                NotificationBus::get().notify_parameter_changed(this, _metadata->brightness.get_parameter());
-            }
-        });
-
-        _btn->set_hold_call_interval(BTN_HOLD_CALL_INTERVAL);
+        _btn.emplace(sys_config.button_pin, sys_config.button_high_state);
+        _btn->set_on_gesture([this](auto gesture, auto count) { _handle_button_gesture(gesture, count); });
         _btn->begin();
     }
 
     _bootstrap->event_state_changed().subscribe(this, [this](auto sender, auto state, auto arg) {
         _bootstrap_state_changed(sender, state, arg);
     });
-    _bootstrap->timer().add_interval([this](auto) { _app_loop(); }, APP_LOOP_INTERVAL);
+    _timers.begin(millis());
+    _timers.schedule(_app_timer, APP_LOOP_INTERVAL, APP_LOOP_INTERVAL);
 
     _setup();
-    change_state(AppState::INITIALIZATION);
 }
 
+// Metadata, zone state and zone config can all carry a packet type
+static_assert(METADATA_PROPERTY_COUNT + (ZONE_COUNT - 1) * 2 <= WS_FEED_ENTRY_COUNT,
+    "WS_FEED_ENTRY_COUNT is too small for the parameters with a packet type");
+
+// Metadata and every zone need a topic, otherwise their changes are counted as unrouted
+static_assert(METADATA_PROPERTY_COUNT + (ZONE_COUNT - 1) * ZONE_NOTIFICATION_TOPIC_COUNT <= NOTIFICATION_TOPIC_COUNT,
+    "NOTIFICATION_TOPIC_COUNT is too small for the registered parameters");
+
 void Application::_setup() {
     NotificationBus::get().subscribe([this](auto sender, auto param) {
-        if (sender != this) _handle_property_change(param);
+        _notifications.dispatch(sender, param);
+        _feed.changed(param);
     });
 
     auto &ws_server = _bootstrap->ws_server();
     auto &mqtt_server = _bootstrap->mqtt_server();
 
-    _metadata = std::make_unique<ConfigMetadata>(build_metadata(config()));
-    _metadata->visit([this, &ws_server, &mqtt_server](AbstractPropertyMeta *meta) {
-        auto binary_protocol = (BinaryProtocolMeta<PacketType> *) meta->get_binary_protocol();
-        if (binary_protocol->packet_type.has_value()) {
-            ws_server->register_parameter(*binary_protocol->packet_type, meta->get_parameter());
-            VERBOSE(D_PRINTF("WebSocket: Register property %s\r\n", __debug_enum_str(*binary_protocol->packet_type)));
-        }
-
-        auto mqtt_protocol = meta->get_mqtt_protocol();
-        if (mqtt_protocol->topic_in && mqtt_protocol->topic_out) {
-            mqtt_server->register_parameter(mqtt_protocol->topic_in, mqtt_protocol->topic_out, meta->get_parameter());
-            VERBOSE(D_PRINTF("MQTT: Register property %s <-> %s\r\n", mqtt_protocol->topic_in, mqtt_protocol->topic_out));
-        } else if (mqtt_protocol->topic_out) {
-            mqtt_server->register_notification(mqtt_protocol->topic_out, meta->get_parameter());
-            VERBOSE(D_PRINTF("MQTT: Register notification -> %s\r\n", mqtt_protocol->topic_out));
+    // Only the parameters are kept in RAM, everything else about a property is read from the flash table
+    _memory_stats.metadata_heap_before = ESP.getFreeHeap();
+    _parameters.create(config(), [this, &ws_server, &mqtt_server](const PropertyDescriptor &property, AbstractParameter *parameter) {
+        ws_server->register_parameter(property.packet_type, parameter);
+        VERBOSE(D_PRINTF("WebSocket: Register property %s\r\n", __debug_enum_str(property.packet_type)));
+
+        if (property.topic_in && property.topic_out) {
+            mqtt_server->register_parameter(property.topic_in, property.topic_out, parameter);
+            VERBOSE(D_PRINTF("MQTT: Register property %s <-> %s\r\n", property.topic_in, property.topic_out));
+        } else if (property.topic_out) {
+            mqtt_server->register_notification(property.topic_out, parameter);
+            VERBOSE(D_PRINTF("MQTT: Register notification -> %s\r\n", property.topic_out));
         }
 
-        if (binary_protocol->packet_type.has_value()) {
-            _parameter_to_packet[meta->get_parameter()] = binary_protocol->packet_type.value();
-        }
+        _notifications.add_topic(parameter, (uint8_t) property.packet_type);
     });
+    _memory_stats.metadata_heap_after = ESP.getFreeHeap();
+
+    for (auto &zone : _zones) {
+        if (!zone) continue;
+
+        zone->register_parameters(ws_server, mqtt_server);
+        zone->register_topics(_notifications);
+    }
+
+    _config_meta.emplace(ComplexParameter(&config()));
+    ws_server->register_data_request(PacketType::GET_CONFIG, *_config_meta);
+    ws_server->register_command(PacketType::RESTART, [this] { restart(); });
+    _memory_stats.registered_heap_after = ESP.getFreeHeap();
+
+    // Every topic keyed by a packet type is carried by the filtered feed as well
+    for (uint8_t i = 0; i < _notifications.topic_count(); ++i) {
+        const auto &topic = _notifications.topic(i);
+        if (topic.key) _feed.feed().add(topic.key, topic.parameter);
+    }
+
+    if (_notifications.stats().overflows > 0) {
+        D_PRINTF("Notifications: ERROR %u registrations don't fit their table\r\n", (unsigned) _notifications.stats().overflows);
+    }
+
+    // The cursor comes with the request and the page goes only to the client that asked, read on the app loop
+    _feed.on_request([](void *arg, const uint8_t *request, size_t length, uint8_t *response, size_t size) {
+        return ((const Application *) arg)->_answer_history(request, length, response, size);
+    }, this);
+
+    // Own changes are already applied, only changes written by the servers are handled
+    _notifications.subscribe_range(&config(), sizeof(Config), [](void *arg, void *, const AbstractParameter *parameter) {
+        ((Application *) arg)->_property_changed(parameter);
+    }, this, this);
+
+    _timers.schedule(_notification_timer, NOTIFICATION_RATE_INTERVAL, NOTIFICATION_RATE_INTERVAL);
 
-    ws_server->register_data_request(PacketType::GET_CONFIG, _metadata->data.config);
-    ws_server->register_command(PacketType::RESTART, [this] { _bootstrap->restart(); });
+    _boot_timings.services_ready = millis();
+    D_PRINTF("Services registered in %lu ms\r\n", _boot_timings.services_ready);
+}
+
+void Application::_property_changed(const AbstractParameter *parameter) {
+    // Parameter is already written by the server, defer the reaction to the app loop
+    _pending_properties.add(property_action(config(), parameter), property_zone(config(), parameter));
+}
+
+void Application::restart() {
+    if (sys_config().wifi_mode == WIFI_STA_MODE) _wifi_cache.stamp_restart(sys_config());
+    _bootstrap->restart();
 }
 
 void Application::event_loop() {
     _bootstrap->event_loop();
+    _timers.update(millis());
+
+    // Nothing of ours is due before the deadline, the app timer keeps it within one tick for the framework.
+    // delay() yields to the network stack and lets the idle task run instead of spinning
+    const unsigned long sleep = std::min<unsigned long>(_timers.next_deadline(millis()), APP_LOOP_INTERVAL);
+    if (sleep > 0) {
+        delay(sleep);
+        _loop_stats.sleep_total += sleep;
+    }
+}
+
+void Application::_handle_button_gesture(ButtonGesture gesture, uint8_t count) {
+    const auto &actions = config().button_actions;
+
+    ButtonAction action = ButtonAction::NONE;
+    if (gesture == ButtonGesture::CLICK) {
+        if (count == 1) action = actions.click_1;
+        else if (count == 2) action = actions.click_2;
+        else if (count == 3) action = actions.click_3;
+    } else {
+        if (count == 1) action = actions.hold_1;
+        else if (count == 2) action = actions.hold_2;
+    }
+
+    const bool brightness_ramp = action == ButtonAction::BRIGHTNESS_UP || action == ButtonAction::BRIGHTNESS_DOWN;
+
+    switch (gesture) {
+        case ButtonGesture::CLICK:
+        case ButtonGesture::HOLD:
+            _run_button_action(action);
+            break;
+
+        case ButtonGesture::HOLD_REPEAT:
+            if (brightness_ramp) _run_button_action(action);
+            break;
+
+        case ButtonGesture::HOLD_RELEASE:
+            if (brightness_ramp) _notify(ChangeNotification::BRIGHTNESS);
+            break;
+    }
+}
+
+void Application::_run_button_action(ButtonAction action) {
+    switch (action) {
+        case ButtonAction::NONE:
+            break;
+
+        case ButtonAction::POWER:
+            set_power(!config().power);
+            break;
+
+        case ButtonAction::TEMPERATURE:
+            trigger_temperature();
+            break;
+
+        case ButtonAction::NEXT_PRESET:
+            recall_preset((config().preset + 1) % PRESET_COUNT);
+            break;
+
+        case ButtonAction::BRIGHTNESS_UP:
+            brightness_increase();
+            break;
+
+        case ButtonAction::BRIGHTNESS_DOWN:
+            brightness_decrease();
+            break;
+    }
+}
+
+bool Application::submit(const Command &command) {
+    if (!_commands.push(command)) {
+        D_PRINTF("Command queue overflow, dropped: %s\r\n", __debug_enum_str(command.type));
+        return false;
+    }
+
+    return true;
+}
+
+void Application::_record_history() {
+    // Same order as HistoryEventType
+    const uint32_t values[HISTORY_EVENT_TYPE_COUNT] = {
+        config().power,
+        config().brightness,
+        config().color,
+        config().color_temperature,
+        _night_mode_manager->is_night_time(),
+    };
+
+    for (uint8_t i = 0; i < HISTORY_EVENT_TYPE_COUNT; ++i) {
+        if (_history_started && values[i] == _history_values[i]) continue;
+
+        _history.record((HistoryEventType) i, values[i], millis());
+        _history_values[i] = values[i];
+    }
+
+    _history_started = true;
+}
+
+// Request: [HISTORY][cursor: u32], answer: [HISTORY][HistoryPage]
+static_assert(1 + sizeof(HistoryPage) <= WS_MAX_PACKET_SIZE, "History page doesn't fit a WebSocket packet");
+
+size_t Application::_answer_history(const uint8_t *request, size_t length, uint8_t *response, size_t size) const {
+    if (length != 1 + sizeof(uint32_t) || request[0] != (uint8_t) PacketType::HISTORY || size < 1 + sizeof(HistoryPage)) {
+        return 0;
+    }
+
+    uint32_t cursor;
+    memcpy(&cursor, request + 1, sizeof(cursor));
+
+    // Only the app loop writes the history, so the read can't be interrupted here
+    response[0] = (uint8_t) PacketType::HISTORY;
+    _history.read_page(cursor, millis(), *(HistoryPage *) (response + 1));
+
+    return 1 + sizeof(HistoryPage);
+}
+
+void Application::_process_commands() {
+    if (_commands.size() == 0 && _pending_properties.empty()) return;
+
+    // The whole drain is one transaction: a burst of slider updates renders and saves once
+    _begin();
+
+    // Written values are already in Config, so only the latest state of each is handled
+    _pending_properties.take([this](PropertyAction action) { _handle_property_change(action); }, [this](uint8_t id) {
+        if (id > 0 && id < ZONE_COUNT && _zones[id - 1]) _update_zone(*_zones[id - 1]);
+    });
+
+    Command command;
+    while (_commands.pop(command)) _handle_command(command);
+
+    _commit();
+}
+
+void Application::_begin() {
+    ++_transaction_depth;
+}
+
+void Application::_commit() {
+    if (_transaction_depth > 0 && --_transaction_depth > 0) return;
+
+    // Applying a change may request more, e.g. a derived color notifies its 16-bit version
+    _resolve_color();
+
+    // The 16-bit color widened from an implied one is implied as well
+    const uint16_t color_bit = 1u << (uint8_t) ChangeNotification::COLOR;
+    const uint16_t color_16_bit = 1u << (uint8_t) ChangeNotification::COLOR_16;
+    if ((_changes.implied & color_bit) && (_changes.notifications & color_16_bit)) {
+        _changes.notifications &= ~color_16_bit;
+        _changes.implied |= color_16_bit;
+    }
+
+    const auto changes = _changes;
+    if (!changes.load && !changes.load_color && !changes.save && !changes.notifications && !changes.implied) return;
+
+    _changes = {};
+    ++_change_stats.commits;
+
+    if (changes.load) {
+        load();
+        ++_change_stats.loads;
+    } else if (changes.load_color) {
+        _load_color();
+        ++_change_stats.loads;
+    }
+
+    if (changes.save) {
+        _bootstrap->save_changes();
+        ++_change_stats.saves;
+    }
+
+    for (uint16_t mask = changes.notifications; mask; mask &= mask - 1) {
+        NotificationBus::get().notify_parameter_changed(this, _notification_parameter((ChangeNotification) __builtin_ctz(mask)));
+        ++_change_stats.notifications;
+    }
+
+    // Filtered feed clients subscribe per packet type and can't derive one from another
+    for (uint16_t mask = changes.implied & ~changes.notifications; mask; mask &= mask - 1) {
+        _feed.changed(_notification_parameter((ChangeNotification) __builtin_ctz(mask)));
+    }
+}
+
+const AbstractParameter *Application::_notification_parameter(ChangeNotification notification) {
+    switch (notification) {
+        case ChangeNotification::POWER: return _parameters.get(ConfigProperty::POWER);
+        case ChangeNotification::BRIGHTNESS: return _parameters.get(ConfigProperty::BRIGHTNESS);
+        case ChangeNotification::COLOR: return _parameters.get(ConfigProperty::COLOR);
+        case ChangeNotification::COLOR_16: return _parameters.get(ConfigProperty::COLOR_16);
+        case ChangeNotification::CALIBRATION: return _parameters.get(ConfigProperty::CALIBRATION);
+        case ChangeNotification::CALIBRATION_16: return _parameters.get(ConfigProperty::CALIBRATION_16);
+        case ChangeNotification::COLOR_TEMPERATURE: return _parameters.get(ConfigProperty::COLOR_TEMPERATURE);
+        case ChangeNotification::PRESET: return _parameters.get(ConfigProperty::PRESET);
+        case ChangeNotification::PRESETS: return _parameters.get(ConfigProperty::PRESETS);
+    }
+
+    return nullptr;
 }
 
-void Application::_handle_property_change(const AbstractParameter *parameter) {
-    auto it = _parameter_to_packet.find(parameter);
-    if (it == _parameter_to_packet.end()) return;
+void Application::_request_load(bool color_only) {
+    if (color_only) _changes.load_color = true;
+    else _changes.load = true;
+
+    ++_change_stats.load_requests;
+}
 
-    auto type = it->second;
-    if (type == PacketType::POWER) {
-        set_power(config().power);
-    } else if (type == PacketType::TEMPERATURE) {
-        if (_led->led_type() == LedType::RGB) {
-            uint32_t kelvin = sys_config().led_min_temperature + config().color_temperature *
-                (sys_config().led_max_temperature - sys_config().led_min_temperature) / LED_TEMPERATURE_MAX_VALUE;
+void Application::_request_save() {
+    _changes.save = true;
+    ++_change_stats.save_requests;
+}
+
+void Application::_request_color(ColorSource source) {
+    _changes.color_source = source;
+}
+
+void Application::_notify(ChangeNotification notification) {
+    const uint16_t bit = 1u << (uint8_t) notification;
+
+    // A change made after the one it was implied by has to be broadcast on its own
+    _changes.notifications |= bit;
+    _changes.implied &= ~bit;
+    ++_change_stats.notify_requests;
+}
+
+void Application::_notify_implied(ChangeNotification notification) {
+    const uint16_t bit = 1u << (uint8_t) notification;
+    _changes.implied |= bit;
+    _changes.notifications &= ~bit;
+}
+
+void Application::_resolve_color() {
+    const auto source = _changes.color_source;
+    _changes.color_source = ColorSource::NONE;
+
+    switch (source) {
+        case ColorSource::NONE:
+            break;
+
+        case ColorSource::TEMPERATURE:
+            if (_led->led_type() != LedType::RGB) break;
+
+            config().color = temperature_to_rgb(sys_config().led_min_temperature + config().color_temperature *
+                (sys_config().led_max_temperature - sys_config().led_min_temperature) / LED_TEMPERATURE_MAX_VALUE);
+
+            _notify(ChangeNotification::COLOR);
+            _widen_color();
+            break;
 
-            config().color = temperature_to_rgb(kelvin);
-            NotificationBus::get().notify_parameter_changed(this, _metadata->color.get_parameter());
+        case ColorSource::COLOR:
+            _widen_color();
+            break;
+
+        case ColorSource::COLOR_16:
+            _narrow_color();
+            break;
+    }
+}
+
+void Application::_handle_command(const Command &command) {
+    if (command.zone > 0) {
+        auto zone = command.zone < ZONE_COUNT && _zones[command.zone - 1] ? &*_zones[command.zone - 1] : nullptr;
+        if (!zone) return;
+
+        if (zone->apply(command)) _update_zone(*zone);
+        return;
+    }
+
+    switch (command.type) {
+        case CommandType::POWER:
+            set_power(command.value != 0);
+            break;
+
+        case CommandType::BRIGHTNESS:
+            config().brightness = std::min<uint32_t>(PWM_MAX_VALUE, command.value);
+            _notify(ChangeNotification::BRIGHTNESS);
+            _request_load();
+            break;
+
+        case CommandType::COLOR:
+            config().color = command.value & 0xffffff;
+            _notify(ChangeNotification::COLOR);
+            _handle_property_change(PropertyAction::COLOR);
+            break;
+
+        case CommandType::TEMPERATURE:
+            config().color_temperature = std::min<uint32_t>(LED_TEMPERATURE_MAX_VALUE, command.value);
+            _notify(ChangeNotification::COLOR_TEMPERATURE);
+            _handle_property_change(PropertyAction::TEMPERATURE);
+            break;
+
+        case CommandType::RECALL_PRESET:
+            recall_preset(command.value);
+            break;
+
+        case CommandType::SAVE_PRESET:
+            save_preset(command.value);
+            break;
+    }
+}
+
+void Application::_handle_property_change(PropertyAction action) {
+    switch (action) {
+        case PropertyAction::NONE:
+            break;
+
+        case PropertyAction::POWER:
+            set_power(config().power);
+            break;
+
+        case PropertyAction::TEMPERATURE:
+            _request_color(ColorSource::TEMPERATURE);
+            update();
+            break;
+
+        case PropertyAction::COLOR:
+            _request_color(ColorSource::COLOR);
+            update();
+            break;
+
+        case PropertyAction::COLOR_16:
+            _request_color(ColorSource::COLOR_16);
+            update();
+            break;
+
+        case PropertyAction::NIGHT_MODE:
+            _night_mode_manager->reset();
+            update();
+            break;
+
+        case PropertyAction::PRESET:
+            recall_preset(config().preset);
+            break;
+
+        case PropertyAction::SAVE:
+            _check_zone_pins();
+            _request_save();
+            break;
+
+        case PropertyAction::UPDATE:
+            _check_zone_pins();
+            update();
+            break;
+
+        case PropertyAction::ZONE:
+            // Addressed to a zone, handled in _process_commands
+            break;
+    }
+}
+
+void Application::_check_zone_pins() {
+    const auto pins = check_zone_pins(config());
+
+    for (uint8_t i = 0; i < ZONE_COUNT - 1; ++i) {
+        if (pins[i] != _zone_pins[i] && pins[i] != ZonePinStatus::OK && pins[i] != ZonePinStatus::DISABLED) {
+            D_PRINTF("Zone %u: Pins rejected: %s\r\n", i + 1, __debug_enum_str(pins[i]));
         }
+    }
 
-        update();
-    } else if (type >= PacketType::NIGHT_MODE_ENABLED && type <= PacketType::NIGHT_MODE_BRIGHTNESS) {
-        _night_mode_manager->reset();
-        update();
+    _zone_pins = pins;
+}
+
+void Application::_update_zone(Zone &zone) {
+    const uint8_t bit = 1u << (zone.id() - 1);
+
+    if (zone.follows_night()) {
+        _night_zones |= bit;
+
+        const bool night = _night_mode_manager->is_night_time();
+        zone.set_night(night, night ? _night_mode_manager->get_brightness() : 0);
     } else {
-        update();
+        _night_zones &= ~bit;
+    }
+
+    zone.update();
+    if (zone.animating()) _animating_zones |= bit;
+
+    _request_save();
+}
+
+void Application::_tick_zones() {
+    const auto now = millis();
+    for (uint8_t mask = _animating_zones; mask; mask &= mask - 1) {
+        const uint8_t index = __builtin_ctz(mask);
+        if (!_zones[index]->tick(now)) _animating_zones &= ~(1u << index);
+    }
+
+    if (!_night_zones) return;
+
+    // Night brightness fades slowly, push it only to the zones that follow it and only when it changes
+    const bool night = _night_mode_manager->is_night_time();
+    const uint16_t night_brightness = night ? _night_mode_manager->get_brightness() : 0;
+    if (night != _zones_night || night_brightness != _zones_night_brightness) {
+        _zones_night = night;
+        _zones_night_brightness = night_brightness;
+
+        for (uint8_t mask = _night_zones; mask; mask &= mask - 1) {
+            _zones[__builtin_ctz(mask)]->set_night(night, night_brightness);
+        }
     }
 }
 
 void Application::load() {
+    // Color first: at boot it's loaded while the output is still dark
+    _load_color();
     _led->set_brightness(config().power ? _brightness() : PIN_DISABLED);
+}
 
+void Application::_load_color() {
     if (_led->led_type() == LedType::RGB) {
-        _led->set_calibration(config().calibration);
-        _led->set_color(config().color);
+        _led->set_calibration(config().calibration_16);
+        _led->set_color(config().color_16);
     } else if (_led->led_type() == LedType::CCT) {
         _led->set_temperature(config().color_temperature);
     }
 }
 
+// 8-bit values win only if they no longer match the 16-bit ones, so a round trip through the 8-bit
+// parameters (MQTT, old clients) doesn't discard the extra precision
+
+void Application::_widen_color() {
+    auto &c = config();
+
+    if (rgb24_from_rgb48(c.color_16) != (c.color & 0xffffff)) {
+        c.color_16 = rgb48_from_rgb24(c.color);
+        _notify(ChangeNotification::COLOR_16);
+    }
+
+    if (rgb24_from_rgb48(c.calibration_16) != (c.calibration & 0xffffff)) {
+        c.calibration_16 = rgb48_from_rgb24(c.calibration);
+        _notify(ChangeNotification::CALIBRATION_16);
+    }
+}
+
+void Application::_narrow_color() {
+    auto &c = config();
+
+    const uint32_t color = rgb24_from_rgb48(c.color_16);
+    if (color != (c.color & 0xffffff)) {
+        c.color = color;
+        _notify(ChangeNotification::COLOR);
+    }
+
+    const uint32_t calibration = rgb24_from_rgb48(c.calibration_16);
+    if (calibration != (c.calibration & 0xffffff)) {
+        c.calibration = calibration;
+        _notify(ChangeNotification::CALIBRATION);
+    }
+}
+
 void Application::update() {
-    _bootstrap->save_changes();
-    load();
+    _begin();
+    _request_save();
+    _request_load();
+    _commit();
 }
 
 void Application::change_state(AppState s) {
@@ -164,6 +624,7 @@ void Application::change_state(AppState s) {
 }
 
 void Application::set_power(bool on, bool skip_animation) {
+    _begin();
     config().power = on;
 
     D_PRINTF("Turning Power: %s\r\n", on ? "ON" : "OFF");
@@ -171,22 +632,26 @@ void Application::set_power(bool on, bool skip_animation) {
         change_state(on ? AppState::TURNING_ON : AppState::TURNING_OFF);
     } else {
         change_state(AppState::STAND_BY);
-        load();
+        _request_load();
     }
 
-    _bootstrap->save_changes();
-    NotificationBus::get().notify_parameter_changed(this, _metadata->power.get_parameter());
+    _request_save();
+    _notify(ChangeNotification::POWER);
+    _commit();
 }
 
 void Application::brightness_increase() {
+    _begin();
     if (!config().power) set_power(true, true);
 
-    if (config().brightness == PWM_MAX_VALUE) return;
+    if (config().brightness < PWM_MAX_VALUE) {
+        config().brightness = std::min<uint16_t>(PWM_MAX_VALUE, config().brightness + max<uint16_t>(1, PWM_MAX_VALUE / BRIGHTNESS_CHANGE_DIVIDER));
 
-    config().brightness = std::min<uint16_t>(PWM_MAX_VALUE, config().brightness + max<uint16_t>(1, PWM_MAX_VALUE / BRIGHTNESS_CHANGE_DIVIDER));
+        D_PRINTF("Increase brightness: %u\r\n", config().brightness);
+        update();
+    }
 
-    D_PRINTF("Increase brightness: %u\r\n", config().brightness);
-    update();
+    _commit();
 }
 
 void Application::brightness_decrease() {
@@ -209,8 +674,77 @@ void Application::trigger_temperature() {
 
     D_PRINTF("Change temperature: %u\r\n", config().color_temperature);
 
+    _begin();
+    _request_color(ColorSource::TEMPERATURE);
+    _notify(ChangeNotification::COLOR_TEMPERATURE);
     update();
-    NotificationBus::get().notify_parameter_changed(this, _metadata->color_temperature.get_parameter());
+    _commit();
+}
+
+void Application::recall_preset(uint8_t index) {
+    if (index >= PRESET_COUNT) {
+        D_PRINTF("Recall preset: invalid index %u\r\n", index);
+
+        // May have been written over the protocol already, restore it and let the clients know
+        _begin();
+        config().preset = _active_preset;
+        _notify(ChangeNotification::PRESET);
+        _commit();
+        return;
+    }
+
+    const PresetConfig preset = config().presets.items[index];
+    const uint16_t current_brightness = config().power ? _brightness() : 0;
+
+    D_PRINTF("Recall preset: %u\r\n", index);
+
+    _begin();
+    _active_preset = index;
+    config().preset = index;
+    config().power = true;
+    config().brightness = preset.brightness;
+    config().color = preset.color;
+    config().color_temperature = preset.color_temperature;
+    _request_color(ColorSource::COLOR);
+
+    if (preset.transition > 0 && _state != AppState::INITIALIZATION) {
+        _transition_from = current_brightness;
+        _transition_duration = preset.transition;
+
+        change_state(AppState::TRANSITION);
+    } else {
+        change_state(AppState::STAND_BY);
+    }
+
+    // The transition drives the brightness from the current level, only the color is loaded at once
+    if (_state == AppState::TRANSITION) _led->set_brightness(_transition_from);
+    _request_load(_state == AppState::TRANSITION);
+
+    _request_save();
+
+    // One broadcast: clients take the values from the preset list they already hold
+    _notify(ChangeNotification::PRESET);
+    _notify_implied(ChangeNotification::POWER);
+    _notify_implied(ChangeNotification::BRIGHTNESS);
+    _notify_implied(ChangeNotification::COLOR);
+    _notify_implied(ChangeNotification::COLOR_TEMPERATURE);
+    _commit();
+}
+
+void Application::save_preset(uint8_t index) {
+    if (index >= PRESET_COUNT) return;
+
+    auto &preset = config().presets.items[index];
+    preset.brightness = config().brightness;
+    preset.color = config().color;
+    preset.color_temperature = config().color_temperature;
+
+    D_PRINTF("Save preset: %u\r\n", index);
+
+    _begin();
+    _request_save();
+    _notify(ChangeNotification::PRESETS);
+    _commit();
 }
 
 uint16_t Application::_brightness() {
@@ -234,75 +768,107 @@ void Application::_app_loop() {
     ++ii;
 #endif
 
-    switch (_state) {
-        case AppState::UNINITIALIZED:
-            break;
+    const auto now = micros();
+    if (_loop_stats.last_call != 0) {
+        const uint32_t interval = now - _loop_stats.last_call;
+        const uint32_t jitter = abs((int32_t) (interval - APP_LOOP_INTERVAL * 1000));
 
-        case AppState::INITIALIZATION: {
-            if (config().power) {
-                const auto factor = map16(
-                    (millis() - _state_change_time) % sys_config().wifi_connect_flash_timeout,
-                    sys_config().wifi_connect_flash_timeout,
-                    PWM_MAX_VALUE
-                );
-
-                uint16_t brightness = _brightness() * quad_wave16(factor, PWM_MAX_VALUE) / PWM_MAX_VALUE;
-                _led->set_brightness(brightness);
-            }
-        }
-        break;
+        _loop_stats.jitter_max = std::max(_loop_stats.jitter_max, jitter);
+        _loop_stats.jitter_total += jitter;
+        ++_loop_stats.count;
+    }
 
-        case AppState::TURNING_ON: {
-            uint16_t factor = std::min<unsigned long>(PWM_MAX_VALUE,
-                (millis() - _state_change_time) * PWM_MAX_VALUE / sys_config().power_change_timeout);
-            uint16_t brightness = (uint16_t) _brightness() * ease_quad16(factor, PWM_MAX_VALUE) / PWM_MAX_VALUE;
-            _led->set_brightness(brightness);
+    _loop_stats.last_call = now;
 
-            if (factor == PWM_MAX_VALUE) change_state(AppState::STAND_BY);
-            break;
-        }
+    _process_commands();
+    _record_history();
+    _tick_zones();
 
-        case AppState::TURNING_OFF: {
-            uint16_t factor = PWM_MAX_VALUE - std::min<unsigned long>(PWM_MAX_VALUE,
-                (millis() - _state_change_time) * PWM_MAX_VALUE / sys_config().power_change_timeout);
-            uint16_t brightness = (uint16_t) _brightness() * ease_quad16(factor, PWM_MAX_VALUE) / PWM_MAX_VALUE;
-            _led->set_brightness(brightness);
+    if (_wifi_cache.handle()) {
+        _boot_timings.wifi_connected = millis();
+        D_PRINTF("WiFi connected in %lu ms\r\n", _boot_timings.wifi_connected);
+    }
 
-            if (factor == 0) change_state(AppState::STAND_BY);
-            break;
-        }
+    const bool night = _state == AppState::STAND_BY && config().power && _night_mode_manager->is_night_time();
+    const auto step = animation_step({
+        _state,
+        millis() - _state_change_time,
+        config().power,
+        _brightness(),
+        _transition_from,
+        _transition_duration,
+        sys_config().power_change_timeout,
+        sys_config().wifi_connect_flash_timeout,
+        night,
+        night ? _night_mode_manager->get_brightness() : (uint16_t) 0,
+    });
 
-        case AppState::STAND_BY:
-            if (config().power && _night_mode_manager->is_night_time()) {
-                auto brightness = _night_mode_manager->get_brightness();
-                _led->set_brightness(brightness);
-            }
-            break;
-    }
+    if (step.write) _led->set_brightness(step.brightness);
+    if (step.finished) change_state(AppState::STAND_BY);
 
-    if (_btn) _btn->handle();
+    if (_btn && _btn->pending()) {
+        // Gesture callbacks run inside, a repeat step and its notification are committed together
+        _begin();
+        _btn->handle();
+        _commit();
+    }
 }
 
 void Application::_service_loop() {
     _ntp_time->update();
-    _night_mode_manager->handle_night(*_ntp_time);
+    if (_ntp_time->available()) _night_mode_manager->handle_night(_ntp_time->epoch_tz_ms());
+
+    _memory_stats.min_free_heap = std::min<uint32_t>(_memory_stats.min_free_heap, ESP.getFreeHeap());
+
+    _feed.handle();
+}
+
+std::array<MemoryBudgetItem, MEMORY_BUDGET_ITEM_COUNT> Application::memory_budget() const {
+    return {{
+        {"total", sizeof(Application)},
+        {"bootstrap", sizeof(_bootstrap)},
+        {"metadata", sizeof(_parameters) + sizeof(_config_meta)},
+        {"api", sizeof(_api)},
+        {"zones", sizeof(_zones)},
+        {"led", sizeof(_led)},
+        {"history", sizeof(_history)},
+        {"commands", sizeof(_commands)},
+        {"timers", sizeof(_timers)},
+        {"notifications", sizeof(_notifications)},
+        {"feed", sizeof(_feed)},
+        {"ntp", sizeof(_ntp_time)},
+        {"night", sizeof(_night_mode_manager)},
+        {"button", sizeof(_btn)},
+    }};
 }
 
 void Application::_bootstrap_state_changed(void *sender, BootstrapState state, void *arg) {
     if (state == BootstrapState::INITIALIZING) {
-        _ntp_time->begin(TIME_ZONE);
+        _ntp_time->begin(sys_config().time_zone);
 
         change_state(AppState::INITIALIZATION);
         load();
     } else if (state == BootstrapState::READY && !_initialized) {
         _initialized = true;
+        _boot_timings.wifi_up = millis();
+        if (sys_config().wifi_mode == WIFI_STA_MODE) _wifi_cache.store(sys_config());
 
         change_state(AppState::STAND_BY);
         load();
 
-        _bootstrap->timer().add_interval([this](auto) {
-            _ntp_time->update();
-            _night_mode_manager->handle_night(*_ntp_time);
-        }, BOOTSTRAP_SERVICE_LOOP_INTERVAL);
+        _timers.schedule(_service_timer, BOOTSTRAP_SERVICE_LOOP_INTERVAL, BOOTSTRAP_SERVICE_LOOP_INTERVAL);
+
+        D_PRINTF("Boot finished in %lu ms\r\n", _boot_timings.wifi_up);
+
+        _memory_stats.boot_free_heap = ESP.getFreeHeap();
+        _memory_stats.min_free_heap = _memory_stats.boot_free_heap;
+
+#ifdef DEBUG
+        D_PRINTF("Memory: %u bytes free\r\n", _memory_stats.boot_free_heap);
+        D_PRINTF("Memory: parameters %u bytes, descriptors %u bytes in flash, free heap %u -> %u, %u after registering\r\n",
+            (unsigned) sizeof(ConfigParameters), (unsigned) sizeof(PropertyDescriptorTable),
+            _memory_stats.metadata_heap_before, _memory_stats.metadata_heap_after, _memory_stats.registered_heap_after);
+        for (const auto &item: memory_budget()) D_PRINTF("Memory: %-10s %6u\r\n", item.name, item.size);
+#endif
     }
 }
@@ -1,34 +1,173 @@
 #pragma once
 
+#include <array>
+#include <optional>
+
 #include "lib/bootstrap.h"
-#include "lib/misc/button.h"
-#include "lib/misc/ntp_time.h"
 
+#include "animation.h"
+#include "command.h"
 #include "config.h"
+#include "dispatch.h"
 #include "metadata.h"
+#include "zone.h"
 #include "network/api.h"
+#include "network/sntp.h"
+#include "network/wifi_cache.h"
+#include "network/ws_feed.h"
 #include "misc/night_mode.h"
+#include "misc/gesture_button.h"
+#include "misc/history.h"
 #include "misc/led.h"
+#include "misc/notification_router.h"
+#include "misc/timer_wheel.h"
+
+struct BootTimings {
+    unsigned long fs_mount = 0;
+    unsigned long config_load = 0;
+    unsigned long led_on = 0;
+    unsigned long wifi_connected = 0;  // Station associated and got an IP
+    unsigned long wifi_up = 0;         // Framework reached READY
+    unsigned long services_ready = 0;  // WebSocket, MQTT and API handlers registered
+};
+
+struct LoopStats {
+    unsigned long last_call = 0;    // us
+    uint32_t count = 0;
+    uint32_t jitter_max = 0;        // us
+    uint64_t jitter_total = 0;      // us
+    uint32_t sleep_total = 0;       // ms, event_loop() waiting for the next deadline
+
+    void reset() { count = 0; jitter_max = 0; jitter_total = 0; sleep_total = 0; }
+};
+
+// App-made changes that other clients are told about, bit positions of ChangeSet::notifications
+MAKE_ENUM_AUTO(ChangeNotification, uint8_t,
+    POWER,
+    BRIGHTNESS,
+    COLOR,
+    COLOR_16,
+    CALIBRATION,
+    CALIBRATION_16,
+    COLOR_TEMPERATURE,
+    PRESET,
+    PRESETS
+);
+
+// Which of the color representations was written last, the others are derived from it on commit
+MAKE_ENUM_AUTO(ColorSource, uint8_t,
+    NONE,
+    COLOR,              // 8-bit color and calibration
+    COLOR_16,
+    TEMPERATURE
+);
+
+// Effects of the changes made since the transaction opened, applied once by _commit()
+struct ChangeSet {
+    uint16_t notifications = 0;
+    uint16_t implied = 0;           // Derivable from another notification, only the filtered feed is told
+    ColorSource color_source = ColorSource::NONE;
+    bool load = false;              // Brightness and color
+    bool load_color = false;
+    bool save = false;
+};
+
+// Requested against performed, the difference is the work coalesced away
+struct ChangeStats {
+    uint32_t commits = 0;
+    uint32_t load_requests = 0;
+    uint32_t loads = 0;
+    uint32_t save_requests = 0;
+    uint32_t saves = 0;
+    uint32_t notify_requests = 0;
+    uint32_t notifications = 0;
+};
+
+struct MemoryBudgetItem {
+    const char *name;
+    uint32_t size;
+};
+
+struct MemoryStats {
+    uint32_t boot_free_heap = 0;    // Once the services are up
+    uint32_t min_free_heap = 0;     // Sampled by the service loop
+
+    // Free heap around creating the parameters from the descriptor table and registering them with the servers
+    uint32_t metadata_heap_before = 0;
+    uint32_t metadata_heap_after = 0;
+    uint32_t registered_heap_after = 0;
+};
+
+#define MEMORY_BUDGET_ITEM_COUNT                (14u)
 
 class Application {
-    std::unique_ptr<Bootstrap<Config, PacketType>> _bootstrap = nullptr;
-    std::unique_ptr<ConfigMetadata> _metadata = nullptr;
-    std::unique_ptr<NightModeManager> _night_mode_manager = nullptr;
-    std::unique_ptr<NtpTime> _ntp_time = nullptr;
-    std::unique_ptr<ApiWebServer> _api = nullptr;
-    std::unique_ptr<LedController> _led = nullptr;
-    std::unique_ptr<Button> _btn = nullptr;
+    // Every long-lived object is placed in the instance and constructed in begin(), the heap is left to the network
+    std::optional<Bootstrap<Config, PacketType>> _bootstrap{};
+    ConfigParameters _parameters{};
+    std::optional<AppMetaProperty<ComplexParameter<Config>>> _config_meta{};
+    std::optional<NightModeManager> _night_mode_manager{};
+    std::optional<SntpClient> _ntp_time{};
+    WifiCache _wifi_cache{};
+    std::optional<ApiWebServer> _api{};
+    WsFeedServer _feed{};
+    LedControllerSlot _led{};
+    std::optional<GestureButton> _btn{};
+
+    std::array<std::optional<Zone>, ZONE_COUNT - 1> _zones{};
+    std::array<ZonePinStatus, ZONE_COUNT - 1> _zone_pins{};  // Of the saved config, applied on restart
+    uint8_t _animating_zones = 0;   // Bit per zone, only these are ticked
+    uint8_t _night_zones = 0;       // Bit per zone following the night mode schedule
+    bool _zones_night = false;
+    uint16_t _zones_night_brightness = 0;
 
     bool _initialized = false;
+    BootTimings _boot_timings{};
+    LoopStats _loop_stats{};
+    MemoryStats _memory_stats{};
+    CommandQueue _commands{};
+    PendingProperties _pending_properties{};     // Parameters written by the servers
+
+    // App side periodic work including the app loop itself, advanced by event_loop()
+    TimerWheel _timers{};
+    WheelTimer _app_timer{[](void *arg) { ((Application *) arg)->_app_loop(); }, this};
+    WheelTimer _service_timer{[](void *arg) { ((Application *) arg)->_service_loop(); }, this};
+
+    // The only subscriber of the framework bus, every app handler is subscribed here
+    NotificationRouter _notifications{};
+    WheelTimer _notification_timer{[](void *arg) { ((Application *) arg)->_notifications.sample(); }, this};
+
+    ChangeSet _changes{};
+    ChangeStats _change_stats{};
+    uint8_t _transaction_depth = 0;
+
+    HistoryBuffer _history{};
+    uint32_t _history_values[HISTORY_EVENT_TYPE_COUNT]{};
+    bool _history_started = false;
 
     unsigned long _state_change_time = 0;
     AppState _state = AppState::UNINITIALIZED;
 
-    std::map<const AbstractParameter *, PacketType> _parameter_to_packet{};
+    uint16_t _transition_from = 0;
+    unsigned long _transition_duration = 0;
+
+    uint8_t _active_preset = 0;     // Put back when an invalid index is written to config().preset
 
 public:
     inline Config &config() { return _bootstrap->config(); }
     inline SysConfig &sys_config() { return config().sys_config; }
+    [[nodiscard]] inline const BootTimings &boot_timings() const { return _boot_timings; }
+    [[nodiscard]] inline LoopStats &loop_stats() { return _loop_stats; }
+    [[nodiscard]] inline const MemoryStats &memory_stats() const { return _memory_stats; }
+    [[nodiscard]] inline const ChangeStats &change_stats() const { return _change_stats; }
+    [[nodiscard]] inline const CommandQueue &commands() const { return _commands; }
+    [[nodiscard]] inline const TimerWheel &timers() const { return _timers; }
+    [[nodiscard]] inline const NotificationRouter &notifications() const { return _notifications; }
+    [[nodiscard]] inline const WsFeedServer &feed() const { return _feed; }
+    [[nodiscard]] inline const HistoryBuffer &history() const { return _history; }
+    [[nodiscard]] inline const SntpClient &ntp_time() const { return *_ntp_time; }
+    [[nodiscard]] inline const WifiCache &wifi_cache() const { return _wifi_cache; }
+    [[nodiscard]] inline ZonePinStatus zone_pins(uint8_t id) const { return id > 0 && id < ZONE_COUNT ? _zone_pins[id - 1] : ZonePinStatus::OK; }
+    [[nodiscard]] inline const Zone *zone(uint8_t id) const { return id > 0 && id < ZONE_COUNT && _zones[id - 1] ? &*_zones[id - 1] : nullptr; }
 
     void begin();
     void event_loop();
@@ -40,13 +179,24 @@ public:
     void brightness_decrease();
     void trigger_temperature();
 
+    void recall_preset(uint8_t index);
+    void save_preset(uint8_t index);
+
+    // Safe to call from async network callbacks, the command is executed by the app loop
+    bool submit(const Command &command);
+
     void load();
     void update();
 
-    inline void restart() { _bootstrap->restart(); }
+    // Statically placed bytes per subsystem, the first item is the whole application
+    [[nodiscard]] std::array<MemoryBudgetItem, MEMORY_BUDGET_ITEM_COUNT> memory_budget() const;
+
+    // Stamps the WiFi lease first, the next boot may reuse it
+    void restart();
 
 private:
     void _setup();
+    void _property_changed(const AbstractParameter *parameter);
 
     void _bootstrap_state_changed(void *sender, BootstrapState state, void *arg);
 
@@ -54,6 +204,32 @@ private:
     void _service_loop();
 
     uint16_t _brightness();
-
-    void _handle_property_change(const AbstractParameter *param);
+    void _load_color();
+    void _widen_color();
+    void _narrow_color();
+
+    void _handle_button_gesture(ButtonGesture gesture, uint8_t count);
+    void _run_button_action(ButtonAction action);
+
+    void _record_history();
+    size_t _answer_history(const uint8_t *request, size_t length, uint8_t *response, size_t size) const;
+
+    // Changes made between _begin() and the outermost _commit() are rendered, saved and broadcast once
+    void _begin();
+    void _commit();
+    void _request_load(bool color_only = false);
+    void _request_save();
+    void _request_color(ColorSource source);
+    void _notify(ChangeNotification notification);
+    void _notify_implied(ChangeNotification notification);
+    void _resolve_color();
+    [[nodiscard]] const AbstractParameter *_notification_parameter(ChangeNotification notification);
+
+    void _check_zone_pins();
+    void _update_zone(Zone &zone);
+    void _tick_zones();
+
+    void _process_commands();
+    void _handle_command(const Command &command);
+    void _handle_property_change(PropertyAction action);
 };
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+
+#include "lib/utils/enum.h"
+
+#include "sys_constants.h"
+#include "utils/lock_free_queue.h"
+
+MAKE_ENUM_AUTO(CommandType, uint8_t,
+    POWER,
+    BRIGHTNESS,
+    COLOR,
+    TEMPERATURE,
+    RECALL_PRESET,
+    SAVE_PRESET
+);
+
+// Fixed-size record passed from async network callbacks to the app loop.
+// Zone 0 is the main light, POWER..TEMPERATURE can address the others
+struct Command {
+    CommandType type = CommandType::POWER;
+    uint32_t value = 0;
+    uint8_t zone = 0;
+};
+
+typedef LockFreeQueue<Command, COMMAND_QUEUE_SIZE> CommandQueue;
@@ -1,8 +1,10 @@
 #pragma once
 
 #include <cstdint>
-#include <lib/network/wifi.h>
-#include <lib/utils/enum.h>
+#include "lib/network/wifi.h"
+#include "lib/utils/enum.h"
+
+#include "utils/color.h"
 
 #include "credentials.h"
 #include "constants.h"
@@ -12,7 +14,8 @@ MAKE_ENUM_AUTO(AppState, uint8_t,
     INITIALIZATION,
     STAND_BY,
     TURNING_ON,
-    TURNING_OFF
+    TURNING_OFF,
+    TRANSITION
 );
 
 enum class LedType: uint8_t {
@@ -21,6 +24,21 @@ enum class LedType: uint8_t {
     CCT    = 2,
 };
 
+MAKE_ENUM_AUTO(PwmProfile, uint8_t,
+    DEFAULT,            // PWM_RESOLUTION bits, PWM_FREQUENCY
+    HIGH_RESOLUTION,    // 16 bits (14 on ESP32-C3), 1 kHz: smoother dimming at the low end
+    HIGH_FREQUENCY      // 10 bits, 39 kHz: no flicker on camera
+);
+
+MAKE_ENUM_AUTO(ButtonAction, uint8_t,
+    NONE,
+    POWER,
+    TEMPERATURE,
+    NEXT_PRESET,
+    BRIGHTNESS_UP,
+    BRIGHTNESS_DOWN
+);
+
 typedef char ConfigString[CONFIG_STRING_SIZE];
 
 struct __attribute ((packed)) SysConfig {
@@ -33,6 +51,12 @@ struct __attribute ((packed)) SysConfig {
     uint32_t wifi_connection_check_interval = WIFI_CONNECTION_CHECK_INTERVAL;
     uint32_t wifi_max_connection_attempt_interval = WIFI_MAX_CONNECTION_ATTEMPT_INTERVAL;
 
+    // Empty IP - DHCP, empty DNS - same as the gateway
+    ConfigString wifi_static_ip{WIFI_STATIC_IP};
+    ConfigString wifi_gateway{WIFI_GATEWAY};
+    ConfigString wifi_subnet{WIFI_SUBNET};
+    ConfigString wifi_dns{WIFI_DNS};
+
     LedType led_type = LED_MODE;
     uint8_t led_r_pin = LED_R_PIN;
     uint8_t led_g_pin = LED_G_PIN;
@@ -41,6 +65,7 @@ struct __attribute ((packed)) SysConfig {
     uint16_t led_min_brightness = LED_MIN_BRIGHTNESS;
     uint16_t led_min_temperature = LED_MIN_TEMPERATURE;
     uint16_t led_max_temperature = LED_MAX_TEMPERATURE;
+    PwmProfile led_pwm_profile = LED_PWM_PROFILE;
 
     bool button_enabled = BUTTON_ENABLED;
     uint8_t button_pin = BUTTON_PIN;
@@ -72,6 +97,50 @@ struct __attribute ((packed)) NightModeConfig {
     uint16_t switch_interval = 15 * 60; // 15 minutes
 };
 
+struct __attribute ((packed)) PresetConfig {
+    uint16_t brightness = 2048;
+    uint32_t color = ~0u;
+    uint16_t color_temperature = PWM_MAX_VALUE;
+    uint32_t transition = 0;    // Brightness transition time (ms), 0 - instant
+};
+
+struct __attribute ((packed)) PresetListConfig {
+    PresetConfig items[PRESET_COUNT]{};
+};
+
+struct __attribute ((packed)) ButtonActionsConfig {
+    ButtonAction click_1 = ButtonAction::POWER;
+    ButtonAction click_2 = ButtonAction::TEMPERATURE;
+    ButtonAction click_3 = ButtonAction::NEXT_PRESET;
+    ButtonAction hold_1 = ButtonAction::BRIGHTNESS_UP;      // Repeated while held
+    ButtonAction hold_2 = ButtonAction::BRIGHTNESS_DOWN;    // Click, then hold
+};
+
+struct __attribute ((packed)) ZoneSysConfig {
+    bool enabled = false;
+    LedType led_type = LedType::SINGLE;
+    uint8_t led_r_pin = 0;      // Warm pin for CCT, the only pin for SINGLE
+    uint8_t led_g_pin = 0;      // Cold pin for CCT
+    uint8_t led_b_pin = 0;
+};
+
+struct __attribute ((packed)) ZoneState {
+    bool power = false;
+    uint16_t brightness = 2048;
+    uint32_t color = 0xffffff;
+    uint16_t color_temperature = PWM_MAX_VALUE;
+    bool night_mode = true;     // Follow the night mode schedule
+};
+
+struct __attribute ((packed)) ZoneConfig {
+    ZoneSysConfig sys_config{};
+    ZoneState state{};
+};
+
+struct __attribute ((packed)) ZoneListConfig {
+    ZoneConfig items[ZONE_COUNT - 1]{};
+};
+
 struct __attribute ((packed)) Config {
     bool power = true;
     uint16_t brightness = 2048;
@@ -84,4 +153,15 @@ struct __attribute ((packed)) Config {
     NightModeConfig night_mode{};
 
     SysConfig sys_config{};
+
+    uint8_t preset = 0;         // Last recalled preset
+    PresetListConfig presets{};
+
+    ButtonActionsConfig button_actions{};
+
+    // Full-precision counterparts of color and calibration, kept in sync with the 8-bit values
+    Rgb48 color_16 = RGB48_WHITE;
+    Rgb48 calibration_16 = RGB48_WHITE;
+
+    ZoneListConfig zones{};     // Zones 1.. ZONE_COUNT - 1
 };
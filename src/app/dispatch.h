@@ -0,0 +1,160 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include <Arduino.h>
+
+#include <lib/base/metadata.h>
+#include <lib/utils/enum.h>
+
+#include "app/config.h"
+
+MAKE_ENUM_AUTO(PropertyAction, uint8_t,
+    NONE,
+    UPDATE,
+    POWER,
+    COLOR,
+    COLOR_16,
+    TEMPERATURE,
+    NIGHT_MODE,
+    PRESET,
+    SAVE,
+    ZONE
+);
+
+// Every parameter points into Config, so the byte offset of its value is a dense index.
+// The table is built at compile time and resolves a changed parameter to its handler in O(1)
+
+typedef std::array<PropertyAction, sizeof(Config)> PropertyActionTable;
+
+struct PropertyActionRange {
+    size_t offset;
+    size_t size;
+    PropertyAction action;
+};
+
+#define PROPERTY_ACTION_MEMBER(member, action) {offsetof(Config, member), sizeof(Config::member), PropertyAction::action}
+
+// One entry per Config member in declaration order, nested structs take one action for the whole of them.
+// Every metadata parameter points into one of these, the check below fails if a member is left out
+constexpr PropertyActionRange PROPERTY_ACTION_MEMBERS[] = {
+    PROPERTY_ACTION_MEMBER(power, POWER),
+    PROPERTY_ACTION_MEMBER(brightness, UPDATE),
+    PROPERTY_ACTION_MEMBER(color, COLOR),
+    PROPERTY_ACTION_MEMBER(calibration, COLOR),
+    PROPERTY_ACTION_MEMBER(color_temperature, TEMPERATURE),
+    PROPERTY_ACTION_MEMBER(night_mode, NIGHT_MODE),
+
+    // All SysConfig parameters only need to be saved and reloaded
+    PROPERTY_ACTION_MEMBER(sys_config, UPDATE),
+
+    PROPERTY_ACTION_MEMBER(preset, PRESET),
+    PROPERTY_ACTION_MEMBER(presets, SAVE),
+
+    // Button actions are looked up on every gesture, persisting is enough
+    PROPERTY_ACTION_MEMBER(button_actions, SAVE),
+
+    PROPERTY_ACTION_MEMBER(color_16, COLOR_16),
+    PROPERTY_ACTION_MEMBER(calibration_16, COLOR_16),
+
+    // Zone pins are applied on restart, state changes go to the zone itself, see below
+    PROPERTY_ACTION_MEMBER(zones, SAVE),
+};
+
+#undef PROPERTY_ACTION_MEMBER
+
+constexpr bool _property_action_members_cover_config() {
+    size_t next = 0;
+    for (const auto &range: PROPERTY_ACTION_MEMBERS) {
+        if (range.offset != next || range.action == PropertyAction::NONE) return false;
+        next += range.size;
+    }
+
+    return next == sizeof(Config);
+}
+
+static_assert(_property_action_members_cover_config(),
+    "Every Config member needs an entry in PROPERTY_ACTION_MEMBERS, in declaration order");
+
+constexpr void _set_action_range(PropertyActionTable &table, size_t offset, size_t size, PropertyAction action) {
+    for (size_t i = offset; i < offset + size; ++i) table[i] = action;
+}
+
+constexpr PropertyActionTable build_property_action_table() {
+    PropertyActionTable table{};
+    for (const auto &range: PROPERTY_ACTION_MEMBERS) _set_action_range(table, range.offset, range.size, range.action);
+
+    for (size_t i = 0; i < ZONE_COUNT - 1; ++i) {
+        _set_action_range(table, offsetof(Config, zones) + i * sizeof(ZoneConfig) + offsetof(ZoneConfig, state),
+            sizeof(ZoneState), PropertyAction::ZONE);
+    }
+
+    return table;
+}
+
+extern const PropertyActionTable PROPERTY_ACTION_TABLE;
+
+inline PropertyAction property_action(const Config &config, const AbstractParameter *parameter) {
+    const auto begin = (uintptr_t) &config;
+    const auto value = (uintptr_t) parameter->get_value();
+    if (value < begin || value - begin >= sizeof(Config)) return PropertyAction::NONE;
+
+    return (PropertyAction) pgm_read_byte(&PROPERTY_ACTION_TABLE[value - begin]);
+}
+
+// Number of the zone the parameter belongs to, 0 for the main light
+inline uint8_t property_zone(const Config &config, const AbstractParameter *parameter) {
+    const auto offset = (uintptr_t) parameter->get_value() - (uintptr_t) &config.zones;
+    if (offset >= sizeof(ZoneListConfig)) return 0;
+
+    return offset / sizeof(ZoneConfig) + 1;
+}
+
+// Property changes waiting for the app loop: a bit per action, and a bit per zone for ZONE.
+// Repeated changes merge into the same bit, so unlike the command queue the set can't overflow
+class PendingProperties {
+    static constexpr uint8_t ZONE_SHIFT = 16;
+    static_assert((uint8_t) PropertyAction::ZONE < ZONE_SHIFT && ZONE_SHIFT + ZONE_COUNT <= 32,
+        "Pending bits don't fit");
+
+    // The color is derived from whichever of these changed last
+    static constexpr uint32_t COLOR_SOURCES = 1u << (uint8_t) PropertyAction::COLOR
+                                              | 1u << (uint8_t) PropertyAction::COLOR_16
+                                              | 1u << (uint8_t) PropertyAction::TEMPERATURE;
+
+    std::atomic<uint32_t> _bits{0};
+
+public:
+    // Safe to call from async network callbacks
+    void add(PropertyAction action, uint8_t zone = 0) {
+        if (action == PropertyAction::NONE) return;
+
+        uint32_t bits = 1u << (uint8_t) action;
+        if (action == PropertyAction::ZONE) bits = 1u << (ZONE_SHIFT + zone);
+
+        const uint32_t replaced = bits & COLOR_SOURCES ? COLOR_SOURCES : 0;
+
+        uint32_t pending = _bits.load(std::memory_order_relaxed);
+        while (!_bits.compare_exchange_weak(pending, (pending & ~replaced) | bits,
+                                            std::memory_order_release, std::memory_order_relaxed)) {}
+    }
+
+    // Takes every pending change, calls action(PropertyAction) and then zone(uint8_t) for each
+    template<typename ActionFn, typename ZoneFn>
+    bool take(ActionFn &&action, ZoneFn &&zone) {
+        const uint32_t bits = _bits.exchange(0, std::memory_order_acquire);
+
+        for (uint32_t mask = bits & ((1u << ZONE_SHIFT) - 1); mask; mask &= mask - 1) {
+            action((PropertyAction) __builtin_ctz(mask));
+        }
+
+        for (uint32_t mask = bits >> ZONE_SHIFT; mask; mask &= mask - 1) zone((uint8_t) __builtin_ctz(mask));
+
+        return bits != 0;
+    }
+
+    [[nodiscard]] inline bool empty() const { return _bits.load(std::memory_order_relaxed) == 0; }
+};
@@ -0,0 +1,72 @@
+#include "metadata.h"
+
+#include <type_traits>
+
+const PropertyDescriptorTable PROPERTY_DESCRIPTORS PROGMEM = build_property_descriptors();
+
+AbstractParameter &ConfigParameterSlot::create(const PropertyDescriptor &property, Config &config) {
+    auto value = (uint8_t *) &config + property.offset;
+
+    switch (property.kind) {
+        case PropertyKind::BOOL:
+            _storage.emplace<Parameter<bool>>((bool *) value);
+            break;
+
+        case PropertyKind::NUMERIC_BOOL:
+            _storage.emplace<NumericParameter<bool>>((bool *) value);
+            break;
+
+        case PropertyKind::UINT8:
+            _storage.emplace<Parameter<uint8_t>>(value);
+            break;
+
+        case PropertyKind::NUMERIC_UINT8:
+            _storage.emplace<NumericParameter<uint8_t>>(value);
+            break;
+
+        case PropertyKind::UINT16:
+            _storage.emplace<Parameter<uint16_t>>((uint16_t *) value);
+            break;
+
+        case PropertyKind::UINT32:
+            _storage.emplace<Parameter<uint32_t>>((uint32_t *) value);
+            break;
+
+        case PropertyKind::NUMERIC_UINT32:
+            _storage.emplace<NumericParameter<uint32_t>>((uint32_t *) value);
+            break;
+
+        case PropertyKind::FLOAT:
+            _storage.emplace<Parameter<float>>((float *) value);
+            break;
+
+        case PropertyKind::STRING:
+            _storage.emplace<FixedString>((char *) value, (size_t) property.size);
+            break;
+
+        case PropertyKind::BRIGHTNESS:
+            _storage.emplace<BrightnessParameter>((uint16_t *) value, config.sys_config);
+            break;
+
+        case PropertyKind::TEMPERATURE:
+            _storage.emplace<TemperatureParameter>((uint16_t *) value, config.sys_config);
+            break;
+
+        case PropertyKind::RGB48:
+            _storage.emplace<ComplexParameter<Rgb48>>((Rgb48 *) value);
+            break;
+
+        case PropertyKind::PRESET_LIST:
+            _storage.emplace<ComplexParameter<PresetListConfig>>((PresetListConfig *) value);
+            break;
+    }
+
+    return *get();
+}
+
+AbstractParameter *ConfigParameterSlot::get() {
+    return std::visit([](auto &parameter) -> AbstractParameter * {
+        if constexpr (std::is_same_v<std::decay_t<decltype(parameter)>, std::monostate>) return nullptr;
+        else return &parameter;
+    }, _storage);
+}
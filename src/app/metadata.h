@@ -1,5 +1,11 @@
 #pragma once
 
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <variant>
+
 #include <lib/base/metadata.h>
 #include <lib/utils/metadata.h>
 
@@ -7,230 +13,198 @@
 #include "app/parameters.h"
 #include "network/cmd.h"
 
-
 DECLARE_META_TYPE(AppMetaProperty, PacketType)
 
-DECLARE_META(NightModeConfigMeta, AppMetaProperty,
-    MEMBER(Parameter<bool>, enabled),
-    MEMBER(Parameter<uint16_t>, brightness),
-    MEMBER(Parameter<uint32_t>, start_time),
-    MEMBER(Parameter<uint32_t>, end_time),
-    MEMBER(Parameter<uint16_t>, switch_interval)
-)
-
-DECLARE_META(SysConfigMeta, AppMetaProperty,
-    MEMBER(FixedString, mdns_name),
-    MEMBER(Parameter<uint8_t>, wifi_mode),
-    MEMBER(FixedString, wifi_ssid),
-    MEMBER(FixedString, wifi_password),
-    MEMBER(Parameter<uint32_t>, wifi_connection_check_interval),
-    MEMBER(Parameter<uint32_t>, wifi_max_connection_attempt_interval),
-    MEMBER(Parameter<uint8_t>, led_type),
-    MEMBER(Parameter<uint8_t>, led_r_pin),
-    MEMBER(Parameter<uint8_t>, led_g_pin),
-    MEMBER(Parameter<uint8_t>, led_b_pin),
-    MEMBER(Parameter<uint16_t>, led_min_brightness),
-    MEMBER(Parameter<uint16_t>, led_min_temperature),
-    MEMBER(Parameter<uint16_t>, led_max_temperature),
-    MEMBER(Parameter<bool>, button_enabled),
-    MEMBER(Parameter<uint8_t>, button_pin),
-    MEMBER(Parameter<bool>, button_high_state),
-    MEMBER(Parameter<uint32_t>, power_change_timeout),
-    MEMBER(Parameter<uint32_t>, wifi_connect_flash_timeout),
-    MEMBER(Parameter<float>, time_zone),
-    MEMBER(Parameter<bool>, web_auth),
-    MEMBER(FixedString, web_auth_user),
-    MEMBER(FixedString, web_auth_password),
-    MEMBER(Parameter<bool>, mqtt),
-    MEMBER(FixedString, mqtt_host),
-    MEMBER(Parameter<uint16_t>, mqtt_port),
-    MEMBER(FixedString, mqtt_user),
-    MEMBER(FixedString, mqtt_password),
-    MEMBER(Parameter<bool>, mqtt_convert_brightness)
-)
-
-DECLARE_META(DataConfigMeta, AppMetaProperty,
-    MEMBER(ComplexParameter<Config>, config),
-)
-
-DECLARE_META(ConfigMetadata, AppMetaProperty,
-    MEMBER(Parameter<bool>, power),
-    MEMBER(BrightnessParameter, brightness),
-    MEMBER(Parameter<uint32_t>, color),
-    MEMBER(Parameter<uint32_t>, calibration),
-    MEMBER(TemperatureParameter, color_temperature),
-    SUB_TYPE(NightModeConfigMeta, night_mode),
-    SUB_TYPE(SysConfigMeta, sys_config),
-
-    SUB_TYPE(DataConfigMeta, data),
-)
-
-inline ConfigMetadata build_metadata(Config &config) {
-    return {
-        .power = {
-            PacketType::POWER,
-            MQTT_TOPIC_POWER, MQTT_OUT_TOPIC_POWER,
-            &config.power
-        },
-        .brightness = {
-            PacketType::BRIGHTNESS,
-            MQTT_TOPIC_BRIGHTNESS, MQTT_OUT_TOPIC_BRIGHTNESS,
-            {&config.brightness, config.sys_config}
-        },
-        .color = {
-            PacketType::COLOR,
-            MQTT_TOPIC_COLOR, MQTT_OUT_TOPIC_COLOR,
-            &config.color
-        },
-        .calibration = {
-            PacketType::CALIBRATION,
-            &config.calibration
-        },
-        .color_temperature = {
-            PacketType::TEMPERATURE,
-            MQTT_TOPIC_TEMPERATURE,MQTT_OUT_TOPIC_TEMPERATURE,
-            {&config.color_temperature, config.sys_config}
-        },
-        .night_mode = {
-            .enabled = {
-                PacketType::NIGHT_MODE_ENABLED,
-                MQTT_TOPIC_NIGHT_MODE, MQTT_OUT_TOPIC_NIGHT_MODE,
-                &config.night_mode.enabled
-            },
-            .brightness = {
-                PacketType::NIGHT_MODE_BRIGHTNESS,
-                &config.night_mode.brightness
-            },
-            .start_time = {
-                PacketType::NIGHT_MODE_START,
-                &config.night_mode.start_time
-            },
-            .end_time = {
-                PacketType::NIGHT_MODE_END,
-                &config.night_mode.end_time
-            },
-            .switch_interval = {
-                PacketType::NIGHT_MODE_INTERVAL,
-                &config.night_mode.switch_interval
-            }
-        },
-        .sys_config = {
-            .mdns_name = {
-                PacketType::SYS_CONFIG_MDNS_NAME,
-                {config.sys_config.mdns_name, CONFIG_STRING_SIZE}
-            },
-            .wifi_mode = {
-                PacketType::SYS_CONFIG_WIFI_MODE,
-                (uint8_t *) &config.sys_config.wifi_mode
-            },
-            .wifi_ssid = {
-                PacketType::SYS_CONFIG_WIFI_SSID,
-                {config.sys_config.wifi_ssid, CONFIG_STRING_SIZE}
-            },
-            .wifi_password = {
-                PacketType::SYS_CONFIG_WIFI_PASSWORD,
-                {config.sys_config.wifi_password, CONFIG_STRING_SIZE}
-            },
-            .wifi_connection_check_interval = {
-                PacketType::SYS_CONFIG_WIFI_CONNECTION_CHECK_INTERVAL,
-                &config.sys_config.wifi_connection_check_interval
-            },
-            .wifi_max_connection_attempt_interval = {
-                PacketType::SYS_CONFIG_WIFI_MAX_CONNECTION_ATTEMPT_INTERVAL,
-                &config.sys_config.wifi_max_connection_attempt_interval
-            },
-            .led_type = {
-                PacketType::SYS_LED_TYPE,
-                (uint8_t *) &config.sys_config.led_type
-            },
-            .led_r_pin = {
-                PacketType::SYS_CONFIG_LED_R_PIN,
-                &config.sys_config.led_r_pin
-            },
-            .led_g_pin = {
-                PacketType::SYS_CONFIG_LED_G_PIN,
-                &config.sys_config.led_g_pin
-            },
-            .led_b_pin = {
-                PacketType::SYS_CONFIG_LED_B_PIN,
-                &config.sys_config.led_b_pin
-            },
-            .led_min_brightness = {
-                PacketType::SYS_CONFIG_LED_MIN_BRIGHTNESS,
-                &config.sys_config.led_min_brightness
-            },
-            .led_min_temperature = {
-                PacketType::SYS_CONFIG_LED_MIN_TEMPERATURE,
-                &config.sys_config.led_min_temperature
-            },
-            .led_max_temperature = {
-                PacketType::SYS_CONFIG_LED_MAX_TEMPERATURE,
-                &config.sys_config.led_max_temperature
-            },
-            .button_enabled = {
-                PacketType::SYS_CONFIG_BUTTON_ENABLED,
-                &config.sys_config.button_enabled
-            },
-            .button_pin = {
-                PacketType::SYS_CONFIG_BUTTON_PIN,
-                &config.sys_config.button_pin
-            },
-            .button_high_state = {
-                PacketType::SYS_CONFIG_BUTTON_HIGH_STATE,
-                &config.sys_config.button_high_state
-            },
-            .power_change_timeout = {
-                PacketType::SYS_CONFIG_POWER_CHANGE_TIMEOUT,
-                &config.sys_config.power_change_timeout
-            },
-            .wifi_connect_flash_timeout = {
-                PacketType::SYS_CONFIG_WIFI_CONNECT_FLASH_TIMEOUT,
-                &config.sys_config.wifi_connect_flash_timeout
-            },
-            .time_zone = {
-                PacketType::SYS_CONFIG_TIME_ZONE,
-                &config.sys_config.time_zone
-            },
-            .web_auth = {
-                PacketType::SYS_CONFIG_WEB_AUTH_ENABLED,
-                &config.sys_config.web_auth
-            },
-            .web_auth_user = {
-                PacketType::SYS_CONFIG_WEB_AUTH_USER,
-                {config.sys_config.web_auth_user, CONFIG_STRING_SIZE}
-            },
-            .web_auth_password = {
-                PacketType::SYS_CONFIG_WEB_AUTH_PASSWORD,
-                {config.sys_config.web_auth_password, CONFIG_STRING_SIZE}
-            },
-            .mqtt = {
-                PacketType::SYS_CONFIG_MQTT_ENABLED,
-                &config.sys_config.mqtt
-            },
-            .mqtt_host = {
-                PacketType::SYS_CONFIG_MQTT_HOST,
-                {config.sys_config.mqtt_host, CONFIG_STRING_SIZE}
-            },
-            .mqtt_port = {
-                PacketType::SYS_CONFIG_MQTT_PORT,
-                &config.sys_config.mqtt_port
-            },
-            .mqtt_user = {
-                PacketType::SYS_CONFIG_MQTT_USER,
-                {config.sys_config.mqtt_user, CONFIG_STRING_SIZE}
-            },
-            .mqtt_password = {
-                PacketType::SYS_CONFIG_MQTT_PASSWORD,
-                {config.sys_config.mqtt_password, CONFIG_STRING_SIZE}
-            },
-            .mqtt_convert_brightness = {
-                PacketType::SYS_CONFIG_MQTT_CONVERT_BRIGHTNESS,
-                &config.sys_config.mqtt_convert_brightness
-            }
-        },
-
-        .data{
-            .config = ComplexParameter(&config),
-        },
-    };
+// Leaf properties of Config exposed to the servers, each gets a notification topic
+#define METADATA_PROPERTY_COUNT                 (52u)
+
+// Parameter class built for a property, see ConfigParameterSlot
+enum class PropertyKind: uint8_t {
+    BOOL,
+    NUMERIC_BOOL,           // Plain number over MQTT
+    UINT8,
+    NUMERIC_UINT8,
+    UINT16,
+    UINT32,
+    NUMERIC_UINT32,
+    FLOAT,
+    STRING,                 // ConfigString
+    BRIGHTNESS,             // Percent over MQTT if mqtt_convert_brightness is set
+    TEMPERATURE,            // Kelvin over MQTT
+    RGB48,
+    PRESET_LIST,
+};
+
+// Everything the servers need to know about a property, kept in flash and read once at setup
+struct PropertyDescriptor {
+    uint16_t offset;        // Of the value in Config
+    uint16_t size;
+    PropertyKind kind;
+    PacketType packet_type;
+    const char *topic_in;   // nullptr if not controlled over MQTT
+    const char *topic_out;  // nullptr if not published over MQTT
+};
+
+typedef std::array<PropertyDescriptor, METADATA_PROPERTY_COUNT> PropertyDescriptorTable;
+
+#define CONFIG_PROPERTY(kind, member, packet_type, ...) \
+    PropertyDescriptor{offsetof(Config, member), sizeof(std::declval<Config>().member), PropertyKind::kind, \
+        PacketType::packet_type, __VA_ARGS__}
+
+// The first properties in table order, looked up by the app to announce its own changes
+enum class ConfigProperty: uint8_t {
+    POWER,
+    BRIGHTNESS,
+    COLOR,
+    CALIBRATION,
+    COLOR_TEMPERATURE,
+    COLOR_16,
+    CALIBRATION_16,
+    PRESET,
+    PRESETS,
+};
+
+constexpr PropertyDescriptorTable build_property_descriptors() {
+    return {{
+        CONFIG_PROPERTY(NUMERIC_BOOL, power, POWER, MQTT_TOPIC_POWER, MQTT_OUT_TOPIC_POWER),
+        CONFIG_PROPERTY(BRIGHTNESS, brightness, BRIGHTNESS, MQTT_TOPIC_BRIGHTNESS, MQTT_OUT_TOPIC_BRIGHTNESS),
+        CONFIG_PROPERTY(NUMERIC_UINT32, color, COLOR, MQTT_TOPIC_COLOR, MQTT_OUT_TOPIC_COLOR),
+        CONFIG_PROPERTY(UINT32, calibration, CALIBRATION),
+        CONFIG_PROPERTY(TEMPERATURE, color_temperature, TEMPERATURE, MQTT_TOPIC_TEMPERATURE, MQTT_OUT_TOPIC_TEMPERATURE),
+        CONFIG_PROPERTY(RGB48, color_16, COLOR_16),
+        CONFIG_PROPERTY(RGB48, calibration_16, CALIBRATION_16),
+        CONFIG_PROPERTY(NUMERIC_UINT8, preset, PRESET, MQTT_TOPIC_PRESET, MQTT_OUT_TOPIC_PRESET),
+        CONFIG_PROPERTY(PRESET_LIST, presets, PRESET_LIST),
+
+        CONFIG_PROPERTY(NUMERIC_BOOL, night_mode.enabled, NIGHT_MODE_ENABLED, MQTT_TOPIC_NIGHT_MODE, MQTT_OUT_TOPIC_NIGHT_MODE),
+        CONFIG_PROPERTY(UINT16, night_mode.brightness, NIGHT_MODE_BRIGHTNESS),
+        CONFIG_PROPERTY(UINT32, night_mode.start_time, NIGHT_MODE_START),
+        CONFIG_PROPERTY(UINT32, night_mode.end_time, NIGHT_MODE_END),
+        CONFIG_PROPERTY(UINT16, night_mode.switch_interval, NIGHT_MODE_INTERVAL),
+
+        CONFIG_PROPERTY(STRING, sys_config.mdns_name, SYS_CONFIG_MDNS_NAME),
+        CONFIG_PROPERTY(UINT8, sys_config.wifi_mode, SYS_CONFIG_WIFI_MODE),
+        CONFIG_PROPERTY(STRING, sys_config.wifi_ssid, SYS_CONFIG_WIFI_SSID),
+        CONFIG_PROPERTY(STRING, sys_config.wifi_password, SYS_CONFIG_WIFI_PASSWORD),
+        CONFIG_PROPERTY(UINT32, sys_config.wifi_connection_check_interval, SYS_CONFIG_WIFI_CONNECTION_CHECK_INTERVAL),
+        CONFIG_PROPERTY(UINT32, sys_config.wifi_max_connection_attempt_interval, SYS_CONFIG_WIFI_MAX_CONNECTION_ATTEMPT_INTERVAL),
+        CONFIG_PROPERTY(STRING, sys_config.wifi_static_ip, SYS_CONFIG_WIFI_STATIC_IP),
+        CONFIG_PROPERTY(STRING, sys_config.wifi_gateway, SYS_CONFIG_WIFI_GATEWAY),
+        CONFIG_PROPERTY(STRING, sys_config.wifi_subnet, SYS_CONFIG_WIFI_SUBNET),
+        CONFIG_PROPERTY(STRING, sys_config.wifi_dns, SYS_CONFIG_WIFI_DNS),
+        CONFIG_PROPERTY(UINT8, sys_config.led_type, SYS_LED_TYPE),
+        CONFIG_PROPERTY(UINT8, sys_config.led_r_pin, SYS_CONFIG_LED_R_PIN),
+        CONFIG_PROPERTY(UINT8, sys_config.led_g_pin, SYS_CONFIG_LED_G_PIN),
+        CONFIG_PROPERTY(UINT8, sys_config.led_b_pin, SYS_CONFIG_LED_B_PIN),
+        CONFIG_PROPERTY(UINT16, sys_config.led_min_brightness, SYS_CONFIG_LED_MIN_BRIGHTNESS),
+        CONFIG_PROPERTY(UINT16, sys_config.led_min_temperature, SYS_CONFIG_LED_MIN_TEMPERATURE),
+        CONFIG_PROPERTY(UINT16, sys_config.led_max_temperature, SYS_CONFIG_LED_MAX_TEMPERATURE),
+        CONFIG_PROPERTY(UINT8, sys_config.led_pwm_profile, SYS_CONFIG_LED_PWM_PROFILE),
+        CONFIG_PROPERTY(BOOL, sys_config.button_enabled, SYS_CONFIG_BUTTON_ENABLED),
+        CONFIG_PROPERTY(UINT8, sys_config.button_pin, SYS_CONFIG_BUTTON_PIN),
+        CONFIG_PROPERTY(BOOL, sys_config.button_high_state, SYS_CONFIG_BUTTON_HIGH_STATE),
+        CONFIG_PROPERTY(UINT32, sys_config.power_change_timeout, SYS_CONFIG_POWER_CHANGE_TIMEOUT),
+        CONFIG_PROPERTY(UINT32, sys_config.wifi_connect_flash_timeout, SYS_CONFIG_WIFI_CONNECT_FLASH_TIMEOUT),
+        CONFIG_PROPERTY(FLOAT, sys_config.time_zone, SYS_CONFIG_TIME_ZONE),
+        CONFIG_PROPERTY(BOOL, sys_config.web_auth, SYS_CONFIG_WEB_AUTH_ENABLED),
+        CONFIG_PROPERTY(STRING, sys_config.web_auth_user, SYS_CONFIG_WEB_AUTH_USER),
+        CONFIG_PROPERTY(STRING, sys_config.web_auth_password, SYS_CONFIG_WEB_AUTH_PASSWORD),
+        CONFIG_PROPERTY(BOOL, sys_config.mqtt, SYS_CONFIG_MQTT_ENABLED),
+        CONFIG_PROPERTY(STRING, sys_config.mqtt_host, SYS_CONFIG_MQTT_HOST),
+        CONFIG_PROPERTY(UINT16, sys_config.mqtt_port, SYS_CONFIG_MQTT_PORT),
+        CONFIG_PROPERTY(STRING, sys_config.mqtt_user, SYS_CONFIG_MQTT_USER),
+        CONFIG_PROPERTY(STRING, sys_config.mqtt_password, SYS_CONFIG_MQTT_PASSWORD),
+        CONFIG_PROPERTY(BOOL, sys_config.mqtt_convert_brightness, SYS_CONFIG_MQTT_CONVERT_BRIGHTNESS),
+
+        CONFIG_PROPERTY(UINT8, button_actions.click_1, BUTTON_ACTION_CLICK_1),
+        CONFIG_PROPERTY(UINT8, button_actions.click_2, BUTTON_ACTION_CLICK_2),
+        CONFIG_PROPERTY(UINT8, button_actions.click_3, BUTTON_ACTION_CLICK_3),
+        CONFIG_PROPERTY(UINT8, button_actions.hold_1, BUTTON_ACTION_HOLD_1),
+        CONFIG_PROPERTY(UINT8, button_actions.hold_2, BUTTON_ACTION_HOLD_2),
+    }};
+}
+
+#undef CONFIG_PROPERTY
+
+extern const PropertyDescriptorTable PROPERTY_DESCRIPTORS;
+
+constexpr size_t property_kind_size(PropertyKind kind) {
+    switch (kind) {
+        case PropertyKind::BOOL:
+        case PropertyKind::NUMERIC_BOOL: return sizeof(bool);
+        case PropertyKind::UINT8:
+        case PropertyKind::NUMERIC_UINT8: return sizeof(uint8_t);
+        case PropertyKind::UINT16:
+        case PropertyKind::BRIGHTNESS:
+        case PropertyKind::TEMPERATURE: return sizeof(uint16_t);
+        case PropertyKind::UINT32:
+        case PropertyKind::NUMERIC_UINT32: return sizeof(uint32_t);
+        case PropertyKind::FLOAT: return sizeof(float);
+        case PropertyKind::STRING: return sizeof(ConfigString);
+        case PropertyKind::RGB48: return sizeof(Rgb48);
+        case PropertyKind::PRESET_LIST: return sizeof(PresetListConfig);
+    }
+
+    return 0;
+}
+
+// A member of the wrong type would be read through a parameter of another size
+constexpr bool _property_descriptors_match_config() {
+    for (const auto &property: build_property_descriptors()) {
+        if (property.size != property_kind_size(property.kind) || property.offset + property.size > sizeof(Config)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static_assert(_property_descriptors_match_config(), "Property kind doesn't match the size of its Config member");
+
+constexpr bool _config_property_is(ConfigProperty property, size_t offset) {
+    return build_property_descriptors()[(uint8_t) property].offset == offset;
+}
+
+static_assert(_config_property_is(ConfigProperty::POWER, offsetof(Config, power))
+              && _config_property_is(ConfigProperty::COLOR_TEMPERATURE, offsetof(Config, color_temperature))
+              && _config_property_is(ConfigProperty::PRESETS, offsetof(Config, presets)),
+    "ConfigProperty is out of the table order");
+
+// Storage for the parameter of one property, constructed in place from its descriptor
+class ConfigParameterSlot {
+    std::variant<std::monostate, Parameter<bool>, NumericParameter<bool>, Parameter<uint8_t>, NumericParameter<uint8_t>,
+                 Parameter<uint16_t>, Parameter<uint32_t>, NumericParameter<uint32_t>, Parameter<float>, FixedString,
+                 BrightnessParameter, TemperatureParameter, ComplexParameter<Rgb48>,
+                 ComplexParameter<PresetListConfig>> _storage{};
+
+public:
+    AbstractParameter &create(const PropertyDescriptor &property, Config &config);
+
+    // nullptr until created
+    [[nodiscard]] AbstractParameter *get();
+};
+
+// The live parameters the servers keep pointers to. Nothing but the parameters themselves stays in RAM:
+// packet types, topics and offsets are read from PROPERTY_DESCRIPTORS
+class ConfigParameters {
+    std::array<ConfigParameterSlot, METADATA_PROPERTY_COUNT> _slots{};
+
+public:
+    // Walks the descriptor table, calls fn(const PropertyDescriptor &, AbstractParameter *) for every property
+    template<typename Fn>
+    void create(Config &config, Fn &&fn);
+
+    [[nodiscard]] inline AbstractParameter *get(ConfigProperty property) {
+        return _slots[(uint8_t) property].get();
+    }
+};
+
+template<typename Fn>
+void ConfigParameters::create(Config &config, Fn &&fn) {
+    for (size_t i = 0; i < METADATA_PROPERTY_COUNT; ++i) {
+        PropertyDescriptor property;
+        memcpy_P(&property, &PROPERTY_DESCRIPTORS[i], sizeof(property));
+
+        fn(property, &_slots[i].create(property, config));
+    }
 }
@@ -4,34 +4,66 @@
 
 #include "app/config.h"
 #include "utils/math.h"
+#include "utils/parse.h"
 
-class BrightnessParameter : public Parameter<uint16_t> {
+// Text (MQTT) representation of a plain numeric parameter, parsed and formatted without intermediate allocations
+template<typename T>
+class NumericParameter : public Parameter<T> {
+public:
+    NumericParameter(T *value) : Parameter<T>(value) {}
+
+    bool parse(const String &data) override {
+        T value;
+        if (!parse_int<T>(data.c_str(), data.length(), value)) return false;
+
+        Parameter<T>::set_value(&value, sizeof(value));
+        return true;
+    }
+
+    [[nodiscard]] String to_string() const override {
+        T value;
+        memcpy(&value, Parameter<T>::get_value(), sizeof(value));
+
+        char buffer[24];
+        format_int(buffer, sizeof(buffer), value);
+        return buffer;
+    }
+};
+
+class BrightnessParameter : public NumericParameter<uint16_t> {
     const SysConfig &_config;
 
 public:
-    BrightnessParameter(uint16_t *value, const SysConfig &config) : Parameter(value), _config(config) {}
+    BrightnessParameter(uint16_t *value, const SysConfig &config) : NumericParameter(value), _config(config) {}
 
     bool parse(const String &data) override {
         if (_config.mqtt_convert_brightness) {
-            if (data.length() == 0) return false;
+            uint16_t percent;
+            if (!parse_int<uint16_t>(data.c_str(), data.length(), percent, 0, 100)) return false;
 
-            uint16_t value = map16(data.toInt(), 100, PWM_MAX_VALUE);
+            uint16_t value = map16(percent, 100, PWM_MAX_VALUE);
             Parameter::set_value(&value, sizeof(value));
             return true;
         }
 
-        return Parameter::parse(data);
+        uint16_t value;
+        if (!parse_int<uint16_t>(data.c_str(), data.length(), value, 0, PWM_MAX_VALUE)) return false;
+
+        Parameter::set_value(&value, sizeof(value));
+        return true;
     }
 
     [[nodiscard]] String to_string() const override {
         if (_config.mqtt_convert_brightness) {
             uint16_t value;
             memcpy(&value, Parameter::get_value(), sizeof(value));
-            auto converted = map16(value, PWM_MAX_VALUE, 100);
-            return String(converted);
+
+            char buffer[8];
+            format_int(buffer, sizeof(buffer), map16(value, PWM_MAX_VALUE, 100));
+            return buffer;
         }
 
-        return Parameter::to_string();
+        return NumericParameter::to_string();
     }
 };
 
@@ -42,10 +74,13 @@ public:
     TemperatureParameter(uint16_t *value, const SysConfig &config) : Parameter(value), _config(config) {}
 
     bool parse(const String &data) override {
-        if (data.length() == 0) return false;
+        uint16_t kelvin;
+        if (!parse_int<uint16_t>(data.c_str(), data.length(), kelvin)) return false;
 
-        auto parsed = std::max<uint16_t>(data.toInt() - _config.led_min_temperature, 0);
-        uint16_t value = map16(parsed, _config.led_max_temperature - _config.led_min_temperature, LED_TEMPERATURE_MAX_VALUE);
+        kelvin = std::max(_config.led_min_temperature, std::min(_config.led_max_temperature, kelvin));
+
+        uint16_t value = map16(kelvin - _config.led_min_temperature,
+            _config.led_max_temperature - _config.led_min_temperature, LED_TEMPERATURE_MAX_VALUE);
         Parameter::set_value(&value, sizeof(value));
         return true;
     }
@@ -55,6 +90,9 @@ public:
         memcpy(&value, Parameter::get_value(), sizeof(value));
         auto converted = _config.led_min_temperature + map16(value, LED_TEMPERATURE_MAX_VALUE,
             _config.led_max_temperature - _config.led_min_temperature);
-        return String(converted);
+
+        char buffer[8];
+        format_int(buffer, sizeof(buffer), converted);
+        return buffer;
     }
 };
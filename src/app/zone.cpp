@@ -0,0 +1,203 @@
+#include "zone.h"
+
+#include <algorithm>
+#include <iterator>
+
+#include <Arduino.h>
+#include "lib/bootstrap.h"
+
+#include "utils/color.h"
+#include "utils/math.h"
+
+static constexpr const char *ZONE_TOPIC_NAMES[ZONE_TOPIC_COUNT] = {"power", "brightness", "color", "temperature"};
+
+Zone::Zone(uint8_t id, void *sender, ZoneConfig &config, const SysConfig &sys_config) :
+    _id(id), _sender(sender), _config(config), _sys_config(sys_config),
+    _power_parameter(&config.state.power),
+    _brightness_parameter(&config.state.brightness, sys_config),
+    _color_parameter(&config.state.color),
+    _temperature_parameter(&config.state.color_temperature, sys_config),
+    _state_parameter(&config.state),
+    _config_parameter(&config.sys_config) {
+
+    for (size_t i = 0; i < std::size(ZONE_TOPIC_NAMES); ++i) {
+        snprintf(_topics[i * 2], ZONE_TOPIC_SIZE, MQTT_PREFIX "/zone%u/%s", _id, ZONE_TOPIC_NAMES[i]);
+        snprintf(_topics[i * 2 + 1], ZONE_TOPIC_SIZE, MQTT_OUT_PREFIX "/zone%u/%s", _id, ZONE_TOPIC_NAMES[i]);
+    }
+}
+
+static uint8_t _led_pins(LedType led_type, uint8_t r_pin, uint8_t g_pin, uint8_t b_pin, uint8_t *pins) {
+    pins[0] = r_pin;
+    pins[1] = g_pin;
+    pins[2] = b_pin;
+
+    switch (led_type) {
+        case LedType::RGB: return 3;
+        case LedType::CCT: return 2;
+        default: return 1;
+    }
+}
+
+std::array<ZonePinStatus, ZONE_COUNT - 1> check_zone_pins(const Config &config) {
+    std::array<ZonePinStatus, ZONE_COUNT - 1> result{};
+    const auto &sys_config = config.sys_config;
+
+    // Every LED pin and the button
+    uint8_t used[3 * ZONE_COUNT + 1];
+    uint8_t used_count = _led_pins(sys_config.led_type, sys_config.led_r_pin, sys_config.led_g_pin,
+        sys_config.led_b_pin, used);
+
+    uint8_t channels = used_count;
+    if (sys_config.button_enabled) used[used_count++] = sys_config.button_pin;
+
+    for (uint8_t i = 0; i < ZONE_COUNT - 1; ++i) {
+        const auto &zone = config.zones.items[i].sys_config;
+        if (!zone.enabled) {
+            result[i] = ZonePinStatus::DISABLED;
+            continue;
+        }
+
+        uint8_t *pins = used + used_count;
+        const uint8_t count = _led_pins(zone.led_type, zone.led_r_pin, zone.led_g_pin, zone.led_b_pin, pins);
+
+        bool conflict = false;
+        for (uint8_t j = 0; j < count; ++j) {
+            conflict |= std::find(used, pins + j, pins[j]) != pins + j;
+        }
+
+        if (conflict) {
+            result[i] = ZonePinStatus::PIN_CONFLICT;
+        } else if (channels + count > PWM_CHANNEL_COUNT) {
+            result[i] = ZonePinStatus::NO_CHANNEL;
+        } else {
+            result[i] = ZonePinStatus::OK;
+            used_count += count;
+            channels += count;
+        }
+    }
+
+    return result;
+}
+
+void Zone::begin() {
+    const auto &sys = _config.sys_config;
+    _led.create(sys.led_type, sys.led_r_pin, sys.led_g_pin, sys.led_b_pin, _sys_config.led_pwm_profile).begin();
+
+    // Restore without a fade, same as the main light
+    _power = _config.state.power;
+    _color_temperature = _config.state.color_temperature;
+    _load_color();
+    _brightness = _target_brightness();
+    _led->set_brightness(_brightness);
+}
+
+void Zone::register_topics(NotificationRouter &router) {
+    router.add_topic(&_state_parameter, (uint8_t) PacketType::ZONE_STATE + _id);
+    router.add_topic(&_config_parameter, (uint8_t) PacketType::ZONE_CONFIG + _id);
+
+    // MQTT only
+    router.add_topic(&_power_parameter);
+    router.add_topic(&_brightness_parameter);
+    router.add_topic(&_color_parameter);
+    router.add_topic(&_temperature_parameter);
+}
+
+void Zone::update() {
+    auto &state = _config.state;
+    if (_led->led_type() == LedType::RGB && _color_temperature != state.color_temperature) {
+        uint32_t kelvin = _sys_config.led_min_temperature + state.color_temperature *
+            (_sys_config.led_max_temperature - _sys_config.led_min_temperature) / LED_TEMPERATURE_MAX_VALUE;
+
+        state.color = temperature_to_rgb(kelvin);
+        _notify(&_color_parameter);
+    }
+
+    _color_temperature = state.color_temperature;
+    _load_color();
+
+    if (_power != _config.state.power) {
+        _power = _config.state.power;
+
+        _animating = true;
+        _animation_start = millis();
+        _animation_from = _brightness;
+    } else if (!_animating) {
+        _brightness = _target_brightness();
+        _led->set_brightness(_brightness);
+    }
+}
+
+void Zone::set_night(bool night, uint16_t brightness) {
+    _night = night;
+    _night_brightness = brightness;
+
+    if (!_animating && follows_night()) {
+        _brightness = _target_brightness();
+        _led->set_brightness(_brightness);
+    }
+}
+
+bool Zone::apply(const Command &command) {
+    auto &state = _config.state;
+
+    switch (command.type) {
+        case CommandType::POWER:
+            state.power = command.value != 0;
+            _notify(&_power_parameter);
+            return true;
+
+        case CommandType::BRIGHTNESS:
+            state.brightness = std::min<uint32_t>(PWM_MAX_VALUE, command.value);
+            _notify(&_brightness_parameter);
+            return true;
+
+        case CommandType::COLOR:
+            state.color = command.value & 0xffffff;
+            _notify(&_color_parameter);
+            return true;
+
+        case CommandType::TEMPERATURE:
+            state.color_temperature = std::min<uint32_t>(LED_TEMPERATURE_MAX_VALUE, command.value);
+            _notify(&_temperature_parameter);
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+bool Zone::tick(unsigned long now) {
+    if (!_animating) return false;
+
+    const auto timeout = std::max<unsigned long>(1, _sys_config.power_change_timeout);
+    const uint16_t factor = std::min<unsigned long>(PWM_MAX_VALUE, (now - _animation_start) * PWM_MAX_VALUE / timeout);
+
+    const uint16_t target = _target_brightness();
+    _brightness = _animation_from + ((int32_t) target - _animation_from) * ease_quad16(factor, PWM_MAX_VALUE) / PWM_MAX_VALUE;
+    _led->set_brightness(_brightness);
+
+    if (factor == PWM_MAX_VALUE) _animating = false;
+    return _animating;
+}
+
+uint16_t Zone::_target_brightness() const {
+    if (!_power) return 0;
+    if (_night && follows_night()) return _night_brightness;
+
+    return std::min(PWM_MAX_VALUE, std::max(_sys_config.led_min_brightness, _config.state.brightness));
+}
+
+void Zone::_load_color() {
+    const auto &state = _config.state;
+
+    if (_led->led_type() == LedType::RGB) {
+        _led->set_color(rgb48_from_rgb24(state.color));
+    } else if (_led->led_type() == LedType::CCT) {
+        _led->set_temperature(state.color_temperature);
+    }
+}
+
+void Zone::_notify(const AbstractParameter *parameter) {
+    NotificationBus::get().notify_parameter_changed(_sender, parameter);
+    NotificationBus::get().notify_parameter_changed(_sender, &_state_parameter);
+}
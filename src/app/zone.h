@@ -0,0 +1,98 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include "command.h"
+#include "config.h"
+#include "parameters.h"
+#include "network/cmd.h"
+#include "misc/led.h"
+#include "misc/notification_router.h"
+
+static_assert(ZONE_COUNT >= 1 && ZONE_COUNT <= 8, "Zone number must fit the low bits of the packet type");
+
+#define ZONE_TOPIC_SIZE                         (32u)
+#define ZONE_TOPIC_COUNT                        (4u)                    // power, brightness, color, temperature
+#define ZONE_NOTIFICATION_TOPIC_COUNT           (ZONE_TOPIC_COUNT + 2u) // MQTT topics, state and config
+
+MAKE_ENUM_AUTO(ZonePinStatus, uint8_t,
+    OK,
+    DISABLED,
+    PIN_CONFLICT,       // Pin of the main light, the button or an earlier zone, or used twice
+    NO_CHANNEL          // Not enough PWM channels left
+);
+
+// Zones are checked in order, a zone takes its pins and channels only if it passes.
+// Zones that don't pass aren't started
+std::array<ZonePinStatus, ZONE_COUNT - 1> check_zone_pins(const Config &config);
+
+// Additional light driven by the same controller. Keeps its own LED and power fade,
+// follows the main night mode schedule and is addressed by number over every protocol
+class Zone {
+    uint8_t _id;
+    void *_sender;
+    ZoneConfig &_config;
+    const SysConfig &_sys_config;
+    LedControllerSlot _led{};
+
+    bool _power = false;
+    bool _night = false;
+    uint16_t _night_brightness = 0;
+
+    bool _animating = false;
+    unsigned long _animation_start = 0;
+    uint16_t _animation_from = 0;
+    uint16_t _brightness = 0;
+    uint16_t _color_temperature = 0;
+
+    char _topics[ZONE_TOPIC_COUNT * 2][ZONE_TOPIC_SIZE]{};
+
+    NumericParameter<bool> _power_parameter;
+    BrightnessParameter _brightness_parameter;
+    NumericParameter<uint32_t> _color_parameter;
+    TemperatureParameter _temperature_parameter;
+    ComplexParameter<ZoneState> _state_parameter;
+    ComplexParameter<ZoneSysConfig> _config_parameter;
+
+public:
+    // Notifications about own changes are sent on behalf of sender
+    Zone(uint8_t id, void *sender, ZoneConfig &config, const SysConfig &sys_config);
+
+    void begin();
+
+    template<typename WsServer, typename MqttServer>
+    void register_parameters(WsServer &ws_server, MqttServer &mqtt_server);
+    void register_topics(NotificationRouter &router);
+
+    // Reload state after a change of the config, starts a fade if the power was switched
+    void update();
+    void set_night(bool night, uint16_t brightness);
+
+    // Writes the command into the zone state and notifies about the change, false if the command isn't for zones
+    bool apply(const Command &command);
+
+    // Advance the fade, returns false once the zone is idle
+    bool tick(unsigned long now);
+
+    [[nodiscard]] inline uint8_t id() const { return _id; }
+    [[nodiscard]] inline bool animating() const { return _animating; }
+    [[nodiscard]] inline bool follows_night() const { return _config.state.night_mode; }
+    [[nodiscard]] inline const ZoneState &state() const { return _config.state; }
+
+private:
+    uint16_t _target_brightness() const;
+    void _load_color();
+    void _notify(const AbstractParameter *parameter);
+};
+
+template<typename WsServer, typename MqttServer>
+void Zone::register_parameters(WsServer &ws_server, MqttServer &mqtt_server) {
+    ws_server->register_parameter((PacketType) ((uint8_t) PacketType::ZONE_STATE + _id), &_state_parameter);
+    ws_server->register_parameter((PacketType) ((uint8_t) PacketType::ZONE_CONFIG + _id), &_config_parameter);
+
+    mqtt_server->register_parameter(_topics[0], _topics[1], &_power_parameter);
+    mqtt_server->register_parameter(_topics[2], _topics[3], &_brightness_parameter);
+    mqtt_server->register_parameter(_topics[4], _topics[5], &_color_parameter);
+    mqtt_server->register_parameter(_topics[6], _topics[7], &_temperature_parameter);
+}
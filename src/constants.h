@@ -10,6 +10,11 @@
 #define WIFI_MAX_CONNECTION_ATTEMPT_INTERVAL    (120000u)               // Max time (ms) to wait for Wi-Fi connection before switch to AP mode
                                                                         // 0 - Newer switch to AP mode
 
+#define WIFI_STATIC_IP                          ""                      // Empty - use DHCP
+#define WIFI_GATEWAY                            ""
+#define WIFI_SUBNET                             "255.255.255.0"
+#define WIFI_DNS                                ""                      // Empty - use the gateway
+
 #define MDNS_NAME                               "esp_led"
 
 #define LED_MODE                                (LedType::RGB)
@@ -25,6 +30,7 @@
 #endif
 
 #define LED_MIN_BRIGHTNESS                      (1u)
+#define LED_PWM_PROFILE                         (PwmProfile::DEFAULT)
 
 #define BUTTON_ENABLED                          (false)
 #define BUTTON_HIGH_STATE                       (true)
@@ -38,6 +44,17 @@
 #define WIFI_CONNECT_FLASH_TIMEOUT              (3000u)
 
 #define TIME_ZONE                               (5.f)                   // GMT +5:00
+#define SNTP_SERVER                             "pool.ntp.org"
+
+#define ADMISSION_RATE                          (5u)                    // HTTP API requests per second per client
+#define ADMISSION_BURST                         (10u)                   // Requests a client may send at once
+#if ARDUINO_ARCH_ESP32
+#define ADMISSION_MAX_IN_FLIGHT                 (8u)                    // Concurrent HTTP API requests, then 503
+#define ADMISSION_MIN_FREE_HEAP                 (16384u)                // Free heap (bytes) below which requests get 503
+#else
+#define ADMISSION_MAX_IN_FLIGHT                 (4u)
+#define ADMISSION_MIN_FREE_HEAP                 (6144u)
+#endif
 
 
 #define MQTT                                    (0)                     // Enable MQTT server
@@ -53,6 +70,7 @@
 #define MQTT_TOPIC_COLOR                        MQTT_PREFIX "/color"
 #define MQTT_TOPIC_TEMPERATURE                  MQTT_PREFIX "/temperature"
 #define MQTT_TOPIC_NIGHT_MODE                   MQTT_PREFIX "/night_mode"
+#define MQTT_TOPIC_PRESET                       MQTT_PREFIX "/preset"
 
 #define MQTT_OUT_PREFIX                         MQTT_PREFIX "/out"
 #define MQTT_OUT_TOPIC_BRIGHTNESS               MQTT_OUT_PREFIX "/brightness"
@@ -60,3 +78,4 @@
 #define MQTT_OUT_TOPIC_COLOR                    MQTT_OUT_PREFIX "/color"
 #define MQTT_OUT_TOPIC_TEMPERATURE              MQTT_OUT_PREFIX "/temperature"
 #define MQTT_OUT_TOPIC_NIGHT_MODE               MQTT_OUT_PREFIX "/night_mode"
+#define MQTT_OUT_TOPIC_PRESET                   MQTT_OUT_PREFIX "/preset"
@@ -18,14 +18,6 @@ void setup() {
     delay(2000);
 #endif
 
-    analogWriteResolution(PWM_RESOLUTION);
-
-#ifdef ARDUINO_ARCH_ESP8266
-    analogWriteFreq(std::min<uint32_t>(PWM_FREQUENCY, PWM_MAX_FREQUENCY));
-#else
-    analogWriteFrequency(std::min<uint32_t>(PWM_FREQUENCY, PWM_MAX_FREQUENCY));
-#endif
-
     ApplicationInstance.begin();
 }
 
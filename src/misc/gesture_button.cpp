@@ -0,0 +1,143 @@
+#include "gesture_button.h"
+
+#include <algorithm>
+#include <atomic>
+
+#include "lib/debug.h"
+
+GestureButton::GestureButton(uint8_t pin, bool high_state) : _pin(pin), _high_state(high_state) {}
+
+GestureButton::~GestureButton() {
+    detachInterrupt(digitalPinToInterrupt(_pin));
+}
+
+void GestureButton::begin() {
+    pinMode(_pin, INPUT);
+
+    _raw_pressed = _pressed = _read_pressed();
+    _raw_time = _last_transition = millis();
+
+    attachInterruptArg(digitalPinToInterrupt(_pin), _on_interrupt, this, CHANGE);
+    D_PRINTF("Button: Attached interrupt on pin %u\r\n", _pin);
+}
+
+void IRAM_ATTR GestureButton::_on_interrupt(void *arg) {
+    auto *self = (GestureButton *) arg;
+
+    const uint8_t head = self->_edge_head;
+    const uint8_t next = (head + 1) % EDGE_BUFFER_SIZE;
+    if (next == self->_edge_tail) {
+        self->_edge_overflow = self->_edge_overflow + 1;
+        return;
+    }
+
+    self->_edges[head] = {millis(), self->_read_pressed()};
+    std::atomic_signal_fence(std::memory_order_release);
+    self->_edge_head = next;
+    self->_edge_pending = true;
+}
+
+bool IRAM_ATTR GestureButton::_read_pressed() const {
+    return digitalRead(_pin) == (_high_state ? HIGH : LOW);
+}
+
+// Both targets are single core, the flag is a plain store from the ISR as for the edge indices.
+// Past the flag only the state touched by handle() is read: a press or a debounce in progress, or a click waiting for its timeout
+bool GestureButton::pending() const {
+    return _edge_pending || _pressed || _raw_pressed != _pressed || _click_count > 0;
+}
+
+void GestureButton::handle() {
+    if (!pending()) return;
+
+    // An edge queued while draining sets the flag again and costs one more call, never a lost edge
+    _edge_pending = false;
+    std::atomic_signal_fence(std::memory_order_acq_rel);
+
+    while (_edge_tail != _edge_head) {
+        std::atomic_signal_fence(std::memory_order_acquire);
+
+        const uint8_t tail = _edge_tail;
+        const Edge edge = _edges[tail];
+        _edge_tail = (tail + 1) % EDGE_BUFFER_SIZE;
+
+        _process_edge(edge);
+    }
+
+    const auto now = millis();
+
+    // Bounces during the debounce window are dropped, so settle to the last raw level once it is over
+    if (_raw_pressed != _pressed && now - _last_transition >= _debounce_interval) {
+        _transition(_raw_pressed, std::max(_raw_time, _last_transition + _debounce_interval));
+    }
+
+    _handle_timeouts(now);
+}
+
+void GestureButton::_process_edge(const Edge &edge) {
+    _raw_pressed = edge.pressed;
+    _raw_time = edge.time;
+
+    if (edge.pressed == _pressed || edge.time - _last_transition < _debounce_interval) return;
+
+    _transition(edge.pressed, edge.time);
+}
+
+void GestureButton::_transition(bool pressed, unsigned long time) {
+    _pressed = pressed;
+    _last_transition = time;
+
+    if (pressed) {
+        _press_time = time;
+        return;
+    }
+
+    if (_hold_count > 0) {
+        const auto count = _hold_count;
+        _hold_count = 0;
+
+        _emit(ButtonGesture::HOLD_RELEASE, count);
+        return;
+    }
+
+    _release_time = time;
+
+    // Nothing can follow the last supported click, so don't wait for the timeout
+    if (++_click_count == MAX_CLICK_COUNT) {
+        _click_count = 0;
+        _emit(ButtonGesture::CLICK, MAX_CLICK_COUNT);
+    }
+}
+
+void GestureButton::_handle_timeouts(unsigned long now) {
+    if (!_pressed) {
+        if (_click_count > 0 && now - _release_time >= _click_timeout) {
+            const auto count = _click_count;
+            _click_count = 0;
+
+            _emit(ButtonGesture::CLICK, count);
+        }
+
+        return;
+    }
+
+    if (_hold_count == 0) {
+        if (now - _press_time < _hold_timeout) return;
+
+        _hold_count = _click_count + 1;
+        _click_count = 0;
+        _last_hold_call = now;
+
+        _emit(ButtonGesture::HOLD, _hold_count);
+    } else if (now - _last_hold_call >= _hold_call_interval) {
+        _last_hold_call = now;
+
+        _emit(ButtonGesture::HOLD_REPEAT, _hold_count);
+    }
+}
+
+void GestureButton::_emit(ButtonGesture gesture, uint8_t count) {
+    VERBOSE(D_PRINTF("Button: %s x%u\r\n", __debug_enum_str(gesture), count));
+
+    if (_on_gesture) _on_gesture(gesture, count);
+}
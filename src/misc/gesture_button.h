@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+
+#include <Arduino.h>
+
+#include "lib/utils/enum.h"
+
+#include "sys_constants.h"
+
+MAKE_ENUM_AUTO(ButtonGesture, uint8_t,
+    CLICK,
+    HOLD,
+    HOLD_REPEAT,
+    HOLD_RELEASE
+);
+
+typedef std::function<void(ButtonGesture gesture, uint8_t count)> ButtonGestureCallback;
+
+// Button front end driven by GPIO interrupts. The ISR only timestamps edges into a ring buffer,
+// debouncing and gesture recognition run in `handle()`. The loop checks `pending()` first and skips the button
+// until the ISR queues an edge or a debounce, click or hold timeout is armed.
+// `count` is the number of clicks for CLICK, and the number of clicks before the hold plus one for HOLD_*
+class GestureButton {
+    struct Edge {
+        unsigned long time;
+        bool pressed;
+    };
+
+    static constexpr uint8_t EDGE_BUFFER_SIZE = 16;
+    static constexpr uint8_t MAX_CLICK_COUNT = 3;
+
+    uint8_t _pin;
+    bool _high_state;
+
+    Edge _edges[EDGE_BUFFER_SIZE]{};
+    volatile uint8_t _edge_head = 0;    // Written by ISR only
+    volatile uint8_t _edge_tail = 0;    // Written by handle() only
+    volatile uint32_t _edge_overflow = 0;
+    volatile bool _edge_pending = false; // Set by ISR, cleared by handle() before draining
+
+    bool _raw_pressed = false;
+    unsigned long _raw_time = 0;
+
+    bool _pressed = false;
+    unsigned long _last_transition = 0;
+    unsigned long _press_time = 0;
+    unsigned long _release_time = 0;
+
+    uint8_t _click_count = 0;
+    uint8_t _hold_count = 0;
+    unsigned long _last_hold_call = 0;
+
+    unsigned long _debounce_interval = BTN_DEBOUNCE_INTERVAL;
+    unsigned long _click_timeout = BTN_CLICK_TIMEOUT;
+    unsigned long _hold_timeout = BTN_HOLD_TIMEOUT;
+    unsigned long _hold_call_interval = BTN_HOLD_CALL_INTERVAL;
+
+    ButtonGestureCallback _on_gesture = nullptr;
+
+public:
+    GestureButton(uint8_t pin, bool high_state);
+    ~GestureButton();
+
+    GestureButton(const GestureButton &) = delete;
+    GestureButton &operator=(const GestureButton &) = delete;
+
+    void begin();
+    void handle();
+
+    [[nodiscard]] bool pending() const;
+    [[nodiscard]] inline uint32_t edge_overflow() const { return _edge_overflow; }
+
+    inline void set_on_gesture(ButtonGestureCallback fn) { _on_gesture = std::move(fn); }
+
+    inline void set_debounce_interval(unsigned long value) { _debounce_interval = value; }
+    inline void set_click_timeout(unsigned long value) { _click_timeout = value; }
+    inline void set_hold_timeout(unsigned long value) { _hold_timeout = value; }
+    inline void set_hold_call_interval(unsigned long value) { _hold_call_interval = value; }
+
+private:
+    static void IRAM_ATTR _on_interrupt(void *arg);
+
+    [[nodiscard]] bool _read_pressed() const;
+
+    void _process_edge(const Edge &edge);
+    void _transition(bool pressed, unsigned long time);
+    void _handle_timeouts(unsigned long now);
+
+    void _emit(ButtonGesture gesture, uint8_t count);
+};
@@ -0,0 +1,234 @@
+#include "history.h"
+
+#include <algorithm>
+#include <cstring>
+
+static constexpr size_t MAX_EVENT_SIZE = 10 + 5;    // 64-bit header varint + 32-bit value varint
+
+static inline bool _is_delta_encoded(HistoryEventType type) {
+    return type == HistoryEventType::BRIGHTNESS || type == HistoryEventType::TEMPERATURE;
+}
+
+static inline bool _is_coalesced(HistoryEventType type) {
+    return type == HistoryEventType::BRIGHTNESS || type == HistoryEventType::COLOR
+           || type == HistoryEventType::TEMPERATURE;
+}
+
+static inline uint32_t _zigzag(int32_t value) {
+    return ((uint32_t) value << 1) ^ (uint32_t) (value >> 31);
+}
+
+static inline int32_t _unzigzag(uint32_t value) {
+    return (int32_t) (value >> 1) ^ -(int32_t) (value & 1);
+}
+
+static size_t _write_varint(uint8_t *out, uint64_t value) {
+    size_t length = 0;
+    while (value >= 0x80) {
+        out[length++] = (uint8_t) (value | 0x80);
+        value >>= 7;
+    }
+
+    out[length++] = (uint8_t) value;
+    return length;
+}
+
+void HistoryBuffer::record(HistoryEventType type, uint32_t value, unsigned long now) {
+    if ((uint8_t) type >= HISTORY_EVENT_TYPE_COUNT) return;
+
+    const uint32_t time = now / HISTORY_TIME_RESOLUTION;
+
+    _begin_write();
+
+    // Replace the last event if the same parameter keeps changing, e.g. during a brightness ramp.
+    // Once a reader got past it, its seq is taken and the change goes into a new event
+    const bool coalesce = _tail_size > 0 && _tail_type == type && _is_coalesced(type)
+                          && _read_seq.load(std::memory_order_seq_cst) < _next_seq
+                          && time - _last.time <= HISTORY_COALESCE_INTERVAL / HISTORY_TIME_RESOLUTION;
+
+    if (coalesce) {
+        _size -= _tail_size;
+        _last = _before_tail;
+        --_next_seq;
+    }
+
+    uint8_t event[MAX_EVENT_SIZE];
+    const size_t length = _encode(event, type, value, _last, time);
+
+    _evict(length);
+    _append(event, length);
+
+    _before_tail = _last;
+    _tail_size = length;
+    _tail_type = type;
+
+    _last.time = time;
+    _last.values[(uint8_t) type] = value;
+    ++_next_seq;
+
+    _end_write();
+}
+
+bool HistoryBuffer::read(uint32_t cursor, HistoryEvent *out, size_t max_count, size_t &count, uint32_t &next_cursor) const {
+    for (int attempt = 0; attempt < 4; ++attempt) {
+        const uint32_t version = _version.load(std::memory_order_acquire);
+        if (version & 1) continue;
+
+        const size_t head = _head;
+        const size_t size = std::min<size_t>(_size, HISTORY_BUFFER_SIZE);
+        uint32_t seq = _first_seq;
+        HistoryState state = _base;
+
+        // Sequence restarts on reboot, so a cursor from the future means "from the beginning"
+        const uint32_t start = cursor > _next_seq ? seq : cursor;
+
+        count = 0;
+        for (size_t offset = 0; offset < size && count < max_count; ++seq) {
+            HistoryEventType type;
+            const size_t length = _decode(head, size, offset, state, type);
+            if (length == 0) break;
+
+            offset += length;
+
+            if (seq >= start) {
+                out[count++] = {seq, state.time * HISTORY_TIME_RESOLUTION, type, state.values[(uint8_t) type]};
+            }
+        }
+
+        next_cursor = std::max(seq, start);
+        _mark_read(next_cursor);
+
+        if (_version.load(std::memory_order_relaxed) == version) return true;
+    }
+
+    count = 0;
+    next_cursor = cursor;
+    return false;
+}
+
+bool HistoryBuffer::read_page(uint32_t cursor, unsigned long now, HistoryPage &page) const {
+    page.requested = cursor;
+    page.now = now / HISTORY_TIME_RESOLUTION;
+
+    for (int attempt = 0; attempt < 4; ++attempt) {
+        const uint32_t version = _version.load(std::memory_order_acquire);
+        if (version & 1) continue;
+
+        const size_t head = _head;
+        const size_t size = std::min<size_t>(_size, HISTORY_BUFFER_SIZE);
+        const uint32_t start = cursor > _next_seq ? _first_seq : cursor;
+
+        HistoryState state = _base;
+        uint32_t seq = _first_seq;
+        size_t offset = 0;
+
+        for (; offset < size && seq < start; ++seq) {
+            HistoryEventType type;
+            const size_t length = _decode(head, size, offset, state, type);
+            if (length == 0) break;
+
+            offset += length;
+        }
+
+        page.cursor = seq;
+        page.base = state;
+        page.length = 0;
+
+        for (; offset < size; ++seq) {
+            HistoryEventType type;
+            const size_t length = _decode(head, size, offset, state, type);
+            if (length == 0 || page.length + length > sizeof(page.data)) break;
+
+            for (size_t i = 0; i < length; ++i) page.data[page.length++] = _data[(head + offset + i) % HISTORY_BUFFER_SIZE];
+            offset += length;
+        }
+
+        page.next_cursor = seq;
+        _mark_read(seq);
+
+        if (_version.load(std::memory_order_relaxed) == version) return true;
+    }
+
+    page.cursor = cursor;
+    page.next_cursor = cursor;
+    page.length = 0;
+    return false;
+}
+
+void HistoryBuffer::_mark_read(uint32_t next_cursor) const {
+    uint32_t read_seq = _read_seq.load(std::memory_order_relaxed);
+    while (next_cursor > read_seq && !_read_seq.compare_exchange_weak(read_seq, next_cursor, std::memory_order_seq_cst)) {}
+
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+size_t HistoryBuffer::_encode(uint8_t *out, HistoryEventType type, uint32_t value, const HistoryState &state, uint32_t time) {
+    const uint64_t header = (uint64_t) (time - state.time) << 3 | (uint8_t) type;
+    size_t length = _write_varint(out, header);
+
+    const uint32_t encoded_value = _is_delta_encoded(type)
+                                   ? _zigzag((int32_t) (value - state.values[(uint8_t) type]))
+                                   : value;
+
+    length += _write_varint(out + length, encoded_value);
+    return length;
+}
+
+void HistoryBuffer::_apply(HistoryState &state, HistoryEventType type, uint32_t encoded_value, uint32_t delta) {
+    state.time += delta;
+
+    const uint32_t previous = state.values[(uint8_t) type];
+    state.values[(uint8_t) type] = _is_delta_encoded(type) ? previous + _unzigzag(encoded_value) : encoded_value;
+}
+
+size_t HistoryBuffer::_decode(size_t head, size_t size, size_t offset, HistoryState &state, HistoryEventType &type) const {
+    uint64_t fields[2] = {};
+    const size_t start = offset;
+
+    for (auto &field: fields) {
+        for (uint8_t shift = 0;; shift += 7) {
+            if (offset >= size || shift >= 64) return 0;
+
+            const uint8_t byte = _data[(head + offset++) % HISTORY_BUFFER_SIZE];
+            field |= (uint64_t) (byte & 0x7f) << shift;
+
+            if ((byte & 0x80) == 0) break;
+        }
+    }
+
+    type = (HistoryEventType) (fields[0] & 0x7);
+    if ((uint8_t) type >= HISTORY_EVENT_TYPE_COUNT) return 0;
+
+    _apply(state, type, (uint32_t) fields[1], (uint32_t) (fields[0] >> 3));
+    return offset - start;
+}
+
+void HistoryBuffer::_append(const uint8_t *data, size_t length) {
+    for (size_t i = 0; i < length; ++i) _data[(_head + _size + i) % HISTORY_BUFFER_SIZE] = data[i];
+    _size += length;
+}
+
+void HistoryBuffer::_evict(size_t length) {
+    while (_size > 0 && HISTORY_BUFFER_SIZE - _size < length) {
+        HistoryEventType type;
+        const size_t event_length = _decode(_head, _size, 0, _base, type);
+
+        if (event_length == 0) {
+            // Can't happen with a consistent buffer, but never leave it undecodable
+            _base = _last;
+            _size = 0;
+            _first_seq = _next_seq;
+            break;
+        }
+
+        _head = (_head + event_length) % HISTORY_BUFFER_SIZE;
+        _size -= event_length;
+        ++_first_seq;
+    }
+
+    // Tail event was dropped together with the rest of the buffer
+    if (_size == 0) {
+        _head = 0;
+        _tail_size = 0;
+    }
+}
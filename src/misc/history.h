@@ -0,0 +1,98 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "lib/utils/enum.h"
+
+#include "sys_constants.h"
+
+MAKE_ENUM_AUTO(HistoryEventType, uint8_t,
+    POWER,
+    BRIGHTNESS,
+    COLOR,
+    TEMPERATURE,
+    NIGHT
+);
+
+constexpr uint8_t HISTORY_EVENT_TYPE_COUNT = 5;
+
+struct HistoryEvent {
+    uint32_t seq;
+    unsigned long time;     // ms since boot, HISTORY_TIME_RESOLUTION precision
+    HistoryEventType type;
+    uint32_t value;
+};
+
+struct __attribute ((packed)) HistoryState {
+    uint32_t time = 0;                              // HISTORY_TIME_RESOLUTION units since boot
+    uint32_t values[HISTORY_EVENT_TYPE_COUNT]{};    // Last value of each event type
+};
+
+// Raw page for the binary protocol: events in `data` are encoded against `base`, see HistoryBuffer
+struct __attribute ((packed)) HistoryPage {
+    uint32_t requested = 0;     // Cursor the page was read for
+    uint32_t cursor = 0;        // Sequence number of the first event in the page, past `requested` if those were dropped
+    uint32_t next_cursor = 0;
+    uint32_t now = 0;           // HISTORY_TIME_RESOLUTION units since boot
+    HistoryState base{};
+    uint16_t length = 0;
+    uint8_t data[HISTORY_PAGE_SIZE]{};
+};
+
+// Fixed-size ring of parameter changes. Each event is two varints:
+//   (time delta << 3 | type) and the value: raw for POWER, NIGHT and COLOR, zigzag delta for BRIGHTNESS and TEMPERATURE.
+// Oldest events are dropped on overflow, their effect is folded into the base state.
+// A brightness, color or temperature change replaces the previous event of the same type if it's recent
+// and nobody has read it yet, so a cursor never skips a value. Power and night mode are never merged.
+// Written from the app loop only; reading is safe to call concurrently (seqlock, retries on a concurrent write)
+class HistoryBuffer {
+    uint8_t _data[HISTORY_BUFFER_SIZE]{};
+    size_t _head = 0;
+    size_t _size = 0;
+
+    uint32_t _first_seq = 0;
+    uint32_t _next_seq = 0;
+
+    HistoryState _base{};       // State before the first stored event
+    HistoryState _last{};       // State after the last stored event
+
+    HistoryState _before_tail{};
+    size_t _tail_size = 0;
+    HistoryEventType _tail_type = HistoryEventType::POWER;
+
+    std::atomic<uint32_t> _version{0};
+    mutable std::atomic<uint32_t> _read_seq{0};     // Highest cursor handed out to a reader
+
+public:
+    void record(HistoryEventType type, uint32_t value, unsigned long now);
+
+    // Copies up to `max_count` events starting at `cursor`. Events older than the buffer are skipped,
+    // so out[0].seq > cursor means some events were lost. Returns false if a concurrent write didn't allow to read
+    bool read(uint32_t cursor, HistoryEvent *out, size_t max_count, size_t &count, uint32_t &next_cursor) const;
+
+    // Returns false with an empty page if a concurrent write didn't allow to read
+    bool read_page(uint32_t cursor, unsigned long now, HistoryPage &page) const;
+
+    [[nodiscard]] inline uint32_t first_seq() const { return _first_seq; }
+    [[nodiscard]] inline uint32_t next_seq() const { return _next_seq; }
+    [[nodiscard]] inline size_t size() const { return _size; }
+
+private:
+    static size_t _encode(uint8_t *out, HistoryEventType type, uint32_t value, const HistoryState &state, uint32_t time);
+    static void _apply(HistoryState &state, HistoryEventType type, uint32_t encoded_value, uint32_t delta);
+
+    // Decodes one event at `offset` (relative to `head`, within `size`) into `state`.
+    // Returns encoded size or 0 if malformed, never reads outside of the buffer
+    size_t _decode(size_t head, size_t size, size_t offset, HistoryState &state, HistoryEventType &type) const;
+
+    void _append(const uint8_t *data, size_t length);
+    void _evict(size_t length);
+
+    // Ordered against `_read_seq`: either the writer sees the cursor or the reader sees the write and retries
+    void _mark_read(uint32_t next_cursor) const;
+
+    void _begin_write() { _version.fetch_add(1, std::memory_order_seq_cst); }
+    void _end_write() { _version.fetch_add(1, std::memory_order_release); }
+};
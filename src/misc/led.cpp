@@ -1,42 +1,116 @@
 #include "led.h"
 
 #include <Arduino.h>
-#include "utils/math.h"
 
-LedController::LedController(uint8_t pin)
+#ifdef ARDUINO_ARCH_ESP32
+#include <driver/ledc.h>
+#include <soc/soc_caps.h>
+
+#include "lib/debug.h"
+
+// Taken in order by every controller, zones included. analogWrite() is not used, it doesn't expose the channel
+static uint8_t _ledc_next_channel = 0;
+#endif
+
+constexpr CurveTable GAMMA_TABLE PROGMEM = build_gamma_table(GAMMA);
+
+template<typename Pwm>
+constexpr CurveTable PwmLedController<Pwm>::BRIGHTNESS_TABLE PROGMEM = build_brightness_table(Pwm::MAX_VALUE);
+
+template<typename Pwm, typename Storage>
+static LedController &_create_led_controller(Storage &storage, LedType led_type, uint8_t r_pin, uint8_t g_pin, uint8_t b_pin) {
+    if (led_type == LedType::RGB) {
+        return storage.template emplace<PwmLedController<Pwm>>(r_pin, g_pin, b_pin);
+    } else if (led_type == LedType::CCT) {
+        return storage.template emplace<PwmLedController<Pwm>>(r_pin, g_pin);
+    } else {
+        return storage.template emplace<PwmLedController<Pwm>>(r_pin);
+    }
+}
+
+LedController &LedControllerSlot::create(LedType led_type, uint8_t r_pin, uint8_t g_pin, uint8_t b_pin,
+                                         PwmProfile pwm_profile) {
+    switch (pwm_profile) {
+        case PwmProfile::HIGH_RESOLUTION:
+            _controller = &_create_led_controller<PwmHighResolution>(_storage, led_type, r_pin, g_pin, b_pin);
+            break;
+
+        case PwmProfile::HIGH_FREQUENCY:
+            _controller = &_create_led_controller<PwmHighFrequency>(_storage, led_type, r_pin, g_pin, b_pin);
+            break;
+
+        default:
+            _controller = &_create_led_controller<PwmDefault>(_storage, led_type, r_pin, g_pin, b_pin);
+            break;
+    }
+
+    return *_controller;
+}
+
+LedController &LedControllerSlot::create(const SysConfig &sys_config) {
+    return create(sys_config.led_type, sys_config.led_r_pin, sys_config.led_g_pin, sys_config.led_b_pin,
+        sys_config.led_pwm_profile);
+}
+
+template<typename Pwm>
+PwmLedController<Pwm>::PwmLedController(uint8_t pin)
     : _led_type(LedType::SINGLE), _led_pin(pin) {}
 
-LedController::LedController(uint8_t r_pin, uint8_t g_pin, uint8_t b_pin)
+template<typename Pwm>
+PwmLedController<Pwm>::PwmLedController(uint8_t r_pin, uint8_t g_pin, uint8_t b_pin)
     : _led_type(LedType::RGB), _r_pin(r_pin), _g_pin(g_pin), _b_pin(b_pin) {
 
-    _color = 0xffffff;
-    _calibration = 0xffffff;
+    _color = RGB48_WHITE;
+    _calibration = RGB48_WHITE;
     _load_calibration(_color, _calibration);
 }
 
-LedController::LedController(uint8_t w_pin, uint8_t c_pin)
+template<typename Pwm>
+PwmLedController<Pwm>::PwmLedController(uint8_t w_pin, uint8_t c_pin)
     : _led_type(LedType::CCT), _w_pin(w_pin), _c_pin(c_pin) {
 
     _color_temperature = PWM_MAX_VALUE;
     _load_color_temperature(_color_temperature);
 }
 
-void LedController::begin() {
-    if (_led_type == LedType::SINGLE) {
-        pinMode(_led_pin, OUTPUT);
-    } else if (_led_type == LedType::CCT) {
-        pinMode(_w_pin, OUTPUT);
-        pinMode(_c_pin, OUTPUT);
-    } else if (_led_type == LedType::RGB) {
-        pinMode(_r_pin, OUTPUT);
-        pinMode(_g_pin, OUTPUT);
-        pinMode(_b_pin, OUTPUT);
+template<typename Pwm>
+void PwmLedController<Pwm>::begin() {
+    uint8_t pins[MAX_CHANNELS];
+    const uint8_t count = _pins(pins);
+
+#ifdef ARDUINO_ARCH_ESP32
+    // Channels share LEDC timers in pairs, zones run the main PWM profile, so the timer settings always agree
+    for (uint8_t i = 0; i < count; ++i) {
+        if (_ledc_next_channel >= PWM_CHANNEL_COUNT) {
+            D_PRINTF("LED: No LEDC channel left for pin %u\r\n", pins[i]);
+            _ledc_channel[i] = UINT8_MAX;
+            continue;
+        }
+
+        _ledc_channel[i] = _ledc_next_channel++;
+        ledcSetup(_ledc_channel[i], Pwm::FREQUENCY, Pwm::RESOLUTION);
+        ledcAttachPin(pins[i], _ledc_channel[i]);
     }
+#else
+    analogWriteResolution(Pwm::RESOLUTION);
+
+#ifdef ARDUINO_ARCH_ESP8266
+    analogWriteFreq(Pwm::FREQUENCY);
+#else
+    analogWriteFrequency(Pwm::FREQUENCY);
+#endif
+
+    for (uint8_t i = 0; i < count; ++i) pinMode(pins[i], OUTPUT);
+#endif
+
+    // Start dark. Restoring a saved full brightness or white color then differs from the cache and is written
+    _analog_write();
 }
 
-void LedController::set_brightness(uint16_t value) {
-    uint16_t new_brightness = PWM_MAX_VALUE - (uint16_t) floor(
-        log10f(10 - (float) value * 9 / PWM_MAX_VALUE) * PWM_MAX_VALUE);
+template<typename Pwm>
+void PwmLedController<Pwm>::set_brightness(uint16_t value) {
+    value = std::min(PWM_MAX_VALUE, value);
+    uint16_t new_brightness = interpolate_curve(BRIGHTNESS_TABLE, pwm_logical_to_16(value));
 
     if (_brightness == new_brightness) return;
 
@@ -44,7 +118,8 @@ void LedController::set_brightness(uint16_t value) {
     _analog_write();
 }
 
-void LedController::set_color(uint32_t color) {
+template<typename Pwm>
+void PwmLedController<Pwm>::set_color(const Rgb48 &color) {
     if (_led_type != LedType::RGB || _color == color) return;
 
     _color = color;
@@ -53,7 +128,8 @@ void LedController::set_color(uint32_t color) {
     _analog_write();
 }
 
-void LedController::set_calibration(uint32_t calibration) {
+template<typename Pwm>
+void PwmLedController<Pwm>::set_calibration(const Rgb48 &calibration) {
     if (_led_type != LedType::RGB || _calibration == calibration) return;
 
     _calibration = calibration;
@@ -62,7 +138,8 @@ void LedController::set_calibration(uint32_t calibration) {
     _analog_write();
 }
 
-void LedController::set_temperature(uint16_t temperature) {
+template<typename Pwm>
+void PwmLedController<Pwm>::set_temperature(uint16_t temperature) {
     if (_led_type != LedType::CCT || _color_temperature == temperature) return;
 
     _color_temperature = temperature;
@@ -70,21 +147,77 @@ void LedController::set_temperature(uint16_t temperature) {
     _analog_write();
 }
 
-void LedController::_apply_rgb_brightness(uint16_t brightness) {
-    analogWrite(_r_pin, (int32_t) _color_r * brightness / PWM_MAX_VALUE);
-    analogWrite(_g_pin, (int32_t) _color_g * brightness / PWM_MAX_VALUE);
-    analogWrite(_b_pin, (int32_t) _color_b * brightness / PWM_MAX_VALUE);
+template<typename Pwm>
+void PwmLedController<Pwm>::_apply_rgb_brightness(uint16_t brightness) {
+    const uint16_t duty[] = {
+        Pwm::scale(_color_r, brightness),
+        Pwm::scale(_color_g, brightness),
+        Pwm::scale(_color_b, brightness),
+    };
+
+    _write(duty, 3);
+}
+
+template<typename Pwm>
+void PwmLedController<Pwm>::_apply_cct_brightness(uint16_t brightness) {
+    const uint16_t duty[] = {
+        Pwm::scale(_w_brightness, brightness),
+        Pwm::scale(_c_brightness, brightness),
+    };
+
+    _write(duty, 2);
 }
 
-void LedController::_apply_cct_brightness(uint16_t brightness) {
-    analogWrite(_w_pin, (int32_t) _w_brightness * brightness / PWM_MAX_VALUE);
-    analogWrite(_c_pin, (int32_t) _c_brightness * brightness / PWM_MAX_VALUE);
+template<typename Pwm>
+uint8_t PwmLedController<Pwm>::_pins(uint8_t *pins) const {
+    switch (_led_type) {
+        case LedType::RGB:
+            pins[0] = _r_pin;
+            pins[1] = _g_pin;
+            pins[2] = _b_pin;
+            return 3;
+
+        case LedType::CCT:
+            pins[0] = _w_pin;
+            pins[1] = _c_pin;
+            return 2;
+
+        default:
+            pins[0] = _led_pin;
+            return 1;
+    }
 }
 
-void LedController::_analog_write() {
+template<typename Pwm>
+void PwmLedController<Pwm>::_write(const uint16_t *duty, uint8_t count) {
+    pwm_stagger(duty, _phase, count, Pwm::MAX_VALUE);
+
+#ifdef ARDUINO_ARCH_ESP32
+    // Channels 0..7 belong to the first LEDC group in ledcSetup()
+    constexpr auto mode = (ledc_mode_t) 0;
+
+    for (uint8_t i = 0; i < count; ++i) {
+        if (_ledc_channel[i] == UINT8_MAX) continue;
+
+        // Full on is one count above MAX_VALUE for LEDC, same as ledcWrite() does
+        const uint32_t value = duty[i] == Pwm::MAX_VALUE ? Pwm::MAX_VALUE + 1 : duty[i];
+        ledc_set_duty_with_hpoint(mode, (ledc_channel_t) _ledc_channel[i], value, _phase[i]);
+        ledc_update_duty(mode, (ledc_channel_t) _ledc_channel[i]);
+    }
+#else
+    // No phase control through analogWrite(), the ESP8266 waveform generator keeps its own timing
+    uint8_t pins[MAX_CHANNELS];
+    _pins(pins);
+
+    for (uint8_t i = 0; i < count; ++i) analogWrite(pins[i], duty[i]);
+#endif
+}
+
+template<typename Pwm>
+void PwmLedController<Pwm>::_analog_write() {
     switch (_led_type) {
         case LedType::SINGLE:
-            analogWrite(_led_pin, _brightness);
+            _write(&_brightness, 1);
             break;
 
         case LedType::RGB:
@@ -97,42 +230,38 @@ void LedController::_analog_write() {
     }
 }
 
-uint16_t LedController::_convert_color(uint32_t color_data, uint32_t calibration_data, uint8_t bit) {
-    uint8_t color = (color_data >> bit) & 0xff;
-    uint8_t calibration = (calibration_data >> bit) & 0xff;
-
-    uint8_t calibrated_color = (uint16_t) color * calibration / 255;
-    return map16(_apply_gamma(calibrated_color), 255, PWM_MAX_VALUE);
-}
-
-void LedController::_load_calibration(uint32_t color, uint32_t calibration) {
-    _color_r = _convert_color(color, calibration, 16);
-    _color_g = _convert_color(color, calibration, 8);
-    _color_b = _convert_color(color, calibration, 0);
-}
-
-uint8_t LedController::_apply_gamma(uint8_t color, float gamma) {
-    if (gamma == 1.0f) return color;
-
-    auto orig = (float) color / 255.0f;
-    auto adj = pow(orig, gamma) * 255.0f;
-
-    auto result = (uint8_t) adj;
+template<typename Pwm>
+uint16_t PwmLedController<Pwm>::_convert_color(uint16_t color, uint16_t calibration) {
+    const auto calibrated_color = (uint16_t) ((uint32_t) color * calibration / UINT16_MAX);
+    const auto result = Pwm::from_16(apply_gamma16(calibrated_color));
 
     // Avoid gamma-adjusting a positive number to zero
-    if (color > 0 && result == 0) return 1;
+    if (calibrated_color > 0 && result == 0) return 1;
 
     return result;
 }
 
-void LedController::_load_color_temperature(uint16_t temperature) {
+template<typename Pwm>
+void PwmLedController<Pwm>::_load_calibration(const Rgb48 &color, const Rgb48 &calibration) {
+    _color_r = _convert_color(color.r, calibration.r);
+    _color_g = _convert_color(color.g, calibration.g);
+    _color_b = _convert_color(color.b, calibration.b);
+}
+
+template<typename Pwm>
+void PwmLedController<Pwm>::_load_color_temperature(uint16_t temperature) {
     temperature = std::min<uint16_t>(LED_TEMPERATURE_MAX_VALUE, temperature);
 
     // Calculate the brightness for the warm white LEDs
     // The brightness decreases as the temperature goes above neutral white
-    _w_brightness = (uint16_t) std::min<int32_t>(PWM_MAX_VALUE, std::max<int32_t>(LED_TEMPERATURE_MAX_VALUE - temperature, 0));
+    _w_brightness = Pwm::from_logical((uint16_t) std::min<int32_t>(PWM_MAX_VALUE,
+        std::max<int32_t>(LED_TEMPERATURE_MAX_VALUE - temperature, 0)));
 
     // Calculate the brightness for the cool white LEDs based on the clamped temperature
     // The brightness increases as the temperature approaches neutral white
-    _c_brightness = (uint16_t) std::min<int32_t>(PWM_MAX_VALUE, temperature);
+    _c_brightness = Pwm::from_logical((uint16_t) std::min<int32_t>(PWM_MAX_VALUE, temperature));
 }
+
+template class PwmLedController<PwmDefault>;
+template class PwmLedController<PwmHighResolution>;
+template class PwmLedController<PwmHighFrequency>;
@@ -1,13 +1,43 @@
 #pragma once
 
 #include <cstdint>
+#include <variant>
 
 #include "constants.h"
 #include "app/config.h"
+#include "utils/color.h"
+#include "utils/curve.h"
+#include "utils/pwm.h"
 
+// Inputs are in the logical PWM_MAX_VALUE scale, the output duty range depends on the PWM profile
 class LedController {
+public:
+    virtual ~LedController() = default;
+
+    virtual void begin() = 0;
+
+    virtual void set_brightness(uint16_t value) = 0;
+    virtual void set_color(const Rgb48 &color) = 0;
+    virtual void set_calibration(const Rgb48 &calibration) = 0;
+    virtual void set_temperature(uint16_t temperature) = 0;
+
+    [[nodiscard]] virtual LedType led_type() const = 0;
+    [[nodiscard]] virtual uint16_t brightness() const = 0;
+};
+
+template<typename Pwm>
+class PwmLedController final : public LedController {
+    static const CurveTable BRIGHTNESS_TABLE;
+
+    static constexpr uint8_t MAX_CHANNELS = 3;
+
     LedType _led_type;
-    uint16_t _brightness = PWM_MAX_VALUE;
+    uint16_t _brightness = 0;               // Written by begin(), so the cache always matches the output
+
+    uint16_t _phase[MAX_CHANNELS]{};        // Start of each channel's on-time, in duty units
+#ifdef ARDUINO_ARCH_ESP32
+    uint8_t _ledc_channel[MAX_CHANNELS]{};
+#endif
 
     union {
         struct {
@@ -23,33 +53,53 @@ class LedController {
         struct {
             uint8_t _r_pin{0}, _g_pin{0}, _b_pin{0};
             uint16_t _color_r{0}, _color_g{0}, _color_b{0};
-            uint32_t _color{0};
-            uint32_t _calibration{0};
+            Rgb48 _color;
+            Rgb48 _calibration;
         };
     };
 
 public:
-    explicit LedController(uint8_t pin);
-    LedController(uint8_t c_pin, uint8_t w_pin);
-    LedController(uint8_t r_pin, uint8_t g_pin, uint8_t b_pin);
+    explicit PwmLedController(uint8_t pin);
+    PwmLedController(uint8_t c_pin, uint8_t w_pin);
+    PwmLedController(uint8_t r_pin, uint8_t g_pin, uint8_t b_pin);
+
+    void begin() override;
 
-    void begin();
+    void set_brightness(uint16_t value) override;
+    void set_color(const Rgb48 &color) override;
+    void set_calibration(const Rgb48 &calibration) override;
+    void set_temperature(uint16_t temperature) override;
 
-    void set_brightness(uint16_t value);
-    void set_color(uint32_t color);
-    void set_calibration(uint32_t calibration);
-    void set_temperature(uint16_t temperature);
+    [[nodiscard]] inline LedType led_type() const override { return _led_type; }
+    [[nodiscard]] inline uint16_t brightness() const override { return _brightness; }
 
-    [[nodiscard]] inline LedType led_type() const { return _led_type; }
-    [[nodiscard]] inline uint16_t brightness() const { return _brightness; }
+    // Phase of the channel in the pin order of the constructor
+    [[nodiscard]] inline uint16_t phase(uint8_t index) const { return index < MAX_CHANNELS ? _phase[index] : 0; }
 
 private:
+    uint8_t _pins(uint8_t *pins) const;
+    void _write(const uint16_t *duty, uint8_t count);
+
     void _apply_rgb_brightness(uint16_t brightness);
     void _apply_cct_brightness(uint16_t brightness);
     void _analog_write();
 
     void _load_color_temperature(uint16_t temperature);
-    void _load_calibration(uint32_t color, uint32_t calibration);
-    uint16_t _convert_color(uint32_t color_data, uint32_t calibration_data, uint8_t bit);
-    uint8_t _apply_gamma(uint8_t color, float gamma = GAMMA);
+    void _load_calibration(const Rgb48 &color, const Rgb48 &calibration);
+    uint16_t _convert_color(uint16_t color, uint16_t calibration);
+};
+
+// Holds a controller of any PWM profile in place, so it lives inside its owner instead of the heap
+class LedControllerSlot {
+    std::variant<std::monostate, PwmLedController<PwmDefault>, PwmLedController<PwmHighResolution>,
+                 PwmLedController<PwmHighFrequency>> _storage{};
+    LedController *_controller = nullptr;
+
+public:
+    LedController &create(LedType led_type, uint8_t r_pin, uint8_t g_pin, uint8_t b_pin, PwmProfile pwm_profile);
+    LedController &create(const SysConfig &sys_config);
+
+    inline LedController *operator->() const { return _controller; }
+    inline LedController &operator*() const { return *_controller; }
+    inline explicit operator bool() const { return _controller != nullptr; }
 };
@@ -1,31 +1,32 @@
 #include "night_mode.h"
 
-#include "lib/misc/ntp_time.h"
-
 #include "utils/math.h"
 
 NightModeManager::NightModeManager(const Config &config) : _config(config) {}
 
-void NightModeManager::handle_night(const NtpTime &ntp_time) {
-    if (!_config.night_mode.enabled || !ntp_time.available()) return;
+void NightModeManager::handle_night(uint64_t now_ms) {
+    if (!_config.night_mode.enabled) return;
+
+    const unsigned long now = now_ms / 1000;
+
+    ++_stats.handle_calls;
 
     if (_need_update_parameters) {
-        _update_next_night_time(ntp_time);
+        _update_next_night_time(now);
         _need_update_parameters = false;
     }
 
-    const auto now = ntp_time.epoch_tz();
-    _update_night_flag(now);
+    _update_night_flag(now_ms);
 
     if (is_night_time()) {
-        const uint32_t update_factor_interval = now >= _next_start_time && now <= _next_end_time
-                                                ? FACTOR_UPDATE_PERIOD_MS : FACTOR_FADE_UPDATE_PERIOD_MS;
+        const bool plateau = now_ms >= (uint64_t) _next_start_time * 1000 && now_ms < (uint64_t) _next_end_time * 1000;
+        const uint32_t update_factor_interval = plateau ? FACTOR_UPDATE_PERIOD_MS : FACTOR_FADE_UPDATE_PERIOD_MS;
 
         if (millis() - _last_fade_factor_update > update_factor_interval) {
-            _update_fade_factor(now);
+            _update_fade_factor(now_ms);
         }
     } else if (now > _next_start_fade_time) {
-        _update_next_night_time(ntp_time);
+        _update_next_night_time(now);
     }
 }
 
@@ -39,23 +40,24 @@ void NightModeManager::reset() {
     _need_update_parameters = true;
 }
 
-void NightModeManager::_update_next_night_time(const NtpTime &ntp_time) {
+void NightModeManager::_update_next_night_time(unsigned long now) {
+    ++_stats.schedule_updates;
+
     const auto cfg = _config.night_mode;
 
-    const auto start_offset = min(NtpTime::SECONDS_PER_DAY, cfg.start_time);
-    const auto end_offset = min(NtpTime::SECONDS_PER_DAY, cfg.end_time);
+    const auto start_offset = min(SECONDS_PER_DAY, cfg.start_time);
+    const auto end_offset = min(SECONDS_PER_DAY, cfg.end_time);
 
-    auto now = ntp_time.epoch_tz();
-    auto start_day = ntp_time.today_tz();
+    auto start_day = now - now % SECONDS_PER_DAY;
     auto end_fade_time = start_day + end_offset + cfg.switch_interval;
 
     if (now > end_fade_time) {
-        start_day += NtpTime::SECONDS_PER_DAY;
-        end_fade_time += NtpTime::SECONDS_PER_DAY;
+        start_day += SECONDS_PER_DAY;
+        end_fade_time += SECONDS_PER_DAY;
     }
 
     _next_start_time = start_day + start_offset;
-    if (start_offset > end_offset) _next_start_time -= NtpTime::SECONDS_PER_DAY;
+    if (start_offset > end_offset) _next_start_time -= SECONDS_PER_DAY;
 
     _next_start_fade_time = _next_start_time - cfg.switch_interval;
 
@@ -65,26 +67,34 @@ void NightModeManager::_update_next_night_time(const NtpTime &ntp_time) {
     D_PRINTF("Next night time: %lu - %lu\n", _next_start_fade_time, _next_end_fade_time);
 }
 
-void NightModeManager::_update_night_flag(unsigned long now) {
+void NightModeManager::_update_night_flag(uint64_t now_ms) {
+    const unsigned long now = now_ms / 1000;
     const bool new_value = now >= _next_start_fade_time && now <= _next_end_fade_time;
-    if (new_value != _is_night)
-        D_PRINT(new_value ? "Night time begin" : "Night time end");
+    if (new_value == _is_night) return;
 
+    D_PRINT(new_value ? "Night time begin" : "Night time end");
     _is_night = new_value;
+
+    // Don't wait for the next periodic update, otherwise a stale factor is used (e.g. when booting in the middle of the night)
+    if (_is_night) _update_fade_factor(now_ms);
 }
 
-void NightModeManager::_update_fade_factor(unsigned long now) {
-    if (now < _next_start_time) {
-        _fade_factor = (float) (now - _next_start_fade_time) / _config.night_mode.switch_interval;
-    } else if (now < _next_end_time) {
+void NightModeManager::_update_fade_factor(uint64_t now_ms) {
+    // Millisecond resolution keeps short fades smooth instead of stepping once per second
+    const auto interval_ms = (float) _config.night_mode.switch_interval * 1000;
+
+    if (now_ms < (uint64_t) _next_start_time * 1000) {
+        _fade_factor = (float) (now_ms - (uint64_t) _next_start_fade_time * 1000) / interval_ms;
+    } else if (now_ms < (uint64_t) _next_end_time * 1000) {
         _fade_factor = 1;
-    } else if (now < _next_end_fade_time) {
-        _fade_factor = (float) (_next_end_fade_time - now) / _config.night_mode.switch_interval;
+    } else if (now_ms < (uint64_t) _next_end_fade_time * 1000) {
+        _fade_factor = (float) ((uint64_t) _next_end_fade_time * 1000 - now_ms) / interval_ms;
     } else {
         _fade_factor = 0;
     }
 
     _last_fade_factor_update = millis();
+    ++_stats.fade_factor_updates;
 
     VERBOSE(D_PRINTF("Factor: %.2f\n", _fade_factor));
 }
@@ -3,9 +3,15 @@
 #include "app/config.h"
 #include "lib/debug.h"
 
-class NtpTime;
+struct NightModeStats {
+    uint32_t handle_calls = 0;
+    uint32_t schedule_updates = 0;
+    uint32_t fade_factor_updates = 0;
+};
 
 class NightModeManager {
+    static constexpr uint32_t SECONDS_PER_DAY = 24ul * 60 * 60;
+
     static constexpr int32_t FACTOR_FADE_UPDATE_PERIOD_MS = 30;
     static constexpr int32_t FACTOR_UPDATE_PERIOD_MS = 1000;
 
@@ -24,19 +30,23 @@ class NightModeManager {
 
     bool _need_update_parameters = false;
 
+    NightModeStats _stats{};
+
 public:
     explicit NightModeManager(const Config &config);
 
-    void handle_night(const NtpTime &ntp_time);
+    // `now_ms` is the local (time zone adjusted) epoch time in milliseconds
+    void handle_night(uint64_t now_ms);
 
     [[nodiscard]] uint16_t get_brightness() const;
     [[nodiscard]] inline bool is_night_time() const { return _config.night_mode.enabled && _is_night; }
+    [[nodiscard]] inline const NightModeStats &stats() const { return _stats; }
 
     void reset();
 
 private:
-    void _update_next_night_time(const NtpTime &ntp_time);
-    void _update_night_flag(unsigned long now);
+    void _update_next_night_time(unsigned long now);
+    void _update_night_flag(uint64_t now_ms);
 
-    void _update_fade_factor(unsigned long now);
+    void _update_fade_factor(uint64_t now_ms);
 };
@@ -0,0 +1,140 @@
+#include "notification_router.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "lib/debug.h"
+
+NotificationRouter::NotificationRouter() {
+    memset(_index, NONE, sizeof(_index));
+}
+
+bool NotificationRouter::add_topic(const AbstractParameter *parameter, uint8_t key) {
+    if (_find(parameter)) return true;
+
+    if (_topic_count == NOTIFICATION_TOPIC_COUNT) {
+        D_PRINT("Notifications: Topic table is full");
+        ++_stats.overflows;
+        return false;
+    }
+
+    size_t slot = _hash(parameter);
+    while (_index[slot] != NONE) slot = (slot + 1) & (INDEX_SIZE - 1);
+
+    auto &topic = _topics[_topic_count];
+    topic.parameter = parameter;
+    topic.key = key;
+
+    _index[slot] = _topic_count++;
+    return true;
+}
+
+bool NotificationRouter::subscribe(const AbstractParameter *parameter, ParameterHandler handler, void *arg,
+                                   const void *ignore_sender) {
+    auto topic = _find(parameter);
+    if (!topic) return false;
+
+    const auto subscriber = _add_subscriber({_invoke_parameter, (void (*)()) handler, arg, ignore_sender});
+    return subscriber != NONE && _link(*topic, subscriber);
+}
+
+uint8_t NotificationRouter::subscribe_range(const void *begin, size_t size, ParameterHandler handler, void *arg,
+                                            const void *ignore_sender) {
+    const auto subscriber = _add_subscriber({_invoke_parameter, (void (*)()) handler, arg, ignore_sender});
+    if (subscriber == NONE) return 0;
+
+    uint8_t count = 0;
+    for (uint8_t i = 0; i < _topic_count; ++i) {
+        const auto offset = (uintptr_t) _topics[i].parameter->get_value() - (uintptr_t) begin;
+        if (offset < size && _link(_topics[i], subscriber)) ++count;
+    }
+
+    return count;
+}
+
+void NotificationRouter::dispatch(void *sender, const AbstractParameter *parameter) {
+    ++_stats.events;
+
+    auto topic = _find(parameter);
+    if (!topic) {
+        ++_stats.unrouted;
+        return;
+    }
+
+    ++topic->events;
+
+    for (uint8_t link = topic->first; link != NONE; link = _links[link].next) {
+        const auto &subscriber = _subscribers[_links[link].subscriber];
+        if (sender && sender == subscriber.ignore_sender) {
+            ++_stats.filtered;
+            continue;
+        }
+
+        subscriber.invoke(subscriber, sender, parameter);
+        ++_stats.delivered;
+    }
+}
+
+void NotificationRouter::sample() {
+    for (uint8_t i = 0; i < _topic_count; ++i) {
+        auto &topic = _topics[i];
+        topic.rate = std::min<uint32_t>(UINT16_MAX, topic.events - topic.sampled);
+        topic.sampled = topic.events;
+    }
+}
+
+size_t NotificationRouter::_hash(const AbstractParameter *parameter) {
+    // Fibonacci hashing, parameters are at least 4-byte aligned
+    return (uint32_t) ((uintptr_t) parameter >> 2) * 2654435769u >> (32 - INDEX_BITS);
+}
+
+NotificationTopic *NotificationRouter::_find(const AbstractParameter *parameter) {
+    for (size_t slot = _hash(parameter); _index[slot] != NONE; slot = (slot + 1) & (INDEX_SIZE - 1)) {
+        auto &topic = _topics[_index[slot]];
+        if (topic.parameter == parameter) return &topic;
+    }
+
+    return nullptr;
+}
+
+NotificationTopic *NotificationRouter::_find_value(const void *value, size_t size) {
+    for (uint8_t i = 0; i < _topic_count; ++i) {
+        const auto parameter = _topics[i].parameter;
+        if (parameter->get_value() == value && parameter->size() == size) return &_topics[i];
+    }
+
+    return nullptr;
+}
+
+uint8_t NotificationRouter::_add_subscriber(const Subscriber &subscriber) {
+    if (_subscriber_count == NOTIFICATION_SUBSCRIBER_COUNT) {
+        D_PRINT("Notifications: Subscriber table is full");
+        ++_stats.overflows;
+        return NONE;
+    }
+
+    _subscribers[_subscriber_count] = subscriber;
+    return _subscriber_count++;
+}
+
+bool NotificationRouter::_link(NotificationTopic &topic, uint8_t subscriber) {
+    if (_link_count == NOTIFICATION_LINK_COUNT) {
+        D_PRINT("Notifications: Link table is full");
+        ++_stats.overflows;
+        return false;
+    }
+
+    // Appended, handlers run in the order of subscription
+    auto *next = &topic.first;
+    while (*next != NONE) next = &_links[*next].next;
+
+    _links[_link_count] = {subscriber, NONE};
+    *next = _link_count++;
+
+    return true;
+}
+
+void NotificationRouter::_invoke_parameter(const Subscriber &subscriber, void *sender, const AbstractParameter *parameter) {
+    const auto handler = (ParameterHandler) subscriber.handler;
+    handler(subscriber.arg, sender, parameter);
+}
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include <lib/base/metadata.h>
+
+#include "sys_constants.h"
+
+static_assert(NOTIFICATION_TOPIC_COUNT < UINT8_MAX && NOTIFICATION_SUBSCRIBER_COUNT < UINT8_MAX
+              && NOTIFICATION_LINK_COUNT < UINT8_MAX, "Router indices are 8-bit");
+
+typedef void (*ParameterHandler)(void *arg, void *sender, const AbstractParameter *parameter);
+
+// Receives the value of the parameter, the type is checked against the parameter when subscribing
+template<typename T>
+struct ParameterValue {
+    typedef void (*Handler)(void *arg, void *sender, const T &value);
+};
+
+struct NotificationTopic {
+    const AbstractParameter *parameter = nullptr;
+    uint32_t events = 0;
+    uint32_t sampled = 0;           // Events at the previous sample
+    uint16_t rate = 0;              // Events per NOTIFICATION_RATE_INTERVAL
+    uint8_t key = 0;                // Caller-defined id reported with the counters
+    uint8_t first = UINT8_MAX;      // First link, UINT8_MAX if nobody is subscribed
+};
+
+struct NotificationStats {
+    uint32_t events = 0;            // Including unrouted ones
+    uint32_t unrouted = 0;          // Parameters without a topic
+    uint32_t delivered = 0;         // Handler calls
+    uint32_t filtered = 0;          // Skipped, the subscriber is the sender
+    uint32_t overflows = 0;         // Topics, subscribers or links that didn't fit their table
+};
+
+// Delivers parameter changes only to the handlers subscribed to that parameter.
+// Topics and subscriptions are resolved once, when subscribing: a group subscription is linked to every
+// parameter of the group, a typed one is checked against the parameter size. Dispatch is a hash lookup
+// by parameter address followed by the topic's own handler list. Everything lives in fixed arrays
+class NotificationRouter {
+    static constexpr uint8_t NONE = UINT8_MAX;
+
+    // Open addressing, kept at most half full
+    static constexpr uint8_t INDEX_BITS = 8;
+    static constexpr size_t INDEX_SIZE = 1u << INDEX_BITS;
+    static_assert(NOTIFICATION_TOPIC_COUNT * 2 <= INDEX_SIZE, "Topic index is too small");
+
+    struct Subscriber {
+        void (*invoke)(const Subscriber &subscriber, void *sender, const AbstractParameter *parameter);
+        void (*handler)();          // Cast back to the original type by invoke
+        void *arg;
+        const void *ignore_sender;
+    };
+
+    struct Link {
+        uint8_t subscriber;
+        uint8_t next;
+    };
+
+    NotificationTopic _topics[NOTIFICATION_TOPIC_COUNT]{};
+    uint8_t _index[INDEX_SIZE];                                 // Topic by parameter address hash
+    Subscriber _subscribers[NOTIFICATION_SUBSCRIBER_COUNT]{};
+    Link _links[NOTIFICATION_LINK_COUNT]{};
+
+    uint8_t _topic_count = 0;
+    uint8_t _subscriber_count = 0;
+    uint8_t _link_count = 0;
+
+    NotificationStats _stats{};
+
+public:
+    NotificationRouter();
+
+    // Parameters have to be added before subscribing to them, the rest is counted as unrouted
+    bool add_topic(const AbstractParameter *parameter, uint8_t key = 0);
+
+    // Changes sent by `ignore_sender` are not delivered to the handler
+    bool subscribe(const AbstractParameter *parameter, ParameterHandler handler, void *arg,
+                   const void *ignore_sender = nullptr);
+
+    // The parameter is found by its value, false if there is none of this type
+    template<typename T>
+    bool subscribe(const T *value, typename ParameterValue<T>::Handler handler, void *arg,
+                   const void *ignore_sender = nullptr);
+
+    // Every parameter whose value starts within [begin, begin + size), returns the number of them
+    uint8_t subscribe_range(const void *begin, size_t size, ParameterHandler handler, void *arg,
+                            const void *ignore_sender = nullptr);
+
+    void dispatch(void *sender, const AbstractParameter *parameter);
+
+    // Call every NOTIFICATION_RATE_INTERVAL to update the rates
+    void sample();
+
+    [[nodiscard]] inline uint8_t topic_count() const { return _topic_count; }
+    [[nodiscard]] inline const NotificationTopic &topic(uint8_t index) const { return _topics[index]; }
+    [[nodiscard]] inline const NotificationStats &stats() const { return _stats; }
+
+private:
+    static size_t _hash(const AbstractParameter *parameter);
+    NotificationTopic *_find(const AbstractParameter *parameter);
+    NotificationTopic *_find_value(const void *value, size_t size);
+
+    uint8_t _add_subscriber(const Subscriber &subscriber);
+    bool _link(NotificationTopic &topic, uint8_t subscriber);
+
+    static void _invoke_parameter(const Subscriber &subscriber, void *sender, const AbstractParameter *parameter);
+
+    template<typename T>
+    static void _invoke_value(const Subscriber &subscriber, void *sender, const AbstractParameter *parameter);
+};
+
+template<typename T>
+bool NotificationRouter::subscribe(const T *value, typename ParameterValue<T>::Handler handler, void *arg,
+                                   const void *ignore_sender) {
+    static_assert(std::is_trivially_copyable_v<T>, "Values are passed by copy");
+
+    auto topic = _find_value(value, sizeof(T));
+    if (!topic) return false;
+
+    const auto subscriber = _add_subscriber({_invoke_value<T>, (void (*)()) handler, arg, ignore_sender});
+    return subscriber != NONE && _link(*topic, subscriber);
+}
+
+template<typename T>
+void NotificationRouter::_invoke_value(const Subscriber &subscriber, void *sender, const AbstractParameter *parameter) {
+    // Config is packed, the value may be unaligned
+    T value;
+    memcpy(&value, parameter->get_value(), sizeof(T));
+
+    const auto handler = (typename ParameterValue<T>::Handler) subscriber.handler;
+    handler(subscriber.arg, sender, value);
+}
@@ -0,0 +1,175 @@
+#include "subscription_feed.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "lib/debug.h"
+
+bool SubscriptionFeed::add(uint8_t type, const AbstractParameter *parameter) {
+    if (_entry_count == WS_FEED_ENTRY_COUNT) {
+        D_PRINT("Feed: Entry table is full");
+        return false;
+    }
+
+    _entries[_entry_count++] = {parameter, type};
+    return true;
+}
+
+bool SubscriptionFeed::connect(uint32_t client) {
+    if (_find_client(client)) return true;
+
+    for (auto &slot: _clients) {
+        if (slot.active.load(std::memory_order_relaxed)) continue;
+
+        slot.stats = {};
+        slot.stats.id = client;
+        memset(slot.subscribed, 0xff, sizeof(slot.subscribed));
+        for (auto &word: slot.dirty) word.store(0, std::memory_order_relaxed);
+        _mark_all(slot);
+
+        slot.active.store(true, std::memory_order_release);
+        return true;
+    }
+
+    ++_rejected;
+    return false;
+}
+
+void SubscriptionFeed::disconnect(uint32_t client) {
+    if (auto slot = _find_client(client)) slot->active.store(false, std::memory_order_release);
+}
+
+bool SubscriptionFeed::subscribe(uint32_t client, const uint8_t *bitmap, size_t length) {
+    auto slot = _find_client(client);
+    if (!slot) return false;
+
+    memset(slot->subscribed, 0, sizeof(slot->subscribed));
+    memcpy(slot->subscribed, bitmap, std::min(length, sizeof(slot->subscribed)));
+
+    for (auto &word: slot->dirty) word.store(0, std::memory_order_relaxed);
+    _mark_all(*slot);
+
+    return true;
+}
+
+void SubscriptionFeed::changed(const AbstractParameter *parameter) {
+    uint8_t index = 0;
+    while (index < _entry_count && _entries[index].parameter != parameter) ++index;
+    if (index == _entry_count) return;
+
+    _changes.fetch_add(1, std::memory_order_relaxed);
+
+    const uint32_t bit = 1u << (index % 32);
+    for (auto &client: _clients) {
+        if (!client.active.load(std::memory_order_acquire)) continue;
+
+        if (!_subscribed(client, _entries[index].type)) {
+            _skipped.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+
+        if (client.dirty[index / 32].fetch_or(bit, std::memory_order_relaxed) & bit) {
+            _coalesced.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+}
+
+void SubscriptionFeed::flush(uint8_t *frame, size_t size, Sink sink, void *arg) {
+    for (auto &client: _clients) {
+        if (!client.active.load(std::memory_order_acquire)) continue;
+
+        uint32_t pending[DIRTY_WORDS];
+        bool any = false;
+        for (size_t i = 0; i < DIRTY_WORDS; ++i) any |= (pending[i] = client.dirty[i].load(std::memory_order_relaxed)) != 0;
+        if (!any) continue;
+
+        // Values are cleared only after the frame carrying them is taken
+        uint32_t sent[DIRTY_WORDS]{};
+        size_t length = 0;
+        uint32_t values = 0;
+
+        auto send = [&] {
+            if (length > 0 && !sink(arg, client.stats.id, frame, length)) {
+                ++client.stats.refused;
+                return false;
+            }
+
+            for (size_t i = 0; i < DIRTY_WORDS; ++i) {
+                client.dirty[i].fetch_and(~sent[i], std::memory_order_relaxed);
+                sent[i] = 0;
+            }
+
+            if (length > 0) {
+                client.stats.bytes += length;
+                ++client.stats.frames;
+                client.stats.values += values;
+            }
+
+            length = 0;
+            values = 0;
+            return true;
+        };
+
+        bool accepted = true;
+        for (uint8_t index = 0; index < _entry_count && accepted; ++index) {
+            const uint32_t bit = 1u << (index % 32);
+            if (!(pending[index / 32] & bit)) continue;
+
+            const auto &entry = _entries[index];
+            const size_t value_size = entry.parameter->size();
+
+            // Can't be carried, dropped instead of blocking the rest
+            if (value_size > UINT8_MAX || HEADER_SIZE + value_size > size) {
+                sent[index / 32] |= bit;
+                continue;
+            }
+
+            if (length + HEADER_SIZE + value_size > size) accepted = send();
+            if (!accepted) break;
+
+            frame[length++] = entry.type;
+            frame[length++] = (uint8_t) value_size;
+            memcpy(frame + length, entry.parameter->get_value(), value_size);
+            length += value_size;
+
+            sent[index / 32] |= bit;
+            ++values;
+        }
+
+        if (accepted) send();
+    }
+}
+
+FeedStats SubscriptionFeed::stats() const {
+    return {
+        _changes.load(std::memory_order_relaxed),
+        _coalesced.load(std::memory_order_relaxed),
+        _skipped.load(std::memory_order_relaxed),
+        _rejected,
+    };
+}
+
+const FeedClientStats *SubscriptionFeed::client(uint8_t index) const {
+    if (index >= WS_FEED_CLIENT_COUNT || !_clients[index].active.load(std::memory_order_relaxed)) return nullptr;
+    return &_clients[index].stats;
+}
+
+SubscriptionFeed::Client *SubscriptionFeed::_find_client(uint32_t client) {
+    for (auto &slot: _clients) {
+        if (slot.active.load(std::memory_order_relaxed) && slot.stats.id == client) return &slot;
+    }
+
+    return nullptr;
+}
+
+void SubscriptionFeed::_mark_all(Client &client) {
+    for (uint8_t index = 0; index < _entry_count; ++index) {
+        if (_subscribed(client, _entries[index].type)) {
+            client.dirty[index / 32].fetch_or(1u << (index % 32), std::memory_order_relaxed);
+        }
+    }
+}
+
+bool SubscriptionFeed::_subscribed(const Client &client, uint8_t type) const {
+    return client.subscribed[type / 8] & (1u << (type % 8));
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include <lib/base/metadata.h>
+
+#include "sys_constants.h"
+
+struct FeedClientStats {
+    uint32_t id = 0;
+    uint32_t bytes = 0;             // Frame payload sent
+    uint32_t frames = 0;
+    uint32_t values = 0;            // Values sent
+    uint32_t refused = 0;           // Flushes the transport didn't take, the values stay pending
+};
+
+struct FeedStats {
+    uint32_t changes = 0;           // Changes of parameters the feed carries
+    uint32_t coalesced = 0;         // Changes merged into a value still waiting to be sent, per client
+    uint32_t skipped = 0;           // Changes not marked for a client that didn't subscribe to their packet type
+    uint32_t rejected = 0;          // Connections refused, every client slot was taken
+};
+
+// Per-client state feed. Every client subscribes to a set of packet types and gets only those.
+// A change marks the value dirty for the subscribed clients, repeated changes before the next flush
+// are sent once with the latest value. Nothing is encoded for a client that didn't subscribe.
+// A client gets a snapshot of its whole set when it connects and when it replaces its subscription.
+//
+// Frame: a sequence of [type:u8][size:u8][value:size bytes], the value as stored in the parameter.
+// Subscription: BITMAP_SIZE bytes, bit (type % 8) of byte (type / 8) is set for every wanted type.
+//
+// changed() may run in a network callback, the rest is called from the app loop
+class SubscriptionFeed {
+public:
+    static constexpr size_t BITMAP_SIZE = 32;
+
+    // Returns false if the transport can't take the frame now
+    typedef bool (*Sink)(void *arg, uint32_t client, const uint8_t *data, size_t length);
+
+private:
+    static constexpr size_t DIRTY_WORDS = (WS_FEED_ENTRY_COUNT + 31) / 32;
+    static constexpr size_t HEADER_SIZE = 2;
+
+    struct Entry {
+        const AbstractParameter *parameter;
+        uint8_t type;
+    };
+
+    struct Client {
+        std::atomic<bool> active{false};
+        uint8_t subscribed[BITMAP_SIZE]{};
+        std::atomic<uint32_t> dirty[DIRTY_WORDS]{};
+        FeedClientStats stats;
+    };
+
+    Entry _entries[WS_FEED_ENTRY_COUNT]{};
+    uint8_t _entry_count = 0;
+
+    Client _clients[WS_FEED_CLIENT_COUNT]{};
+
+    std::atomic<uint32_t> _changes{0};
+    std::atomic<uint32_t> _coalesced{0};
+    std::atomic<uint32_t> _skipped{0};
+    uint32_t _rejected = 0;
+
+public:
+    // Parameters are added before the first client connects
+    bool add(uint8_t type, const AbstractParameter *parameter);
+
+    // Subscribes the client to every type and queues the snapshot, false if there is no free slot
+    bool connect(uint32_t client);
+    void disconnect(uint32_t client);
+
+    // Replaces the subscription and queues the snapshot of the new set, false for an unknown client
+    bool subscribe(uint32_t client, const uint8_t *bitmap, size_t length);
+
+    void changed(const AbstractParameter *parameter);
+
+    // Sends the pending values of every client in frames of up to `size` bytes.
+    // A client whose sink refuses a frame keeps the values of that frame pending
+    void flush(uint8_t *frame, size_t size, Sink sink, void *arg);
+
+    [[nodiscard]] inline uint8_t entry_count() const { return _entry_count; }
+    [[nodiscard]] FeedStats stats() const;
+
+    // nullptr if the slot is free
+    [[nodiscard]] const FeedClientStats *client(uint8_t index) const;
+
+private:
+    Client *_find_client(uint32_t client);
+    void _mark_all(Client &client);
+    [[nodiscard]] bool _subscribed(const Client &client, uint8_t type) const;
+};
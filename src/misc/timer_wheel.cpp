@@ -0,0 +1,171 @@
+#include "timer_wheel.h"
+
+#include <algorithm>
+#include <climits>
+
+#include <Arduino.h>
+
+static inline uint64_t _rotate_right(uint64_t value, uint8_t shift) {
+    return shift ? (value >> shift) | (value << (64 - shift)) : value;
+}
+
+static inline uint32_t _ticks(unsigned long ms) {
+    return (ms + TIMER_WHEEL_TICK - 1) / TIMER_WHEEL_TICK;
+}
+
+void TimerWheel::begin(unsigned long now) {
+    _time = now;
+}
+
+void TimerWheel::schedule(WheelTimer &timer, unsigned long delay, unsigned long interval) {
+    if (timer.active()) _unlink(timer);
+
+    // Counted from the last processed tick, so the timer never fires before `delay` has passed
+    timer._expires = _now + std::max<uint32_t>(1, _ticks(millis() - _time + delay));
+    timer._interval = interval > 0 ? std::max<uint32_t>(1, _ticks(interval)) : 0;
+
+    _insert(timer);
+}
+
+void TimerWheel::cancel(WheelTimer &timer) {
+    if (timer.active()) _unlink(timer);
+}
+
+void TimerWheel::update(unsigned long now) {
+    uint32_t pending = (now - _time) / TIMER_WHEEL_TICK;
+
+    while (pending > 0) {
+        // Nothing happens until the next event, jump over the empty stretch
+        const uint32_t skip = std::min(pending, _next_event()) - 1;
+        _now += skip;
+        _time += skip * TIMER_WHEEL_TICK;
+        pending -= skip;
+
+        ++_now;
+        _time += TIMER_WHEEL_TICK;
+        --pending;
+        ++_stats.ticks;
+
+        // A level moves down when every level below it wraps around
+        for (uint8_t level = 1; level < TIMER_WHEEL_LEVELS; ++level) {
+            if (_now & ((1ul << (TIMER_WHEEL_SLOT_BITS * level)) - 1)) break;
+            _cascade(level);
+        }
+
+        _expire();
+    }
+}
+
+unsigned long TimerWheel::next_deadline(unsigned long now) const {
+    const uint32_t ticks = _next_event();
+    if (ticks == UINT32_MAX) return ULONG_MAX;
+
+    const unsigned long deadline = _time + ticks * TIMER_WHEEL_TICK;
+    return (long) (deadline - now) > 0 ? deadline - now : 0;
+}
+
+void TimerWheel::_insert(WheelTimer &timer) {
+    // Deltas past the range wait in the farthest top level slot and get placed again when it moves down
+    const uint32_t delta = std::min<uint32_t>(timer._expires - _now, RANGE - 1);
+    const uint32_t position = _now + delta;
+
+    uint8_t level = 0;
+    while (level + 1u < TIMER_WHEEL_LEVELS && delta >= (1ul << (TIMER_WHEEL_SLOT_BITS * (level + 1)))) ++level;
+
+    timer._level = level;
+    timer._slot = (position >> (TIMER_WHEEL_SLOT_BITS * level)) & SLOT_MASK;
+
+    auto &head = _slots[level][timer._slot];
+    timer._prev = nullptr;
+    timer._next = head;
+    if (head) head->_prev = &timer;
+    head = &timer;
+
+    _occupied[level] |= 1ull << timer._slot;
+    ++_size;
+}
+
+void TimerWheel::_unlink(WheelTimer &timer) {
+    auto &head = _head(timer);
+
+    if (timer._prev) timer._prev->_next = timer._next;
+    else head = timer._next;
+
+    if (timer._next) timer._next->_prev = timer._prev;
+
+    if (!head && timer._level < TIMER_WHEEL_LEVELS) _occupied[timer._level] &= ~(1ull << timer._slot);
+
+    timer._prev = nullptr;
+    timer._next = nullptr;
+    timer._level = WheelTimer::INACTIVE;
+    --_size;
+}
+
+WheelTimer *&TimerWheel::_head(const WheelTimer &timer) {
+    return timer._level == TIMER_WHEEL_LEVELS ? _expiring : _slots[timer._level][timer._slot];
+}
+
+void TimerWheel::_cascade(uint8_t level) {
+    const uint8_t slot = (_now >> (TIMER_WHEEL_SLOT_BITS * level)) & SLOT_MASK;
+
+    WheelTimer *timer = _slots[level][slot];
+    _slots[level][slot] = nullptr;
+    _occupied[level] &= ~(1ull << slot);
+
+    while (timer) {
+        WheelTimer *next = timer->_next;
+
+        --_size;
+        _insert(*timer);
+        ++_stats.cascaded;
+
+        timer = next;
+    }
+}
+
+void TimerWheel::_expire() {
+    const uint8_t slot = _now & SLOT_MASK;
+    if (!(_occupied[0] & (1ull << slot))) return;
+
+    // Detached first: callbacks may schedule into this slot or cancel timers that are about to fire
+    _expiring = _slots[0][slot];
+    _slots[0][slot] = nullptr;
+    _occupied[0] &= ~(1ull << slot);
+
+    for (auto timer = _expiring; timer; timer = timer->_next) timer->_level = TIMER_WHEEL_LEVELS;
+
+    while (_expiring) {
+        auto &timer = *_expiring;
+        _unlink(timer);
+
+        if (timer._interval > 0) {
+            timer._expires = _now + timer._interval;
+            _insert(timer);
+        }
+
+        ++_stats.fired;
+        timer._callback(timer._arg);
+    }
+}
+
+uint32_t TimerWheel::_next_event() const {
+    uint32_t result = UINT32_MAX;
+
+    if (_occupied[0]) {
+        const uint8_t from = (_now + 1) & SLOT_MASK;
+        result = __builtin_ctzll(_rotate_right(_occupied[0], from)) + 1;
+    }
+
+    for (uint8_t level = 1; level < TIMER_WHEEL_LEVELS; ++level) {
+        if (!_occupied[level]) continue;
+
+        // The first slot to move down, at the start of its block
+        const uint8_t shift = TIMER_WHEEL_SLOT_BITS * level;
+        const uint32_t block = (_now >> shift) + 1;
+        const uint32_t distance = __builtin_ctzll(_rotate_right(_occupied[level], block & SLOT_MASK));
+
+        result = std::min(result, ((block + distance) << shift) - _now);
+    }
+
+    return result;
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "sys_constants.h"
+
+typedef void (*WheelTimerCallback)(void *arg);
+
+struct TimerWheelStats {
+    uint32_t fired = 0;
+    uint32_t cascaded = 0;          // Timers moved down a level
+    uint32_t ticks = 0;             // Ticks processed one by one, empty stretches are skipped
+};
+
+// Node of the wheel, owned by the caller, so scheduling never allocates.
+// A scheduled timer must stay in place until it fires (one-shot) or is cancelled
+class WheelTimer {
+    friend class TimerWheel;
+
+    static constexpr uint8_t INACTIVE = UINT8_MAX;
+
+    WheelTimer *_prev = nullptr;
+    WheelTimer *_next = nullptr;
+
+    uint32_t _expires = 0;          // Tick
+    uint32_t _interval = 0;         // Ticks, 0 for one-shot
+    uint8_t _level = INACTIVE;      // TIMER_WHEEL_LEVELS while in the list being fired
+    uint8_t _slot = 0;
+
+    WheelTimerCallback _callback;
+    void *_arg;
+
+public:
+    WheelTimer(WheelTimerCallback callback, void *arg) : _callback(callback), _arg(arg) {}
+
+    WheelTimer(const WheelTimer &) = delete;
+    WheelTimer &operator=(const WheelTimer &) = delete;
+
+    [[nodiscard]] inline bool active() const { return _level != INACTIVE; }
+};
+
+// Hierarchical timing wheel (Varghese & Lauck), TIMER_WHEEL_LEVELS levels of 2^TIMER_WHEEL_SLOT_BITS slots.
+// Level 0 holds timers due within one rotation, one slot per tick; each next level covers a whole rotation
+// of the previous one per slot, and its slot is moved down when the lower level wraps around to it.
+// Schedule and cancel are O(1), every expiry is O(1) plus at most one move per level over the timer's life.
+// Callbacks may schedule or cancel any timer, including the one that is firing
+class TimerWheel {
+    static constexpr uint8_t SLOT_COUNT = 1u << TIMER_WHEEL_SLOT_BITS;
+    static constexpr uint8_t SLOT_MASK = SLOT_COUNT - 1;
+    static constexpr uint32_t RANGE = 1ul << (TIMER_WHEEL_SLOT_BITS * TIMER_WHEEL_LEVELS);
+
+    static_assert(SLOT_COUNT == 64, "Slot occupancy is a 64-bit mask");
+    static_assert(TIMER_WHEEL_SLOT_BITS * TIMER_WHEEL_LEVELS <= 30, "Wheel range must fit the tick counter");
+
+    WheelTimer *_slots[TIMER_WHEEL_LEVELS][SLOT_COUNT]{};
+    uint64_t _occupied[TIMER_WHEEL_LEVELS]{};     // Bit per non-empty slot
+    WheelTimer *_expiring = nullptr;
+
+    uint32_t _now = 0;              // Last processed tick
+    unsigned long _time = 0;        // millis() of the last processed tick
+    size_t _size = 0;
+
+    TimerWheelStats _stats{};
+
+public:
+    void begin(unsigned long now);
+
+    // Fires after `delay` ms, then every `interval` ms if it is not 0. Rescheduling an active timer moves it
+    void schedule(WheelTimer &timer, unsigned long delay, unsigned long interval = 0);
+    void cancel(WheelTimer &timer);
+
+    // Processes every tick up to `now`, fires the due timers
+    void update(unsigned long now);
+
+    // Time until the wheel has work to do: a timer fires or a slot moves down. ULONG_MAX if empty.
+    // Never later than the next expiry, so a loop may sleep for that long
+    [[nodiscard]] unsigned long next_deadline(unsigned long now) const;
+
+    [[nodiscard]] inline size_t size() const { return _size; }
+    [[nodiscard]] inline const TimerWheelStats &stats() const { return _stats; }
+
+private:
+    void _insert(WheelTimer &timer);
+    void _unlink(WheelTimer &timer);
+    WheelTimer *&_head(const WheelTimer &timer);
+    void _cascade(uint8_t level);
+    void _expire();
+
+    // Ticks from _now until a timer fires or a slot moves down, UINT32_MAX if empty
+    [[nodiscard]] uint32_t _next_event() const;
+};
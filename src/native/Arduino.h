@@ -0,0 +1,58 @@
+#pragma once
+
+// Minimal Arduino API for the `native` environment, backed by the simulated HAL (see hal.h)
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+using std::min;
+using std::max;
+
+#define LOW                 (0x0)
+#define HIGH                (0x1)
+
+#define INPUT               (0x00)
+#define OUTPUT              (0x01)
+#define INPUT_PULLUP        (0x02)
+
+#define RISING              (0x01)
+#define FALLING             (0x02)
+#define CHANGE              (0x03)
+
+#define PROGMEM
+#define IRAM_ATTR
+
+#define pgm_read_byte(addr)     (*(const uint8_t *) (addr))
+#define pgm_read_word(addr)     (*(const uint16_t *) (addr))
+#define pgm_read_dword(addr)    (*(const uint32_t *) (addr))
+
+// IPv4 only, as much as the app uses
+class IPAddress {
+    uint32_t _address = 0;
+
+public:
+    IPAddress() = default;
+    explicit IPAddress(uint32_t address) : _address(address) {}
+
+    operator uint32_t() const { return _address; }
+};
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+
+int digitalPinToInterrupt(uint8_t pin);
+void attachInterruptArg(uint8_t interrupt, void (*fn)(void *), void *arg, int mode);
+void detachInterrupt(uint8_t interrupt);
+
+void analogWrite(uint8_t pin, int value);
+void analogWriteResolution(int resolution);
+void analogWriteFreq(uint32_t frequency);
+void analogWriteFrequency(uint32_t frequency);
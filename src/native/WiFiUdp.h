@@ -0,0 +1,35 @@
+#pragma once
+
+// Minimal WiFiUDP for the `native` environment. Sent datagrams are passed to the responder
+// of the simulated network, see SimulatedHal::set_udp_responder(). Buffers are fixed, as lwIP pbufs are
+// allocated outside the application heap accounting
+
+#include <cstddef>
+#include <cstdint>
+
+#include <Arduino.h>
+
+class WiFiUDP {
+public:
+    static constexpr size_t PACKET_SIZE = 128;
+
+private:
+    uint8_t _out[PACKET_SIZE]{};
+    size_t _out_length = 0;
+
+    uint8_t _in[PACKET_SIZE]{};
+    size_t _in_length = 0;
+    size_t _in_position = 0;
+
+public:
+    uint8_t begin(uint16_t port);
+    void stop();
+
+    int beginPacket(const char *host, uint16_t port);
+    int beginPacket(IPAddress address, uint16_t port);
+    size_t write(const uint8_t *data, size_t length);
+    int endPacket();
+
+    int parsePacket();
+    int read(uint8_t *data, size_t length);
+};
@@ -0,0 +1,129 @@
+#include <Arduino.h>
+
+#include <deque>
+
+#include "hal.h"
+#include "simulation.h"
+
+#include "network/admission.h"
+
+static constexpr unsigned long STEP_MS = 10;
+static constexpr unsigned long SIMULATION_MS = 60 * 1000;
+
+static constexpr uint32_t DASHBOARD = 0x0A00000Au;
+static constexpr uint32_t SPAMMER = 0x0A00000Bu;
+
+struct ClientLoad {
+    uint32_t client;
+    unsigned long interval;         // Between requests, ms
+    unsigned long duration;         // Until the response is sent, ms
+
+    uint32_t sent = 0;
+    uint32_t accepted = 0;
+    uint32_t rate_limited = 0;
+    uint32_t overloaded = 0;
+};
+
+struct AdmissionScenario {
+    const char *name;
+
+    unsigned long spam_interval;
+    unsigned long spam_duration;
+
+    unsigned long low_heap_from;    // Free heap is below the limit in [from, to)
+    unsigned long low_heap_to;
+};
+
+static constexpr AdmissionScenario ADMISSION_SCENARIOS[] = {
+    {"idle", 0, 0, 0, 0},
+    {"spam 50/s", 20, 30, 0, 0},
+    {"spam slow", 20, 5000, 0, 0},
+    {"low heap", 0, 0, 20000, 25000},
+};
+
+static bool simulate_admission(const AdmissionScenario &scenario) {
+    SimulatedHal::reset();
+
+    AdmissionControl admission;
+    std::deque<std::pair<unsigned long, uint32_t>> in_flight;     // Finish time, client
+
+    ClientLoad loads[] = {
+        {DASHBOARD, 1000, 30},
+        {SPAMMER, scenario.spam_interval, scenario.spam_duration},
+    };
+
+    // Rotating clients that exceed the table, each within the rate limit
+    ClientLoad roaming{0, 250, 30};
+
+    for (unsigned long time = 0; time < SIMULATION_MS; time += STEP_MS) {
+        SimulatedHal::advance_millis(STEP_MS);
+
+        while (!in_flight.empty() && in_flight.front().first <= millis()) {
+            admission.release(in_flight.front().second);
+            in_flight.pop_front();
+        }
+
+        const bool low_heap = time >= scenario.low_heap_from && time < scenario.low_heap_to;
+        const uint32_t free_heap = low_heap ? ADMISSION_MIN_FREE_HEAP - 1 : 40000;
+
+        auto request = [&](ClientLoad &load, uint32_t client) {
+            ++load.sent;
+
+            switch (admission.admit(client, free_heap)) {
+                case Admission::ACCEPT: {
+                    ++load.accepted;
+
+                    // Requests of different durations finish out of order, keep the queue sorted
+                    const std::pair<unsigned long, uint32_t> item{millis() + load.duration, client};
+                    in_flight.insert(std::upper_bound(in_flight.begin(), in_flight.end(), item), item);
+                    break;
+                }
+
+                case Admission::RATE_LIMITED:
+                    ++load.rate_limited;
+                    break;
+
+                case Admission::OVERLOADED:
+                    ++load.overloaded;
+                    break;
+            }
+        };
+
+        for (auto &load: loads) {
+            if (load.interval > 0 && time % load.interval == 0) request(load, load.client);
+        }
+
+        if (time % roaming.interval == 0) {
+            request(roaming, 0x0A000100u + (roaming.sent % (2 * ADMISSION_CLIENT_SLOTS)));
+        }
+    }
+
+    const auto &dashboard = loads[0];
+    const auto &spammer = loads[1];
+    const auto &stats = admission.stats();
+
+    // The spammer gets its burst plus the refill rate, the dashboard is never rate limited
+    const uint32_t spam_limit = ADMISSION_BURST + ADMISSION_RATE * SIMULATION_MS / 1000;
+    const uint32_t low_heap_requests = (scenario.low_heap_to - scenario.low_heap_from) / dashboard.interval;
+
+    // A slow spammer holds at most its share of in-flight slots, so other clients still get through
+    const bool success = dashboard.rate_limited == 0 && roaming.rate_limited == 0 && spammer.accepted <= spam_limit
+                         && dashboard.overloaded == low_heap_requests && stats.max_in_flight <= ADMISSION_MAX_IN_FLIGHT;
+
+    printf("%-10s %s  dashboard: %3u/%-3u  roaming: %3u/%-3u  spammer: %4u/%-4u (limit %u)"
+           "  429: %4u  503 in flight: %4u  503 heap: %2u  max in flight: %u\n",
+        scenario.name, success ? "OK  " : "FAIL", dashboard.accepted, dashboard.sent, roaming.accepted, roaming.sent,
+        spammer.accepted, spammer.sent, spam_limit, stats.rate_limited, stats.shed_in_flight, stats.shed_heap,
+        stats.max_in_flight);
+
+    return success;
+}
+
+int run_admission_simulation() {
+    int result = 0;
+    for (const auto &scenario: ADMISSION_SCENARIOS) {
+        if (!simulate_admission(scenario)) result = 1;
+    }
+
+    return result;
+}
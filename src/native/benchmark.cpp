@@ -0,0 +1,204 @@
+#include <chrono>
+#include <cstdlib>
+
+#include <Arduino.h>
+
+#include "hal.h"
+#include "simulation.h"
+
+#include "app/dispatch.h"
+#include "misc/led.h"
+#include "utils/color.h"
+#include "utils/math.h"
+
+// Results are compared against the committed baseline: a kernel fails if it allocates more
+// or becomes slower than baseline by BENCH_THRESHOLD (plus small absolute slack for sub-ns kernels).
+// A kernel without a baseline fails too. Set BENCH_UPDATE=1 to rewrite the baseline
+
+static constexpr const char *BENCH_BASELINE_NAME = "bench_baseline.json";     // Next to this file
+static constexpr const char *BENCH_RESULT_PATH = "bench_result.json";
+static constexpr double BENCH_THRESHOLD = 2.0;
+static constexpr double BENCH_SLACK_NS = 1.0;
+static constexpr uint32_t BENCH_ITERATIONS = 2000000;
+static constexpr uint8_t BENCH_MAX_KERNELS = 16;
+
+struct BenchResult {
+    const char *name;
+    double ns_per_op;
+    uint64_t allocations;
+};
+
+static volatile uint32_t _sink = 0;
+
+// Defined by the application on the device
+const PropertyActionTable PROPERTY_ACTION_TABLE PROGMEM = build_property_action_table();
+static Config _dispatch_config;
+
+static uint8_t *_dispatch_value(size_t offset) {
+    return (uint8_t *) &_dispatch_config + offset;
+}
+
+template<typename Fn>
+static BenchResult _measure(const char *name, Fn &&fn, uint32_t iterations = BENCH_ITERATIONS) {
+    // Warm-up, also lets lazily initialized state allocate before counting
+    for (uint32_t i = 0; i < iterations / 10; ++i) _sink = _sink + fn(i);
+
+    const auto allocations = SimulatedHal::allocation_count();
+    const auto start = std::chrono::steady_clock::now();
+
+    uint32_t acc = 0;
+    for (uint32_t i = 0; i < iterations; ++i) acc += fn(i);
+
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    _sink = _sink + acc;
+
+    const auto ns = (double) std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+    return {name, ns / iterations, SimulatedHal::allocation_count() - allocations};
+}
+
+// Resolved against the source file, so the baseline is found whatever the working directory.
+// The build may pass BENCH_BASELINE_DIR when it compiles with paths relative to the project
+static const char *_baseline_path() {
+    static char path[512];
+    if (path[0]) return path;
+
+#ifdef BENCH_BASELINE_DIR
+    snprintf(path, sizeof(path), "%s/%s", BENCH_BASELINE_DIR, BENCH_BASELINE_NAME);
+#else
+    const char *slash = strrchr(__FILE__, '/');
+    const size_t directory = slash ? slash - __FILE__ + 1 : 0;
+    snprintf(path, sizeof(path), "%.*s%s", (int) directory, __FILE__, BENCH_BASELINE_NAME);
+#endif
+
+    return path;
+}
+
+static bool _read_baseline(const char *name, double &ns_per_op, uint64_t &allocations) {
+    FILE *file = fopen(_baseline_path(), "r");
+    if (!file) return false;
+
+    char line[256];
+    char key[64];
+    bool found = false;
+    while (!found && fgets(line, sizeof(line), file)) {
+        double ns;
+        unsigned long long allocs;
+        if (sscanf(line, " \"%63[^\"]\": {\"ns\": %lf, \"allocs\": %llu}", key, &ns, &allocs) == 3
+            && strcmp(key, name) == 0) {
+            ns_per_op = ns;
+            allocations = allocs;
+            found = true;
+        }
+    }
+
+    fclose(file);
+    return found;
+}
+
+static void _write_results(const char *path, const BenchResult *results, size_t count) {
+    FILE *file = fopen(path, "w");
+    if (!file) {
+        printf("Unable to write %s\n", path);
+        return;
+    }
+
+    fprintf(file, "{\n");
+    for (size_t i = 0; i < count; ++i) {
+        fprintf(file, "  \"%s\": {\"ns\": %.2f, \"allocs\": %llu}%s\n", results[i].name, results[i].ns_per_op,
+            (unsigned long long) results[i].allocations, i + 1 < count ? "," : "");
+    }
+    fprintf(file, "}\n");
+
+    fclose(file);
+}
+
+int run_benchmarks() {
+    BenchResult results[BENCH_MAX_KERNELS];
+    size_t count = 0;
+
+    results[count++] = _measure("smooth16", [](uint32_t i) {
+        return smooth16(i & 0x3fff, ~i & 0x3fff, (float) (i & 0xff) / 255);
+    });
+
+    results[count++] = _measure("ease_quad16", [](uint32_t i) {
+        return ease_quad16(i & 0x3fff, PWM_MAX_VALUE);
+    });
+
+    results[count++] = _measure("quad_wave16", [](uint32_t i) {
+        return quad_wave16(i & 0x3fff, PWM_MAX_VALUE);
+    });
+
+    results[count++] = _measure("map16", [](uint32_t i) {
+        return map16(i & 0x3fff, PWM_MAX_VALUE, 100);
+    });
+
+    results[count++] = _measure("temperature_to_rgb", [](uint32_t i) {
+        return temperature_to_rgb(LED_MIN_TEMPERATURE + i % (LED_MAX_TEMPERATURE - LED_MIN_TEMPERATURE));
+    }, BENCH_ITERATIONS / 10);
+
+    // Brightness log curve
+    PwmLedController<PwmDefault> single(LED_R_PIN);
+    results[count++] = _measure("led_brightness", [&](uint32_t i) {
+        single.set_brightness(i & 0x3fff);
+        return (uint32_t) single.brightness();
+    });
+
+    // Color conversion: calibration + gamma for every channel
+    PwmLedController<PwmDefault> rgb(LED_R_PIN, LED_G_PIN, LED_B_PIN);
+    results[count++] = _measure("led_color", [&](uint32_t i) {
+        rgb.set_color({(uint16_t) i, (uint16_t) (i * 3), (uint16_t) (i * 7)});
+        return (uint32_t) SimulatedHal::duty(LED_R_PIN);
+    }, BENCH_ITERATIONS / 10);
+
+    // Changed parameter to its handler: main light, nested structs and zone state
+    // Only the address matters to the lookup, Config is packed and the values may be unaligned
+    Parameter<uint8_t> power(_dispatch_value(offsetof(Config, power)));
+    Parameter<uint8_t> brightness(_dispatch_value(offsetof(Config, brightness)));
+    Parameter<uint8_t> color(_dispatch_value(offsetof(Config, color)));
+    Parameter<uint8_t> night_brightness(_dispatch_value(offsetof(Config, night_mode.brightness)));
+    Parameter<uint8_t> power_change_timeout(_dispatch_value(offsetof(Config, sys_config.power_change_timeout)));
+    Parameter<uint8_t> preset_color(_dispatch_value(offsetof(Config, presets.items[1].color)));
+    Parameter<uint8_t> zone_brightness(_dispatch_value(offsetof(Config, zones.items[1].state.brightness)));
+    Parameter<uint8_t> zone_pin(_dispatch_value(offsetof(Config, zones.items[2].sys_config.led_r_pin)));
+
+    const AbstractParameter *dispatch_parameters[] = {
+        &power, &brightness, &color, &night_brightness, &power_change_timeout, &preset_color, &zone_brightness, &zone_pin
+    };
+
+    results[count++] = _measure("dispatch", [&](uint32_t i) {
+        const auto parameter = dispatch_parameters[i % std::size(dispatch_parameters)];
+        return (uint32_t) property_action(_dispatch_config, parameter) + property_zone(_dispatch_config, parameter);
+    });
+
+    const bool update = getenv("BENCH_UPDATE") != nullptr;
+    bool success = true;
+
+    for (size_t i = 0; i < count; ++i) {
+        const auto &result = results[i];
+
+        double baseline_ns = 0;
+        uint64_t baseline_allocations = 0;
+        const bool has_baseline = _read_baseline(result.name, baseline_ns, baseline_allocations);
+
+        const char *status = update ? "NEW " : "FAIL";
+        if (has_baseline) {
+            const bool slower = result.ns_per_op > baseline_ns * BENCH_THRESHOLD + BENCH_SLACK_NS;
+            const bool allocates = result.allocations > baseline_allocations;
+
+            status = slower || allocates ? "FAIL" : "OK  ";
+            if (!update) success &= !slower && !allocates;
+        } else if (!update) {
+            success = false;
+        }
+
+        printf("%-20s %s %9.2f ns/op  (baseline %9.2f)  allocs: %llu\n", result.name, status, result.ns_per_op,
+            baseline_ns, (unsigned long long) result.allocations);
+    }
+
+    if (!update && !success) printf("Baseline: %s, run with BENCH_UPDATE=1 to add missing kernels\n", _baseline_path());
+
+    _write_results(BENCH_RESULT_PATH, results, count);
+    if (update) _write_results(_baseline_path(), results, count);
+
+    return success ? 0 : 1;
+}
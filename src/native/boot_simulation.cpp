@@ -0,0 +1,83 @@
+#include <Arduino.h>
+
+#include "hal.h"
+#include "simulation.h"
+
+#include "misc/led.h"
+
+static constexpr uint8_t PINS[] = {LED_R_PIN, LED_G_PIN, LED_B_PIN};
+
+struct BootCase {
+    const char *name;
+    LedType led_type;
+    uint8_t channels;
+    bool power;
+};
+
+static constexpr BootCase CASES[] = {
+    {"SINGLE full", LedType::SINGLE, 1, true},
+    {"CCT full", LedType::CCT, 2, true},
+    {"RGB full white", LedType::RGB, 3, true},
+    {"RGB off", LedType::RGB, 3, false},
+};
+
+struct ProfileCase {
+    const char *name;
+    PwmProfile profile;
+};
+
+static constexpr ProfileCase PROFILES[] = {
+    {"default", PwmProfile::DEFAULT},
+    {"high resolution", PwmProfile::HIGH_RESOLUTION},
+    {"high frequency", PwmProfile::HIGH_FREQUENCY},
+};
+
+// Same order as Application::load(): color, then brightness
+static void restore(LedController &led, const Config &config) {
+    led.set_calibration(config.calibration_16);
+    led.set_color(config.color_16);
+    led.set_temperature(config.color_temperature);
+    led.set_brightness(config.power ? PWM_MAX_VALUE : PIN_DISABLED);
+}
+
+// Saved state equals the controller defaults: full brightness, white, default temperature.
+// The restored output has to match the one reached by changing the brightness afterwards
+static bool check_boot(const BootCase &boot, const ProfileCase &profile) {
+    SimulatedHal::reset();
+
+    Config config;
+    config.power = boot.power;
+
+    LedControllerSlot led;
+    led.create(boot.led_type, LED_R_PIN, LED_G_PIN, LED_B_PIN, profile.profile).begin();
+    restore(*led, config);
+
+    const auto writes = SimulatedHal::write_count();
+
+    int restored[3] = {}, lit = 0;
+    for (uint8_t i = 0; i < boot.channels; ++i) {
+        restored[i] = SimulatedHal::duty(PINS[i]);
+        lit += restored[i];
+    }
+
+    led->set_brightness(config.power ? 0 : PWM_MAX_VALUE);
+    led->set_brightness(config.power ? PWM_MAX_VALUE : 0);
+
+    uint8_t mismatches = 0;
+    for (uint8_t i = 0; i < boot.channels; ++i) mismatches += restored[i] != SimulatedHal::duty(PINS[i]);
+
+    const bool success = writes > 0 && mismatches == 0 && (lit > 0) == boot.power;
+    printf("%-16s %-16s %s  writes: %2u  duty: %5d %5d %5d\n", boot.name, profile.name,
+        success ? "OK  " : "FAIL", (unsigned) writes, restored[0], restored[1], restored[2]);
+
+    return success;
+}
+
+int run_boot_simulation() {
+    bool success = true;
+    for (const auto &boot: CASES) {
+        for (const auto &profile: PROFILES) success &= check_boot(boot, profile);
+    }
+
+    return success ? 0 : 1;
+}
@@ -0,0 +1,133 @@
+#include <Arduino.h>
+
+#include <vector>
+
+#include "hal.h"
+#include "simulation.h"
+
+#include "misc/gesture_button.h"
+
+static constexpr uint8_t BUTTON_PIN = 13;
+static constexpr unsigned long STEP_MS = 10;
+
+struct ButtonEvent {
+    ButtonGesture gesture;
+    uint8_t count;
+
+    bool operator==(const ButtonEvent &other) const { return gesture == other.gesture && count == other.count; }
+};
+
+struct Press {
+    unsigned long at;           // ms from the scenario start
+    unsigned long duration;     // ms
+    uint8_t bounces;            // Extra edge pairs, 1 ms apart, on both press and release
+};
+
+struct ButtonScenario {
+    const char *name;
+    std::vector<Press> presses;
+    std::vector<ButtonEvent> expected;
+};
+
+static const char *gesture_name(ButtonGesture gesture) {
+    switch (gesture) {
+        case ButtonGesture::CLICK: return "CLICK";
+        case ButtonGesture::HOLD: return "HOLD";
+        case ButtonGesture::HOLD_REPEAT: return "HOLD_REPEAT";
+        case ButtonGesture::HOLD_RELEASE: return "HOLD_RELEASE";
+    }
+
+    return "?";
+}
+
+static void bounce(uint8_t count, bool level) {
+    for (uint8_t i = 0; i < count; ++i) {
+        SimulatedHal::set_input(BUTTON_PIN, level);
+        SimulatedHal::advance_millis(1);
+        SimulatedHal::set_input(BUTTON_PIN, !level);
+        SimulatedHal::advance_millis(1);
+    }
+
+    SimulatedHal::set_input(BUTTON_PIN, level);
+}
+
+static bool simulate_button(const ButtonScenario &scenario) {
+    SimulatedHal::reset();
+
+    std::vector<ButtonEvent> events;
+    uint32_t idle_handles = 0;
+    uint32_t busy_handles = 0;
+
+    GestureButton button(BUTTON_PIN, true);
+    button.set_on_gesture([&](auto gesture, auto count) {
+        // Only report the first hold repeat, their number depends on the hold duration
+        if (gesture == ButtonGesture::HOLD_REPEAT && !events.empty() && events.back().gesture == gesture) return;
+        events.push_back({gesture, count});
+    });
+
+    button.begin();
+
+    const auto &last = scenario.presses.back();
+    const unsigned long end = last.at + last.duration + 1000;
+
+    size_t next = 0;
+    unsigned long release_at = 0;
+    bool pressed = false;
+
+    for (unsigned long t = 0; t < end; t += STEP_MS) {
+        if (pressed && t >= release_at) {
+            bounce(scenario.presses[next - 1].bounces, false);
+            pressed = false;
+        }
+
+        if (!pressed && next < scenario.presses.size() && t >= scenario.presses[next].at) {
+            bounce(scenario.presses[next].bounces, true);
+            release_at = t + scenario.presses[next].duration;
+            pressed = true;
+            ++next;
+        }
+
+        // As the app loop does: the button is skipped until it has something to do
+        if (button.pending()) {
+            ++busy_handles;
+            button.handle();
+        } else {
+            ++idle_handles;
+        }
+
+        SimulatedHal::set_millis(t + STEP_MS);
+    }
+
+    const bool success = events == scenario.expected && button.edge_overflow() == 0;
+
+    printf("%-24s %s  idle ticks: %4u  busy ticks: %4u  events:", scenario.name, success ? "OK  " : "FAIL",
+        idle_handles, busy_handles);
+    for (const auto &event: events) printf(" %s x%u", gesture_name(event.gesture), event.count);
+    printf("\n");
+
+    return success;
+}
+
+int run_button_simulation() {
+    const ButtonScenario scenarios[] = {
+        {"single click", {{100, 80, 0}}, {{ButtonGesture::CLICK, 1}}},
+        {"double click", {{100, 80, 0}, {250, 80, 0}}, {{ButtonGesture::CLICK, 2}}},
+        {"triple click", {{100, 80, 0}, {250, 80, 0}, {400, 80, 0}}, {{ButtonGesture::CLICK, 3}}},
+        {"bouncy click", {{100, 80, 3}}, {{ButtonGesture::CLICK, 1}}},
+        {"bouncy double click", {{100, 80, 4}, {250, 80, 4}}, {{ButtonGesture::CLICK, 2}}},
+        {"two single clicks", {{100, 80, 0}, {800, 80, 0}}, {{ButtonGesture::CLICK, 1}, {ButtonGesture::CLICK, 1}}},
+        {"hold", {{100, 1500, 2}}, {
+            {ButtonGesture::HOLD, 1}, {ButtonGesture::HOLD_REPEAT, 1}, {ButtonGesture::HOLD_RELEASE, 1}
+        }},
+        {"click and hold", {{100, 80, 0}, {250, 1500, 0}}, {
+            {ButtonGesture::HOLD, 2}, {ButtonGesture::HOLD_REPEAT, 2}, {ButtonGesture::HOLD_RELEASE, 2}
+        }},
+    };
+
+    int result = 0;
+    for (const auto &scenario: scenarios) {
+        if (!simulate_button(scenario)) result = 1;
+    }
+
+    return result;
+}
@@ -0,0 +1,195 @@
+#include <Arduino.h>
+
+#include <chrono>
+#include <cstring>
+
+#include "hal.h"
+#include "simulation.h"
+
+#include "misc/subscription_feed.h"
+
+static constexpr uint8_t FIELD_COUNT = 48;
+static constexpr uint32_t EVENT_COUNT = 200000;
+static constexpr uint32_t FLUSH_EVERY = 8;              // Changes between flushes, ~ a ramp step per service tick
+static constexpr size_t FRAME_SIZE = WS_MAX_PACKET_SIZE;
+
+// Packet types: the first two are power and brightness, then a night mode group, then settings
+static constexpr uint8_t TYPE_BASE = 0x01;
+static constexpr uint8_t NIGHT_BEGIN = 8;
+static constexpr uint8_t NIGHT_SIZE = 5;
+
+static uint32_t random_state = 0x51ed270b;
+
+static uint32_t next_random() {
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 17;
+    random_state ^= random_state << 5;
+    return random_state;
+}
+
+static uint32_t fields[FIELD_COUNT];
+static Parameter<uint32_t> *parameters[FIELD_COUNT];
+
+// What a client has seen: the latest value of every type, and anything it shouldn't have got
+struct FeedClient {
+    const char *name;
+    uint32_t id;
+    uint8_t bitmap[SubscriptionFeed::BITMAP_SIZE];
+
+    bool refuse_odd = false;    // Transport full on every other flush
+    uint32_t flushes = 0;
+
+    uint32_t values[FIELD_COUNT]{};
+    bool received[FIELD_COUNT]{};
+    uint32_t unwanted = 0;
+    uint32_t malformed = 0;
+    uint64_t broadcast_bytes = 0;   // Every change encoded for this client
+
+    void want(uint8_t first, uint8_t count) {
+        for (uint8_t i = first; i < first + count; ++i) {
+            const uint8_t type = TYPE_BASE + i;
+            bitmap[type / 8] |= 1u << (type % 8);
+        }
+    }
+
+    [[nodiscard]] bool wants(uint8_t field) const {
+        const uint8_t type = TYPE_BASE + field;
+        return bitmap[type / 8] & (1u << (type % 8));
+    }
+};
+
+static FeedClient *clients[3];
+
+static bool receive(void *, uint32_t id, const uint8_t *data, size_t length) {
+    FeedClient *client = nullptr;
+    for (auto item: clients) if (item && item->id == id) client = item;
+    if (!client) return false;
+
+    if (client->refuse_odd && client->flushes++ % 2 == 1) return false;
+
+    for (size_t pos = 0; pos < length;) {
+        if (pos + 2 > length || data[pos] < TYPE_BASE || data[pos] >= TYPE_BASE + FIELD_COUNT
+            || data[pos + 1] != sizeof(uint32_t) || pos + 2 + data[pos + 1] > length) {
+            ++client->malformed;
+            return true;
+        }
+
+        const uint8_t field = data[pos] - TYPE_BASE;
+        if (!client->wants(field)) ++client->unwanted;
+
+        memcpy(&client->values[field], data + pos + 2, sizeof(uint32_t));
+        client->received[field] = true;
+        pos += 2 + sizeof(uint32_t);
+    }
+
+    return true;
+}
+
+// Every subscribed field ends up with the current value, nothing else was received
+static uint32_t stale_fields(const FeedClient &client) {
+    uint32_t result = 0;
+    for (uint8_t i = 0; i < FIELD_COUNT; ++i) {
+        if (client.wants(i) && (!client.received[i] || client.values[i] != fields[i])) ++result;
+        if (!client.wants(i) && client.received[i]) ++result;
+    }
+
+    return result;
+}
+
+int run_feed_simulation() {
+    SimulatedHal::reset();
+
+    for (uint8_t i = 0; i < FIELD_COUNT; ++i) {
+        fields[i] = next_random();
+        parameters[i] = new Parameter<uint32_t>(&fields[i]);
+    }
+
+    static SubscriptionFeed feed;
+    for (uint8_t i = 0; i < FIELD_COUNT; ++i) feed.add(TYPE_BASE + i, parameters[i]);
+
+    // A wall tablet showing power and brightness, a night mode page on a flaky link, a full dashboard
+    FeedClient tablet{"tablet", 1, {}}, night{"night", 2, {}}, dashboard{"dashboard", 3, {}};
+    tablet.want(0, 2);
+    night.want(NIGHT_BEGIN, NIGHT_SIZE);
+    night.refuse_odd = true;
+    dashboard.want(0, FIELD_COUNT);
+    clients[0] = &tablet;
+    clients[1] = &night;
+
+    bool success = feed.connect(tablet.id) && feed.subscribe(tablet.id, tablet.bitmap, sizeof(tablet.bitmap));
+    success &= feed.connect(night.id) && feed.subscribe(night.id, night.bitmap, sizeof(night.bitmap));
+
+    uint8_t frame[FRAME_SIZE];
+    const auto allocations = SimulatedHal::allocation_count();
+    const auto start = std::chrono::steady_clock::now();
+
+    for (uint32_t event = 0; event < EVENT_COUNT; ++event) {
+        // The dashboard joins half-way and has to get the snapshot
+        if (event == EVENT_COUNT / 2) {
+            clients[2] = &dashboard;
+            success &= feed.connect(dashboard.id);
+        }
+
+        // Mostly a brightness ramp, sometimes any field
+        const uint8_t field = next_random() % 4 == 0 ? next_random() % FIELD_COUNT : 1;
+        fields[field] = next_random();
+        feed.changed(parameters[field]);
+
+        for (auto client: clients) {
+            if (client) client->broadcast_bytes += 2 + sizeof(uint32_t);
+        }
+
+        if ((event + 1) % FLUSH_EVERY == 0) feed.flush(frame, sizeof(frame), receive, nullptr);
+    }
+
+    // The refused client gets its values on a later flush
+    for (int i = 0; i < 2; ++i) feed.flush(frame, sizeof(frame), receive, nullptr);
+
+    const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    const auto allocated = SimulatedHal::allocation_count() - allocations;
+    const auto stats = feed.stats();
+
+    success &= allocated == 0 && stats.coalesced > 0 && stats.skipped > 0;
+
+    // Bytes sent per client against encoding every change for every client. Slots are taken in the connect order
+    uint8_t slot = 0;
+    for (auto client: clients) {
+        const auto &client_stats = *feed.client(slot++);
+        const uint32_t stale = stale_fields(*client);
+        const bool ok = stale == 0 && client->unwanted == 0 && client->malformed == 0;
+        success &= ok;
+
+        printf("  %-10s %s  sent: %8u bytes  broadcast: %8llu bytes  frames: %6u  refused: %4u  stale: %u  unwanted: %u\n",
+            client->name, ok ? "OK  " : "FAIL", client_stats.bytes, (unsigned long long) client->broadcast_bytes,
+            client_stats.frames, client_stats.refused, stale, client->unwanted);
+    }
+
+    // Dropping a type on resubscribe stops it, adding one sends its snapshot
+    memset(tablet.bitmap, 0, sizeof(tablet.bitmap));
+    tablet.want(1, 1);
+    tablet.want(NIGHT_BEGIN, 1);
+    memset(tablet.received, 0, sizeof(tablet.received));
+
+    success &= feed.subscribe(tablet.id, tablet.bitmap, sizeof(tablet.bitmap));
+    fields[0] = next_random();
+    feed.changed(parameters[0]);
+    feed.flush(frame, sizeof(frame), receive, nullptr);
+    const bool resubscribed = stale_fields(tablet) == 0 && tablet.unwanted == 0;
+
+    // One slot is left for four connects, a freed slot is reused
+    for (uint32_t id = 10; id < 10 + WS_FEED_CLIENT_COUNT; ++id) feed.connect(id);
+    const bool limited = feed.stats().rejected == 3;
+    feed.disconnect(10);
+    const bool reused = feed.connect(20);
+
+    success &= resubscribed && limited && reused;
+
+    printf("%-12s %s  changes: %u  coalesced: %u  skipped: %u  %.1f ns/change  allocs: %llu  resubscribe: %s  slots: %s\n",
+        "feed", success ? "OK  " : "FAIL", stats.changes, stats.coalesced, stats.skipped, ns / EVENT_COUNT,
+        (unsigned long long) allocated, resubscribed ? "ok" : "stale", limited && reused ? "ok" : "wrong");
+
+    for (auto parameter: parameters) delete parameter;
+    for (auto &client: clients) client = nullptr;
+
+    return success ? 0 : 1;
+}
@@ -0,0 +1,233 @@
+#include "hal.h"
+
+#include <cstdlib>
+#include <new>
+
+#include <Arduino.h>
+#include <WiFiUdp.h>
+#include <lwip/dns.h>
+
+static uint64_t _millis = 0;
+
+static int _duty[SimulatedHal::PIN_COUNT] = {};
+static uint8_t _mode[SimulatedHal::PIN_COUNT] = {};
+static uint8_t _level[SimulatedHal::PIN_COUNT] = {};
+
+struct InterruptHandler {
+    void (*fn)(void *);
+    void *arg;
+    int mode;
+};
+
+static InterruptHandler _interrupts[SimulatedHal::PIN_COUNT] = {};
+
+static uint64_t _allocation_count = 0;
+static uint32_t _write_count = 0;
+static uint32_t _resolution = 8;
+static uint32_t _frequency = 1000;
+
+struct Datagram {
+    uint8_t data[WiFiUDP::PACKET_SIZE];
+    size_t length;
+    uint64_t arrival;
+};
+
+// Sorted by arrival, fixed so the network doesn't show up in the allocation count
+static constexpr size_t UDP_QUEUE_SIZE = 8;
+
+static SimulatedHal::UdpResponder _udp_responder = nullptr;
+static void *_udp_responder_arg = nullptr;
+static Datagram _udp_queue[UDP_QUEUE_SIZE] = {};
+static size_t _udp_queue_size = 0;
+
+struct DnsLookup {
+    const char *name;
+    dns_found_callback found;
+    void *arg;
+    uint64_t arrival;
+};
+
+static DnsLookup _dns_lookup = {};
+static uint32_t _dns_lookups = 0;
+
+// Answered as the clock moves, like a reply from the network task
+static void _process_dns() {
+    if (!_dns_lookup.found || _dns_lookup.arrival > _millis) return;
+
+    const auto lookup = _dns_lookup;
+    _dns_lookup = {};
+
+    const ip_addr_t address = {0x0100007f};
+    lookup.found(lookup.name, &address, lookup.arg);
+}
+
+void SimulatedHal::reset() {
+    _millis = 0;
+    _write_count = 0;
+
+    memset(_duty, 0, sizeof(_duty));
+    memset(_mode, 0, sizeof(_mode));
+    memset(_level, 0, sizeof(_level));
+    memset(_interrupts, 0, sizeof(_interrupts));
+
+    _udp_responder = nullptr;
+    _udp_responder_arg = nullptr;
+    _udp_queue_size = 0;
+
+    _dns_lookup = {};
+    _dns_lookups = 0;
+}
+
+void SimulatedHal::set_millis(uint64_t value) { _millis = value; }
+void SimulatedHal::advance_millis(unsigned long value) {
+    _millis += value;
+    _process_dns();
+}
+
+uint64_t SimulatedHal::time_ms() { return _millis; }
+
+void SimulatedHal::set_input(uint8_t pin, bool level) {
+    if (pin >= PIN_COUNT || _level[pin] == level) return;
+
+    _level[pin] = level;
+
+    const auto &handler = _interrupts[pin];
+    if (handler.fn == nullptr) return;
+
+    if (handler.mode == CHANGE || handler.mode == (level ? RISING : FALLING)) handler.fn(handler.arg);
+}
+
+int SimulatedHal::duty(uint8_t pin) { return pin < PIN_COUNT ? _duty[pin] : 0; }
+uint8_t SimulatedHal::mode(uint8_t pin) { return pin < PIN_COUNT ? _mode[pin] : 0; }
+
+uint32_t SimulatedHal::write_count() { return _write_count; }
+uint32_t SimulatedHal::resolution() { return _resolution; }
+uint32_t SimulatedHal::frequency() { return _frequency; }
+
+uint64_t SimulatedHal::allocation_count() { return _allocation_count; }
+
+void SimulatedHal::set_udp_responder(UdpResponder responder, void *arg) {
+    _udp_responder = responder;
+    _udp_responder_arg = arg;
+}
+
+void SimulatedHal::deliver_udp(const uint8_t *data, size_t length, uint64_t arrival) {
+    // A full queue drops the datagram, as a congested network would
+    if (_udp_queue_size >= UDP_QUEUE_SIZE) return;
+
+    // Keep the queue ordered by arrival, datagrams may overtake each other
+    size_t index = 0;
+    while (index < _udp_queue_size && _udp_queue[index].arrival <= arrival) ++index;
+
+    memmove(&_udp_queue[index + 1], &_udp_queue[index], (_udp_queue_size - index) * sizeof(Datagram));
+    ++_udp_queue_size;
+
+    auto &datagram = _udp_queue[index];
+    datagram.length = std::min(length, sizeof(datagram.data));
+    datagram.arrival = arrival;
+    memcpy(datagram.data, data, datagram.length);
+}
+
+void *operator new(size_t size) {
+    ++_allocation_count;
+    if (void *ptr = malloc(size ? size : 1)) return ptr;
+
+    throw std::bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept { free(ptr); }
+void operator delete(void *ptr, size_t) noexcept { free(ptr); }
+
+// 32 bits like on the device, so the code has to handle the wraparound
+unsigned long millis() { return (uint32_t) _millis; }
+unsigned long micros() { return _millis * 1000; }
+void delay(unsigned long ms) { _millis += ms; }
+
+void pinMode(uint8_t pin, uint8_t mode) {
+    if (pin < SimulatedHal::PIN_COUNT) _mode[pin] = mode;
+}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+    if (pin < SimulatedHal::PIN_COUNT) _level[pin] = value;
+}
+
+int digitalRead(uint8_t pin) {
+    return pin < SimulatedHal::PIN_COUNT ? _level[pin] : LOW;
+}
+
+int digitalPinToInterrupt(uint8_t pin) { return pin; }
+
+void attachInterruptArg(uint8_t interrupt, void (*fn)(void *), void *arg, int mode) {
+    if (interrupt < SimulatedHal::PIN_COUNT) _interrupts[interrupt] = {fn, arg, mode};
+}
+
+void detachInterrupt(uint8_t interrupt) {
+    if (interrupt < SimulatedHal::PIN_COUNT) _interrupts[interrupt] = {};
+}
+
+void analogWrite(uint8_t pin, int value) {
+    if (pin >= SimulatedHal::PIN_COUNT) return;
+
+    _duty[pin] = std::max(0, std::min<int>(value, (1 << _resolution) - 1));
+    ++_write_count;
+}
+
+void analogWriteResolution(int resolution) { _resolution = resolution; }
+void analogWriteFreq(uint32_t frequency) { _frequency = frequency; }
+void analogWriteFrequency(uint32_t frequency) { _frequency = frequency; }
+
+uint32_t SimulatedHal::dns_lookups() { return _dns_lookups; }
+
+err_t dns_gethostbyname(const char *hostname, ip_addr_t *, dns_found_callback found, void *callback_arg) {
+    ++_dns_lookups;
+    _dns_lookup = {hostname, found, callback_arg, _millis + SimulatedHal::DNS_DELAY};
+
+    return ERR_INPROGRESS;
+}
+
+uint8_t WiFiUDP::begin(uint16_t) { return 1; }
+void WiFiUDP::stop() {}
+
+int WiFiUDP::beginPacket(const char *, uint16_t) {
+    _out_length = 0;
+    return 1;
+}
+
+int WiFiUDP::beginPacket(IPAddress, uint16_t) {
+    _out_length = 0;
+    return 1;
+}
+
+size_t WiFiUDP::write(const uint8_t *data, size_t length) {
+    const size_t count = std::min(length, sizeof(_out) - _out_length);
+    memcpy(_out + _out_length, data, count);
+    _out_length += count;
+
+    return count;
+}
+
+int WiFiUDP::endPacket() {
+    if (_udp_responder) _udp_responder(_out, _out_length, _udp_responder_arg);
+    return 1;
+}
+
+int WiFiUDP::parsePacket() {
+    if (_udp_queue_size == 0 || _udp_queue[0].arrival > _millis) return 0;
+
+    _in_length = _udp_queue[0].length;
+    _in_position = 0;
+    memcpy(_in, _udp_queue[0].data, _in_length);
+
+    --_udp_queue_size;
+    memmove(&_udp_queue[0], &_udp_queue[1], _udp_queue_size * sizeof(Datagram));
+
+    return (int) _in_length;
+}
+
+int WiFiUDP::read(uint8_t *data, size_t length) {
+    const size_t count = std::min(length, _in_length - _in_position);
+    memcpy(data, _in + _in_position, count);
+    _in_position += count;
+
+    return (int) count;
+}
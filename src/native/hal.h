@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Simulated hardware for the `native` environment: a controllable clock and recorded PWM output
+
+class SimulatedHal {
+public:
+    static constexpr uint8_t PIN_COUNT = 48;
+
+    static void reset();
+
+    static void set_millis(uint64_t value);
+    static void advance_millis(unsigned long value);
+
+    // Simulated time, unlike millis() it doesn't wrap around after ~49.7 days
+    static uint64_t time_ms();
+
+    // Changes input level and fires the attached interrupt, as a GPIO edge would
+    static void set_input(uint8_t pin, bool level);
+
+    static int duty(uint8_t pin);
+    static uint8_t mode(uint8_t pin);
+
+    static uint32_t write_count();
+    static uint32_t resolution();
+    static uint32_t frequency();
+
+    // Number of global operator new calls since start
+    static uint64_t allocation_count();
+
+    // Simulated network: every datagram sent with WiFiUDP goes to the responder,
+    // which may answer with deliver_udp(). Replies are received once time_ms() reaches `arrival`
+    typedef void (*UdpResponder)(const uint8_t *data, size_t length, void *arg);
+
+    static void set_udp_responder(UdpResponder responder, void *arg);
+    static void deliver_udp(const uint8_t *data, size_t length, uint64_t arrival);
+
+    // Every name resolves to the same address once DNS_DELAY passes
+    static constexpr unsigned long DNS_DELAY = 30;
+    static uint32_t dns_lookups();
+};
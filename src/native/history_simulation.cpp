@@ -0,0 +1,166 @@
+#include <Arduino.h>
+
+#include <deque>
+
+#include "hal.h"
+#include "simulation.h"
+
+#include "misc/history.h"
+
+static constexpr unsigned long SIMULATION_EVENTS = 20000;
+
+struct ReferenceEvent {
+    uint32_t seq;
+    unsigned long time;
+    HistoryEventType type;
+    uint32_t value;
+};
+
+// Typical lamp usage: switching, dimming ramps, temperature steps, rare color changes and night mode
+int run_history_simulation() {
+    HistoryBuffer history;
+    std::deque<ReferenceEvent> reference;
+
+    uint32_t seed = 0xC0FFEE;
+    auto random = [&](uint32_t max) {
+        seed = seed * 1664525u + 1013904223u;
+        return (seed >> 8) % max;
+    };
+
+    uint32_t values[HISTORY_EVENT_TYPE_COUNT] = {1, 2048, 0xffffff, 8191, 0};
+    unsigned long now = 0;
+    uint32_t recorded = 0;
+    uint32_t read_seq = 0;      // Events before it were handed out and can't change anymore
+    uint32_t mismatches = 0;
+
+    auto record = [&](HistoryEventType type, uint32_t value) {
+        values[(uint8_t) type] = value;
+        history.record(type, value, now);
+
+        const unsigned long time = now / HISTORY_TIME_RESOLUTION * HISTORY_TIME_RESOLUTION;
+        const bool coalesced = type == HistoryEventType::BRIGHTNESS || type == HistoryEventType::COLOR
+                               || type == HistoryEventType::TEMPERATURE;
+
+        if (coalesced && !reference.empty() && reference.back().type == type && reference.back().seq >= read_seq
+            && time - reference.back().time <= HISTORY_COALESCE_INTERVAL) {
+            reference.back() = {reference.back().seq, time, type, value};
+        } else {
+            reference.push_back({recorded++, time, type, value});
+        }
+    };
+
+    auto check = [&](const HistoryEvent &event) {
+        const auto &expected = reference[reference.size() - (history.next_seq() - event.seq)];
+        return event.seq == expected.seq && event.time == expected.time && event.type == expected.type
+               && event.value == expected.value;
+    };
+
+    // A client following the tail must see every value it didn't get yet
+    uint32_t follower_cursor = 0;
+    uint32_t follower_value = values[1];
+    uint32_t follower_reads = 0;
+
+    auto follow = [&] {
+        HistoryEvent events[32];
+        size_t count;
+        uint32_t next_cursor;
+
+        do {
+            if (!history.read(follower_cursor, events, 32, count, next_cursor)) ++mismatches;
+            read_seq = std::max(read_seq, next_cursor);
+
+            for (size_t j = 0; j < count; ++j) {
+                if (!check(events[j])) ++mismatches;
+                if (events[j].type == HistoryEventType::BRIGHTNESS) follower_value = events[j].value;
+            }
+
+            follower_cursor = next_cursor;
+        } while (count == 32);
+
+        ++follower_reads;
+    };
+
+    for (unsigned long i = 0; i < SIMULATION_EVENTS; ++i) {
+        // ~35 days in total, within the 32-bit millis() range of the device
+        now += 500 + random(5 * 60 * 1000);
+
+        switch (random(10)) {
+            case 0:
+            case 1:
+            case 2:
+                record(HistoryEventType::POWER, !values[0]);
+                break;
+
+            case 3:
+            case 4:
+            case 5: {
+                // Button hold ramp: many small steps 20 ms apart, coalesced into a single event
+                const int32_t direction = random(2) ? 1 : -1;
+                for (int step = 0; step < 30; ++step) {
+                    values[1] = std::min<int32_t>(16383, std::max<int32_t>(1, values[1] + direction * 327));
+                    record(HistoryEventType::BRIGHTNESS, values[1]);
+                    now += 20;
+
+                    // The web UI polls in the middle of a ramp
+                    if (i % 7 == 0 && step % 10 == 5) follow();
+                }
+
+                if (i % 7 == 0) {
+                    follow();
+                    if (follower_value != values[1]) ++mismatches;
+                }
+                break;
+            }
+
+            case 6:
+            case 7:
+                record(HistoryEventType::TEMPERATURE, random(4) * 8191);
+                break;
+
+            case 8:
+                record(HistoryEventType::COLOR, random(0x1000000));
+                break;
+
+            case 9:
+                record(HistoryEventType::NIGHT, !values[4]);
+                break;
+        }
+
+        // Incremental fetch by a client that polls rarely and loses the oldest events
+        if (i % 97 == 0) {
+            HistoryEvent events[32];
+            size_t count;
+            uint32_t next_cursor;
+
+            const uint32_t cursor = history.first_seq() + random(history.next_seq() - history.first_seq() + 1);
+            if (!history.read(cursor, events, 32, count, next_cursor)) ++mismatches;
+            read_seq = std::max(read_seq, next_cursor);
+
+            for (size_t j = 0; j < count; ++j) {
+                if (!check(events[j])) ++mismatches;
+            }
+
+            if (next_cursor != cursor + count) ++mismatches;
+        }
+    }
+
+    // Page for the binary protocol must contain whole events starting at the cursor
+    HistoryPage page;
+    if (!history.read_page(history.first_seq() + 5, now, page)) ++mismatches;
+    if (page.cursor != history.first_seq() + 5 || page.length == 0 || page.next_cursor <= page.cursor) ++mismatches;
+    if (page.requested != page.cursor) ++mismatches;
+
+    // A cursor older than the buffer is echoed, the page starts at the oldest stored event
+    HistoryPage dropped;
+    if (!history.read_page(0, now, dropped)) ++mismatches;
+    if (dropped.requested != 0 || dropped.cursor != history.first_seq()) ++mismatches;
+
+    const uint32_t stored = history.next_seq() - history.first_seq();
+    const bool success = mismatches == 0 && stored > 0 && follower_reads > 0;
+
+    printf("%-24s %s  events: %u  stored: %u in %zu bytes (%.2f bytes/event)  page: %u events in %u bytes\n",
+        "mixed usage", success ? "OK  " : "FAIL", recorded, stored, history.size(),
+        (double) history.size() / std::max<uint32_t>(1, stored), page.next_cursor - page.cursor, page.length);
+
+    return success ? 0 : 1;
+}
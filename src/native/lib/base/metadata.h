@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+
+// The part of the framework parameter interface used by the notification router
+
+class AbstractParameter {
+public:
+    virtual ~AbstractParameter() = default;
+
+    [[nodiscard]] virtual const void *get_value() const = 0;
+    [[nodiscard]] virtual size_t size() const = 0;
+};
+
+template<typename T>
+class Parameter : public AbstractParameter {
+    T *_value;
+
+public:
+    explicit Parameter(T *value) : _value(value) {}
+
+    [[nodiscard]] const void *get_value() const override { return _value; }
+    [[nodiscard]] size_t size() const override { return sizeof(T); }
+};
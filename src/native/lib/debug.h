@@ -0,0 +1,20 @@
+#pragma once
+
+#include <Arduino.h>
+
+#define __DEBUG_LEVEL_VERBOSE   0
+#define __DEBUG_LEVEL_INFO      1
+
+#ifdef DEBUG
+#define D_PRINT(x)              puts(x)
+#define D_PRINTF(...)           printf(__VA_ARGS__)
+#else
+#define D_PRINT(x)              ((void) 0)
+#define D_PRINTF(...)           ((void) 0)
+#endif
+
+#if defined(DEBUG) && DEBUG_LEVEL <= __DEBUG_LEVEL_VERBOSE
+#define VERBOSE(x)              x
+#else
+#define VERBOSE(x)              ((void) 0)
+#endif
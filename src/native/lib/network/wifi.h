@@ -0,0 +1,8 @@
+#pragma once
+
+#include <cstdint>
+
+enum class WifiMode: uint8_t {
+    AP = 0,
+    STA = 1,
+};
@@ -0,0 +1,7 @@
+#pragma once
+
+// Native builds don't need the enum-to-string debug helpers of the framework
+
+#define MAKE_ENUM_AUTO(name, type, ...)                                     \
+    enum class name: type { __VA_ARGS__ };                                  \
+    inline const char *__debug_enum_str(name) { return #name; }
@@ -0,0 +1,24 @@
+#pragma once
+
+// Minimal lwIP DNS API for the `native` environment, lookups are answered by the simulated network
+// after SimulatedHal::DNS_DELAY, see hal.h
+
+#include <cstdint>
+
+typedef int8_t err_t;
+
+#define ERR_OK              (0)
+#define ERR_INPROGRESS      (-5)
+
+struct ip4_addr_t {
+    uint32_t addr;
+};
+
+typedef ip4_addr_t ip_addr_t;
+
+#define ip_2_ip4(ipaddr)        (ipaddr)
+#define ip4_addr_get_u32(src)   ((src)->addr)
+
+typedef void (*dns_found_callback)(const char *name, const ip_addr_t *ipaddr, void *callback_arg);
+
+err_t dns_gethostbyname(const char *hostname, ip_addr_t *addr, dns_found_callback found, void *callback_arg);
@@ -0,0 +1,47 @@
+#include <cstdio>
+#include <cstring>
+
+#include "simulation.h"
+
+struct Scenario {
+    const char *name;
+    int (*run)();
+};
+
+static constexpr Scenario SCENARIOS[] = {
+    {"tick", run_tick_simulation},
+    {"boot", run_boot_simulation},
+    {"night", run_night_simulation},
+    {"button", run_button_simulation},
+    {"ota", run_ota_simulation},
+    {"history", run_history_simulation},
+    {"sntp", run_sntp_simulation},
+    {"admission", run_admission_simulation},
+    {"steady", run_steady_simulation},
+    {"phase", run_phase_simulation},
+    {"timers", run_timer_simulation},
+    {"notify", run_notification_simulation},
+    {"feed", run_feed_simulation},
+    {"parse", run_parse_simulation},
+    {"bench", run_benchmarks},
+};
+
+// Usage: program [scenario...], runs all scenarios if none specified
+int main(int argc, char **argv) {
+    int result = 0;
+
+    for (const auto &scenario: SCENARIOS) {
+        bool selected = argc <= 1;
+        for (int i = 1; i < argc; ++i) selected |= strcmp(argv[i], scenario.name) == 0;
+        if (!selected) continue;
+
+        printf("=== %s ===\n", scenario.name);
+
+        const int code = scenario.run();
+        if (code != 0) printf("FAILED: %s\n", scenario.name);
+
+        result |= code;
+    }
+
+    return result;
+}
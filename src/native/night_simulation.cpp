@@ -0,0 +1,130 @@
+#include <Arduino.h>
+
+#include "hal.h"
+#include "simulation.h"
+
+#include "misc/night_mode.h"
+
+static constexpr unsigned long SECONDS_PER_DAY = 24ul * 60 * 60;
+static constexpr unsigned long SIMULATION_DAYS = 21;
+static constexpr unsigned long STEP_MS = 100;
+
+// 2024-01-01 00:00:00 UTC
+static constexpr unsigned long START_EPOCH = 1704067200ul;
+
+struct NightScenario {
+    const char *name;
+
+    uint32_t start_time;
+    uint32_t end_time;
+    uint16_t switch_interval;
+
+    long time_zone_shift;       // Applied at the middle of the simulation, seconds
+};
+
+static constexpr NightScenario NIGHT_SCENARIOS[] = {
+    {"22:00-06:00", 22 * 3600, 6 * 3600, 15 * 60, 0},
+    {"01:00-05:00", 1 * 3600, 5 * 3600, 30 * 60, 0},
+    {"00:00-10:00", 0, 10 * 3600, 15 * 60, 0},
+    {"23:00-23:30", 23 * 3600, 23 * 3600 + 1800, 60, 0},
+    {"22:00-06:00 TZ+3", 22 * 3600, 6 * 3600, 15 * 60, 3 * 3600},
+    {"22:00-06:00 TZ-5", 22 * 3600, 6 * 3600, 15 * 60, -5 * 3600},
+};
+
+static unsigned long _seconds_of_day(unsigned long offset) {
+    return offset % SECONDS_PER_DAY;
+}
+
+static bool simulate_night(const NightScenario &scenario) {
+    SimulatedHal::reset();
+
+    Config config;
+    config.brightness = 2048;
+    config.night_mode.enabled = true;
+    config.night_mode.brightness = 10;
+    config.night_mode.start_time = scenario.start_time;
+    config.night_mode.end_time = scenario.end_time;
+    config.night_mode.switch_interval = scenario.switch_interval;
+
+    NightModeManager manager(config);
+    manager.reset();
+
+    const uint16_t day_brightness = config.brightness;
+    const uint16_t night_brightness = config.night_mode.brightness;
+    const uint32_t range = day_brightness - night_brightness;
+
+    // Factor has millisecond resolution, so brightness can't move more than one step's share of the fade
+    const uint64_t fade_ms = (uint64_t) scenario.switch_interval * 1000;
+    const uint32_t max_step = ((uint64_t) range * STEP_MS + fade_ms - 1) / fade_ms + 1;
+
+    const auto night_duration = (scenario.end_time - scenario.start_time + SECONDS_PER_DAY) % SECONDS_PER_DAY;
+    const auto day_duration = SECONDS_PER_DAY - night_duration;
+    const auto night_middle = _seconds_of_day(scenario.start_time + night_duration / 2);
+    const auto day_middle = _seconds_of_day(scenario.end_time + day_duration / 2);
+
+    const unsigned long total_steps = SIMULATION_DAYS * SECONDS_PER_DAY * 1000 / STEP_MS;
+
+    long time_zone = 0;
+    uint16_t prev_brightness = 0;
+    uint32_t max_delta = 0;
+    uint32_t discontinuities = 0;
+    uint32_t wrong_levels = 0;
+    uint32_t updates_outside_night = 0;
+
+    for (unsigned long step = 0; step < total_steps; ++step) {
+        SimulatedHal::advance_millis(STEP_MS);
+
+        bool time_jump = false;
+        if (scenario.time_zone_shift != 0 && step == total_steps / 2) {
+            time_zone = scenario.time_zone_shift;
+            manager.reset();
+            time_jump = true;
+        }
+
+        const uint64_t now_ms = (uint64_t) (START_EPOCH + time_zone) * 1000 + millis();
+        const unsigned long now = now_ms / 1000;
+        const auto fade_updates = manager.stats().fade_factor_updates;
+
+        manager.handle_night(now_ms);
+
+        const uint16_t brightness = manager.is_night_time() ? manager.get_brightness() : day_brightness;
+
+        if (!manager.is_night_time() && manager.stats().fade_factor_updates != fade_updates) {
+            ++updates_outside_night;
+        }
+
+        if (step > 0 && !time_jump) {
+            const uint32_t delta = abs((int32_t) brightness - prev_brightness);
+            max_delta = std::max(max_delta, delta);
+            if (delta > max_step) ++discontinuities;
+        }
+
+        const auto time_of_day = _seconds_of_day(now);
+        if (time_of_day == night_middle && brightness != night_brightness) ++wrong_levels;
+        if (time_of_day == day_middle && brightness != day_brightness) ++wrong_levels;
+
+        prev_brightness = brightness;
+    }
+
+    const auto &stats = manager.stats();
+    const double hours = SIMULATION_DAYS * 24.0;
+    const uint32_t max_schedule_updates = 2 * SIMULATION_DAYS + 2;
+
+    const bool success = discontinuities == 0 && wrong_levels == 0 && updates_outside_night == 0
+                         && stats.schedule_updates <= max_schedule_updates;
+
+    printf("%-20s %s  max step: %3u/%-3u  schedule: %4u  handle/h: %7.0f  fade/h: %7.1f  wrong: %u  outside: %u\n",
+        scenario.name, success ? "OK  " : "FAIL", max_delta, max_step, stats.schedule_updates,
+        stats.handle_calls / hours, stats.fade_factor_updates / hours, wrong_levels, updates_outside_night);
+
+    return success;
+}
+
+int run_night_simulation() {
+    int result = 0;
+    for (const auto &scenario: NIGHT_SCENARIOS) {
+        if (!simulate_night(scenario)) result = 1;
+    }
+
+    return result;
+}
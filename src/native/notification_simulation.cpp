@@ -0,0 +1,186 @@
+#include <Arduino.h>
+
+#include <chrono>
+#include <functional>
+
+#include "hal.h"
+#include "simulation.h"
+
+#include "misc/notification_router.h"
+
+static constexpr size_t FIELD_COUNT = 64;
+static constexpr uint32_t EVENT_COUNT = 200000;
+static constexpr uint32_t SAMPLE_EVERY = 1000;         // Events per simulated rate interval
+
+// Stand-in for Config: the app subscribes to the whole of it, metrics to a group, a client to one field
+struct SimulatedConfig {
+    uint32_t fields[FIELD_COUNT];
+};
+
+static constexpr size_t GROUP_BEGIN = 16;
+static constexpr size_t GROUP_SIZE = 8;
+static constexpr size_t TYPED_FIELD = 20;
+
+static uint32_t random_state = 0x9e3779b9;
+
+static uint32_t next_random() {
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 17;
+    random_state ^= random_state << 5;
+    return random_state;
+}
+
+struct Counter {
+    uint32_t calls = 0;
+    uint32_t expected = 0;
+    uint32_t mismatches = 0;    // Typed payload differs from the field
+};
+
+static SimulatedConfig config;
+static int app_sender, server_sender;
+
+static void count_parameter(void *arg, void *, const AbstractParameter *) {
+    ++((Counter *) arg)->calls;
+}
+
+static void count_value(void *arg, void *, const uint32_t &value) {
+    auto &counter = *(Counter *) arg;
+    ++counter.calls;
+    if (value != config.fields[TYPED_FIELD]) ++counter.mismatches;
+}
+
+// The framework bus: every subscriber is called for every event and filters it itself
+typedef std::function<void(void *sender, const AbstractParameter *parameter)> BroadcastHandler;
+
+static BroadcastHandler make_broadcast_handler(const void *ignore_sender, const void *begin, size_t size, Counter *counter) {
+    return [=](void *sender, const AbstractParameter *parameter) {
+        if (sender == ignore_sender) return;
+
+        const auto offset = (uintptr_t) parameter->get_value() - (uintptr_t) begin;
+        if (offset >= size) return;
+
+        ++counter->calls;
+    };
+}
+
+int run_notification_simulation() {
+    SimulatedHal::reset();
+
+    // Parameters of the same object are allocated once, like the metadata
+    static Parameter<uint32_t> *parameters[FIELD_COUNT];
+    for (size_t i = 0; i < FIELD_COUNT; ++i) parameters[i] = new Parameter<uint32_t>(&config.fields[i]);
+
+    uint32_t unrelated_value = 0;
+    Parameter<uint32_t> unrelated(&unrelated_value);
+
+    NotificationRouter router;
+    for (size_t i = 0; i < FIELD_COUNT; ++i) router.add_topic(parameters[i], i);
+
+    Counter app, metrics, client, idle;
+    bool subscribed = router.subscribe_range(&config, sizeof(config), count_parameter, &app, &app_sender) == FIELD_COUNT;
+    subscribed &= router.subscribe_range(&config.fields[GROUP_BEGIN], GROUP_SIZE * sizeof(uint32_t), count_parameter, &metrics) == GROUP_SIZE;
+    subscribed &= router.subscribe(&config.fields[TYPED_FIELD], count_value, &client);
+
+    // Wrong type and unknown parameter are refused
+    subscribed &= !router.subscribe((const uint16_t *) &config.fields[0], [](void *, void *, const uint16_t &) {}, &idle);
+    subscribed &= !router.subscribe(&unrelated, count_parameter, &idle);
+
+    // A full table refuses more topics and counts them, the app reports it at setup
+    static uint32_t overflow_values[NOTIFICATION_TOPIC_COUNT + 1];
+    static Parameter<uint32_t> *overflow_parameters[NOTIFICATION_TOPIC_COUNT + 1];
+
+    NotificationRouter full_router;
+    uint8_t added = 0;
+    for (size_t i = 0; i <= NOTIFICATION_TOPIC_COUNT; ++i) {
+        overflow_parameters[i] = new Parameter<uint32_t>(&overflow_values[i]);
+        added += full_router.add_topic(overflow_parameters[i]);
+    }
+
+    const bool overflow_counted = added == NOTIFICATION_TOPIC_COUNT && full_router.stats().overflows == 1;
+    for (auto parameter: overflow_parameters) delete parameter;
+
+    const auto allocations = SimulatedHal::allocation_count();
+
+    uint32_t window[FIELD_COUNT] = {};
+    uint32_t rate_mismatches = 0;
+
+    for (uint32_t event = 0; event < EVENT_COUNT; ++event) {
+        // A few hot parameters, like brightness during a ramp
+        const size_t field = next_random() % 4 == 0 ? next_random() % FIELD_COUNT : next_random() % 4 + GROUP_BEGIN;
+        void *sender = next_random() % 3 == 0 ? (void *) &app_sender : (void *) &server_sender;
+
+        config.fields[field] = next_random();
+        router.dispatch(sender, parameters[field]);
+        if (event % 100 == 0) router.dispatch(sender, &unrelated);
+
+        if (sender != &app_sender) ++app.expected;
+        if (field >= GROUP_BEGIN && field < GROUP_BEGIN + GROUP_SIZE) ++metrics.expected;
+        if (field == TYPED_FIELD) ++client.expected;
+        ++window[field];
+
+        if ((event + 1) % SAMPLE_EVERY == 0) {
+            router.sample();
+
+            for (uint8_t i = 0; i < router.topic_count(); ++i) {
+                const auto &topic = router.topic(i);
+                if (topic.rate != window[topic.key]) ++rate_mismatches;
+            }
+
+            memset(window, 0, sizeof(window));
+        }
+    }
+
+    const auto &stats = router.stats();
+    const bool success = subscribed && overflow_counted && allocations == SimulatedHal::allocation_count()
+                         && app.calls == app.expected && metrics.calls == metrics.expected
+                         && client.calls == client.expected && client.mismatches == 0 && idle.calls == 0
+                         && rate_mismatches == 0 && stats.unrouted == EVENT_COUNT / 100
+                         && stats.delivered == app.calls + metrics.calls + client.calls;
+
+    printf("routing  %s  events: %u  delivered: %u  filtered: %u  unrouted: %u  rate errors: %u  allocs: %llu  overflow: %s\n",
+        success ? "OK  " : "FAIL", stats.events, stats.delivered, stats.filtered, stats.unrouted, rate_mismatches,
+        (unsigned long long) (SimulatedHal::allocation_count() - allocations), overflow_counted ? "counted" : "missed");
+
+    // Per event, against every subscriber filtering every event. Idle subscribers listen to another parameter
+    printf("\nPer event:\n");
+    for (size_t idle_count: {0, 2, 5}) {
+        Counter sink;
+
+        BroadcastHandler handlers[NOTIFICATION_SUBSCRIBER_COUNT];
+        handlers[0] = make_broadcast_handler(&app_sender, &config, sizeof(config), &sink);
+        handlers[1] = make_broadcast_handler(nullptr, &config.fields[GROUP_BEGIN], GROUP_SIZE * sizeof(uint32_t), &sink);
+        handlers[2] = make_broadcast_handler(nullptr, &config.fields[TYPED_FIELD], sizeof(uint32_t), &sink);
+        for (size_t i = 0; i < idle_count; ++i) {
+            handlers[3 + i] = make_broadcast_handler(nullptr, &unrelated_value, sizeof(uint32_t), &sink);
+        }
+
+        NotificationRouter bench_router;
+        for (size_t i = 0; i < FIELD_COUNT; ++i) bench_router.add_topic(parameters[i], i);
+        bench_router.add_topic(&unrelated);
+
+        bench_router.subscribe_range(&config, sizeof(config), count_parameter, &sink, &app_sender);
+        bench_router.subscribe_range(&config.fields[GROUP_BEGIN], GROUP_SIZE * sizeof(uint32_t), count_parameter, &sink);
+        bench_router.subscribe(&config.fields[TYPED_FIELD], count_value, &sink);
+        for (size_t i = 0; i < idle_count; ++i) bench_router.subscribe(&unrelated, count_parameter, &sink);
+
+        const auto broadcast_start = std::chrono::steady_clock::now();
+        for (uint32_t event = 0; event < EVENT_COUNT; ++event) {
+            for (size_t i = 0; i < 3 + idle_count; ++i) handlers[i](&server_sender, parameters[event % FIELD_COUNT]);
+        }
+        const double broadcast_ns = std::chrono::duration<double, std::nano>(
+            std::chrono::steady_clock::now() - broadcast_start).count() / EVENT_COUNT;
+
+        const auto routed_start = std::chrono::steady_clock::now();
+        for (uint32_t event = 0; event < EVENT_COUNT; ++event) {
+            bench_router.dispatch(&server_sender, parameters[event % FIELD_COUNT]);
+        }
+        const double routed_ns = std::chrono::duration<double, std::nano>(
+            std::chrono::steady_clock::now() - routed_start).count() / EVENT_COUNT;
+
+        printf("  %zu subscribers  broadcast: %6.1f ns  routed: %6.1f ns\n", 3 + idle_count, broadcast_ns, routed_ns);
+    }
+
+    for (auto parameter: parameters) delete parameter;
+
+    return success ? 0 : 1;
+}
@@ -0,0 +1,277 @@
+#include <Arduino.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <vector>
+
+#include "simulation.h"
+
+#include "sys_constants.h"
+#include "utils/heatshrink.h"
+#include "utils/sha256.h"
+
+typedef HeatshrinkDecoder<OTA_HEATSHRINK_WINDOW_BITS, OTA_HEATSHRINK_LOOKAHEAD_BITS> Decoder;
+typedef std::vector<uint8_t> Bytes;
+
+struct Sha256Vector {
+    const char *input;
+    const char *digest;
+};
+
+static constexpr Sha256Vector SHA256_VECTORS[] = {
+    {"", "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855"},
+    {"abc", "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad"},
+    {"abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq",
+     "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1"},
+};
+
+static bool check_sha256() {
+    bool success = true;
+    for (const auto &vector: SHA256_VECTORS) {
+        uint8_t digest[Sha256::DIGEST_SIZE];
+
+        // Feed byte by byte to cover the partial block path
+        Sha256 sha256;
+        for (const char *ch = vector.input; *ch; ++ch) sha256.update((const uint8_t *) ch, 1);
+        sha256.finish(digest);
+
+        success &= Sha256::equals_hex(digest, vector.digest, strlen(vector.digest));
+    }
+
+    printf("%-24s %s\n", "sha256 vectors", success ? "OK" : "FAIL");
+    return success;
+}
+
+// Reference encoder: greedy longest match, emits the same bit layout as `heatshrink -e -w W -l L`
+static Bytes heatshrink_encode(const Bytes &input) {
+    constexpr size_t window = 1u << OTA_HEATSHRINK_WINDOW_BITS;
+    constexpr size_t lookahead = 1u << OTA_HEATSHRINK_LOOKAHEAD_BITS;
+    constexpr size_t backref_bits = 1 + OTA_HEATSHRINK_WINDOW_BITS + OTA_HEATSHRINK_LOOKAHEAD_BITS;
+
+    Bytes output;
+    uint32_t bits = 0;
+    uint8_t bit_count = 0;
+
+    auto push = [&](uint32_t value, uint8_t count) {
+        for (int i = count - 1; i >= 0; --i) {
+            bits = (bits << 1) | ((value >> i) & 1);
+            if (++bit_count == 8) {
+                output.push_back((uint8_t) bits);
+                bits = 0;
+                bit_count = 0;
+            }
+        }
+    };
+
+    for (size_t pos = 0; pos < input.size();) {
+        size_t best_length = 0;
+        size_t best_offset = 0;
+
+        const size_t max_length = std::min(lookahead, input.size() - pos);
+        for (size_t offset = 1; offset <= std::min(window, pos); ++offset) {
+            size_t length = 0;
+            while (length < max_length && input[pos - offset + length] == input[pos + length]) ++length;
+
+            if (length > best_length) {
+                best_length = length;
+                best_offset = offset;
+                if (length == max_length) break;
+            }
+        }
+
+        if (best_length * 9 > backref_bits) {
+            push(0, 1);
+            push(best_offset - 1, OTA_HEATSHRINK_WINDOW_BITS);
+            push(best_length - 1, OTA_HEATSHRINK_LOOKAHEAD_BITS);
+            pos += best_length;
+        } else {
+            push(1, 1);
+            push(input[pos], 8);
+            ++pos;
+        }
+    }
+
+    if (bit_count > 0) push(0, 8 - bit_count);
+    return output;
+}
+
+// Firmware-like data: repeated code patterns, string tables and incompressible blocks
+static Bytes synthetic_image(size_t size) {
+    Bytes result;
+    result.reserve(size);
+
+    uint32_t seed = 0x12345678;
+    auto random = [&] {
+        seed = seed * 1664525u + 1013904223u;
+        return seed >> 24;
+    };
+
+    static const char *STRINGS[] = {"WebSocket: Register property ", "MQTT: Register notification -> ", "/api/status"};
+    while (result.size() < size) {
+        switch (random() % 4) {
+            case 0:
+                for (const char *ch = STRINGS[random() % 3]; *ch; ++ch) result.push_back(*ch);
+                break;
+
+            case 1:
+                for (int i = 0; i < 64; ++i) result.push_back(random());
+                break;
+
+            default:
+                for (int i = 0; i < 32; ++i) result.push_back(0x20 + (i * 7 + random() % 2) % 16);
+                break;
+        }
+    }
+
+    result.resize(size);
+    return result;
+}
+
+static bool read_file(const char *path, Bytes &out) {
+    FILE *file = fopen(path, "rb");
+    if (!file) return false;
+
+    uint8_t buffer[4096];
+    for (size_t count; (count = fread(buffer, 1, sizeof(buffer), file)) > 0;) out.insert(out.end(), buffer, buffer + count);
+
+    fclose(file);
+    return true;
+}
+
+// Encoder output from the heatshrink test suite (test_heatshrink_static.c), independent of heatshrink_encode()
+struct HeatshrinkVector {
+    const char *name;
+    Bytes input;
+    Bytes compressed;
+};
+
+template<uint8_t WindowBits, uint8_t LookaheadBits>
+static bool check_reference(const HeatshrinkVector &vector) {
+    HeatshrinkDecoder<WindowBits, LookaheadBits> decoder;
+    Bytes output;
+
+    auto sink = [&](const uint8_t *data, size_t length) {
+        output.insert(output.end(), data, data + length);
+        return true;
+    };
+
+    const bool success = decoder.feed(vector.compressed.data(), vector.compressed.size(), sink)
+                         && decoder.finish(sink) && output == vector.input;
+
+    printf("%-24s %s\n", vector.name, success ? "OK" : "FAIL");
+    return success;
+}
+
+static bool check_reference_vectors() {
+    bool success = check_reference<8, 7>({"reference literals", {0, 1, 2, 3, 4}, {0x80, 0x40, 0x60, 0x50, 0x38, 0x20}});
+    success &= check_reference<8, 7>({"reference backref", Bytes(5, 'a'), {0xb0, 0x80, 0x01, 0x80}});
+
+    return success;
+}
+
+static bool check_roundtrip(const char *name, const Bytes &image, const Bytes &compressed) {
+    // The updater hashes the uploaded bytes, not the decoded image
+    uint8_t expected[Sha256::DIGEST_SIZE];
+    Sha256 reference;
+    reference.update(compressed.data(), compressed.size());
+    reference.finish(expected);
+
+    char expected_hex[Sha256::HEX_SIZE + 1];
+    Sha256::to_hex(expected, expected_hex);
+
+    // TCP segment sizes seen in practice, plus pathological ones
+    static constexpr size_t CHUNK_SIZES[] = {1, 7, 536, 1436, 4096};
+
+    bool success = true;
+    double best_ns_per_byte = 0;
+
+    for (const auto chunk_size: CHUNK_SIZES) {
+        Decoder decoder;
+        Sha256 sha256;
+        Bytes output;
+
+        auto sink = [&](const uint8_t *data, size_t length) {
+            output.insert(output.end(), data, data + length);
+            return true;
+        };
+
+        const auto start = std::chrono::steady_clock::now();
+
+        bool ok = true;
+        for (size_t pos = 0; pos < compressed.size() && ok; pos += chunk_size) {
+            const size_t length = std::min(chunk_size, compressed.size() - pos);
+            sha256.update(compressed.data() + pos, length);
+            ok = decoder.feed(compressed.data() + pos, length, sink);
+        }
+
+        ok = ok && decoder.finish(sink);
+
+        const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        if (chunk_size >= 536 && !image.empty() && (best_ns_per_byte == 0 || ns / image.size() < best_ns_per_byte)) {
+            best_ns_per_byte = ns / image.size();
+        }
+
+        uint8_t digest[Sha256::DIGEST_SIZE];
+        sha256.finish(digest);
+
+        ok = ok && output == image && Sha256::equals_hex(digest, expected_hex, strlen(expected_hex));
+        success &= ok;
+    }
+
+    printf("%-24s %s  %7zu -> %7zu bytes (%4.1f%%)  decoder RAM: %zu  decode+sha: %.1f ns/byte\n",
+        name, success ? "OK  " : "FAIL", image.size(), compressed.size(), 100.0 * compressed.size() / std::max<size_t>(1, image.size()),
+        Decoder::memory_size() + sizeof(Sha256), best_ns_per_byte);
+
+    return success;
+}
+
+static bool check_rejected_sink() {
+    const auto image = synthetic_image(8192);
+    const auto compressed = heatshrink_encode(image);
+
+    Decoder decoder;
+    size_t accepted = 0;
+    const bool result = decoder.feed(compressed.data(), compressed.size(), [&](const uint8_t *, size_t length) {
+        accepted += length;
+        return accepted < 1024;
+    });
+
+    // Decoder must stop at the first rejected chunk and stay failed
+    const bool success = !result && accepted < image.size() && !decoder.finish([](const uint8_t *, size_t) { return true; });
+    printf("%-24s %s\n", "rejected write", success ? "OK" : "FAIL");
+
+    return success;
+}
+
+// OTA_SAMPLE=<image.bin> checks a real firmware image, OTA_SAMPLE_HS=<image.bin.hs> also checks the output
+// of the build (compress_firmware.py) or of the heatshrink CLI (`heatshrink -e -w 10 -l 5 image.bin image.bin.hs`)
+int run_ota_simulation() {
+    bool success = check_sha256();
+    success &= check_reference_vectors();
+
+    success &= check_roundtrip("empty", {}, heatshrink_encode({}));
+    success &= check_roundtrip("zeros", Bytes(20000, 0), heatshrink_encode(Bytes(20000, 0)));
+
+    const auto image = synthetic_image(256 * 1024);
+    success &= check_roundtrip("synthetic 256K", image, heatshrink_encode(image));
+    success &= check_rejected_sink();
+
+    if (const char *sample_path = getenv("OTA_SAMPLE")) {
+        Bytes sample;
+        if (!read_file(sample_path, sample)) {
+            printf("Unable to read %s\n", sample_path);
+            return 1;
+        }
+
+        Bytes compressed;
+        const char *compressed_path = getenv("OTA_SAMPLE_HS");
+        if (compressed_path && !read_file(compressed_path, compressed)) {
+            printf("Unable to read %s\n", compressed_path);
+            return 1;
+        }
+
+        success &= check_roundtrip("sample", sample, compressed_path ? compressed : heatshrink_encode(sample));
+    }
+
+    return success ? 0 : 1;
+}
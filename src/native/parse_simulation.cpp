@@ -0,0 +1,215 @@
+#include <Arduino.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iterator>
+
+#include "hal.h"
+#include "simulation.h"
+
+#include "sys_constants.h"
+#include "utils/parse.h"
+
+static constexpr uint32_t FUZZ_CASES = 500000;
+static constexpr uint32_t BENCHMARK_MESSAGES = 2000000;
+static constexpr size_t MAX_PAYLOAD = 32;
+
+// Digits padded by a digit on both sides: reading past the span changes the value and shows up as a mismatch
+static constexpr char GUARD = '7';
+
+static uint32_t random_state = 0x6b43a9b5;
+
+static uint32_t next_random() {
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 17;
+    random_state ^= random_state << 5;
+    return random_state;
+}
+
+// Bytes an MQTT payload may carry, weighted towards the ones the parser has to tell apart
+static constexpr char ALPHABET[] = "0123456789012345678901234567890123456789  \t\r\n+-+-.xe\xff";
+
+static size_t random_payload(char *data) {
+    const auto kind = next_random() % 4;
+    size_t length = 0;
+
+    if (kind == 0) {
+        // Arbitrary bytes, including zeros
+        length = next_random() % MAX_PAYLOAD;
+        for (size_t i = 0; i < length; ++i) data[i] = (char) next_random();
+    } else if (kind == 1) {
+        length = next_random() % MAX_PAYLOAD;
+        for (size_t i = 0; i < length; ++i) data[i] = ALPHABET[next_random() % (sizeof(ALPHABET) - 1)];
+    } else {
+        // Well-formed numbers of any width, around the type bounds, with optional padding
+        static constexpr const char *PADDING[] = {"", "", " ", "\t", "\r\n", "  "};
+        const auto *prefix = PADDING[next_random() % std::size(PADDING)];
+        const auto *suffix = PADDING[next_random() % std::size(PADDING)];
+        const auto *sign = next_random() % 4 == 0 ? "-" : next_random() % 8 == 0 ? "+" : "";
+
+        static constexpr uint64_t BOUNDS[] = {0, 1, 100, 127, 128, 255, 256, 8191, 32767, 32768, 65535, 65536,
+                                              2147483647ull, 2147483648ull, 4294967295ull, 4294967296ull,
+                                              1099511627776ull, 99999999999999999ull};
+        const uint64_t value = kind == 2 ? BOUNDS[next_random() % std::size(BOUNDS)] + next_random() % 3 - 1
+                                         : ((uint64_t) next_random() << 32 | next_random()) >> (next_random() % 64);
+
+        length = snprintf(data, MAX_PAYLOAD, "%s%s%llu%s", prefix, sign, (unsigned long long) value, suffix);
+        length = std::min(length, MAX_PAYLOAD - 1);
+    }
+
+    return length;
+}
+
+// Straightforward reading of the accepted grammar: [space]* [+|-]? digit+ [space]*, value within [min, max]
+static bool reference_parse(const char *data, size_t length, int64_t min, int64_t max, int64_t &out) {
+    size_t begin = 0, end = length;
+    while (begin < end && strchr(" \t\r\n", data[begin]) && data[begin]) ++begin;
+    while (end > begin && strchr(" \t\r\n", data[end - 1]) && data[end - 1]) --end;
+
+    bool negative = false;
+    if (begin < end && (data[begin] == '-' || data[begin] == '+')) negative = data[begin++] == '-';
+    if (begin == end) return false;
+
+    __int128 value = 0;
+    for (size_t i = begin; i < end; ++i) {
+        if (data[i] < '0' || data[i] > '9') return false;
+        if (value < ((__int128) 1 << 100)) value = value * 10 + (data[i] - '0');
+    }
+
+    if (negative) value = -value;
+    if (value < min || value > max) return false;
+
+    out = (int64_t) value;
+    return true;
+}
+
+struct FuzzTotals {
+    uint32_t accepted = 0;
+    uint32_t mismatches = 0;
+    uint32_t touched = 0;       // Output written on a rejected payload
+};
+
+template<typename T>
+static void fuzz_case(const char *data, size_t length, T min, T max, FuzzTotals &totals) {
+    constexpr T SENTINEL = (T) 0x5a5a5a5a;
+
+    T out = SENTINEL;
+    const bool parsed = parse_int<T>(data, length, out, min, max);
+
+    int64_t expected = 0;
+    const bool expected_parsed = reference_parse(data, length, min, max, expected);
+
+    if (parsed != expected_parsed || (parsed && (int64_t) out != expected)) ++totals.mismatches;
+    if (!parsed && out != SENTINEL) ++totals.touched;
+    if (parsed) ++totals.accepted;
+}
+
+static bool run_fuzz() {
+    FuzzTotals totals;
+    char buffer[MAX_PAYLOAD + 2];
+
+    for (uint32_t i = 0; i < FUZZ_CASES; ++i) {
+        char *data = buffer + 1;
+        const size_t length = random_payload(data);
+        buffer[0] = GUARD;
+        data[length] = GUARD;
+
+        switch (i % 5) {
+            case 0: fuzz_case<uint8_t>(data, length, 0, UINT8_MAX, totals); break;
+            case 1: fuzz_case<uint16_t>(data, length, 0, PWM_MAX_VALUE, totals); break;
+            case 2: fuzz_case<uint16_t>(data, length, 0, 100, totals); break;
+            case 3: fuzz_case<int32_t>(data, length, INT32_MIN, INT32_MAX, totals); break;
+            default: fuzz_case<uint32_t>(data, length, 0, UINT32_MAX, totals); break;
+        }
+    }
+
+    uint8_t out = 1;
+    const bool null_rejected = !parse_int<uint8_t>(nullptr, 4, out) && out == 1;
+
+    const bool success = totals.mismatches == 0 && totals.touched == 0 && null_rejected
+                         && totals.accepted > FUZZ_CASES / 10;
+
+    printf("fuzz     %s  cases: %u  accepted: %u  mismatches: %u  touched: %u\n",
+        success ? "OK  " : "FAIL", FUZZ_CASES, totals.accepted, totals.mismatches, totals.touched);
+
+    return success;
+}
+
+// Every value survives format -> parse, short buffers are refused without writing past their size
+static bool run_round_trip() {
+    uint32_t mismatches = 0, overflows = 0;
+
+    for (uint32_t i = 0; i < FUZZ_CASES; ++i) {
+        const auto value = (int32_t) (next_random() >> (next_random() % 32));
+        const size_t size = 1 + next_random() % 14;
+
+        char buffer[16];
+        memset(buffer, GUARD, sizeof(buffer));
+
+        const size_t length = format_int(buffer, size, value);
+        for (size_t j = size; j < sizeof(buffer); ++j) overflows += buffer[j] != GUARD;
+
+        char expected[16];
+        const size_t expected_length = snprintf(expected, sizeof(expected), "%d", (int) value);
+        if (expected_length + 1 > size) {
+            mismatches += length != 0;
+            continue;
+        }
+
+        int32_t parsed = 0;
+        if (length != expected_length || strcmp(buffer, expected) != 0
+            || !parse_int<int32_t>(buffer, length, parsed) || parsed != value) {
+            ++mismatches;
+        }
+    }
+
+    const bool success = mismatches == 0 && overflows == 0;
+    printf("format   %s  cases: %u  mismatches: %u  overflows: %u\n",
+        success ? "OK  " : "FAIL", FUZZ_CASES, mismatches, overflows);
+
+    return success;
+}
+
+// Typical MQTT payloads: each message is parsed into the parameter and formatted back for the state topic
+static bool run_throughput() {
+    static constexpr const char *PAYLOADS[] = {"1", "0", "2048", "8191", "50\r\n", " 100", "4000", "-1", "on", "65536"};
+
+    size_t lengths[std::size(PAYLOADS)];
+    for (size_t i = 0; i < std::size(PAYLOADS); ++i) lengths[i] = strlen(PAYLOADS[i]);
+
+    const auto allocations = SimulatedHal::allocation_count();
+    const auto start = std::chrono::steady_clock::now();
+
+    uint32_t accepted = 0, checksum = 0;
+    for (uint32_t i = 0; i < BENCHMARK_MESSAGES; ++i) {
+        const size_t index = i % std::size(PAYLOADS);
+
+        uint16_t value;
+        if (!parse_int<uint16_t>(PAYLOADS[index], lengths[index], value, 0, PWM_MAX_VALUE)) continue;
+
+        char buffer[8];
+        checksum += format_int(buffer, sizeof(buffer), value) + buffer[0];
+        ++accepted;
+    }
+
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    const auto allocated = SimulatedHal::allocation_count() - allocations;
+
+    const bool success = allocated == 0 && accepted == BENCHMARK_MESSAGES / std::size(PAYLOADS) * 7 && checksum > 0;
+    printf("payloads %s  %.1f M msgs/s  accepted: %u of %u  allocs: %llu\n",
+        success ? "OK  " : "FAIL", BENCHMARK_MESSAGES / seconds / 1e6, accepted, BENCHMARK_MESSAGES,
+        (unsigned long long) allocated);
+
+    return success;
+}
+
+int run_parse_simulation() {
+    int result = 0;
+
+    if (!run_fuzz()) result = 1;
+    if (!run_round_trip()) result = 1;
+    if (!run_throughput()) result = 1;
+
+    return result;
+}
@@ -0,0 +1,143 @@
+#include <Arduino.h>
+
+#include <algorithm>
+
+#include "hal.h"
+#include "simulation.h"
+
+#include "misc/led.h"
+
+static constexpr uint8_t PINS[] = {LED_R_PIN, LED_G_PIN, LED_B_PIN};
+static constexpr uint16_t LEVELS[] = {0, 0x4000, 0x8000, 0xc000, 0xffff};
+static constexpr uint16_t BRIGHTNESS[] = {PWM_MAX_VALUE / 8, PWM_MAX_VALUE / 4, PWM_MAX_VALUE / 2, PWM_MAX_VALUE};
+
+struct Timeline {
+    uint8_t peak = 0;           // Channels on at the same instant
+    uint32_t overlap = 0;       // On-time stacked above a single channel, duty units
+};
+
+// Walks one PWM period, every channel is on in [phase, phase + duty)
+static Timeline simulate_period(const uint16_t *duty, const uint16_t *phase, uint8_t count) {
+    uint32_t points[2 * 3];
+    uint8_t point_count = 0;
+    for (uint8_t i = 0; i < count; ++i) {
+        points[point_count++] = phase[i];
+        points[point_count++] = phase[i] + duty[i];
+    }
+
+    std::sort(points, points + point_count);
+
+    Timeline result;
+    for (uint8_t k = 0; k + 1 < point_count; ++k) {
+        const uint32_t from = points[k], to = points[k + 1];
+        if (from == to) continue;
+
+        uint8_t on = 0;
+        for (uint8_t i = 0; i < count; ++i) on += phase[i] <= from && from < phase[i] + duty[i];
+
+        result.peak = std::max(result.peak, on);
+        if (on > 1) result.overlap += (on - 1) * (to - from);
+    }
+
+    return result;
+}
+
+struct PhaseTotals {
+    uint32_t cases = 0;
+    uint32_t failures = 0;
+
+    uint32_t aligned_peak = 0;
+    uint32_t staggered_peak = 0;
+    uint64_t aligned_overlap = 0;
+    uint64_t staggered_overlap = 0;
+};
+
+template<typename Controller>
+static void check_output(const Controller &led, uint8_t count, uint16_t period, PhaseTotals &totals) {
+    uint16_t duty[3], phase[3];
+    const uint16_t aligned[3] = {};
+
+    uint32_t sum = 0;
+    bool fits = true;
+    for (uint8_t i = 0; i < count; ++i) {
+        duty[i] = SimulatedHal::duty(PINS[i]);
+        phase[i] = led.phase(i);
+
+        sum += duty[i];
+        fits &= phase[i] + duty[i] <= period;
+    }
+
+    const auto before = simulate_period(duty, aligned, count);
+    const auto after = simulate_period(duty, phase, count);
+
+    // On-times never wrap, never overlap more than aligned ones, and don't overlap at all while they fit the period
+    const bool ok = fits && after.peak <= before.peak && after.overlap <= before.overlap
+                    && (sum > period || after.peak <= 1);
+
+    ++totals.cases;
+    if (!ok) ++totals.failures;
+
+    totals.aligned_peak += before.peak;
+    totals.staggered_peak += after.peak;
+    totals.aligned_overlap += before.overlap;
+    totals.staggered_overlap += after.overlap;
+}
+
+static bool report(const char *name, const PhaseTotals &totals, uint16_t period) {
+    const bool success = totals.failures == 0;
+    printf("%-4s %s  cases: %4u  avg peak: %.2f -> %.2f channels  avg overlap: %5.1f%% -> %5.1f%% of the period\n",
+        name, success ? "OK  " : "FAIL", totals.cases,
+        (double) totals.aligned_peak / totals.cases, (double) totals.staggered_peak / totals.cases,
+        100.0 * totals.aligned_overlap / totals.cases / period, 100.0 * totals.staggered_overlap / totals.cases / period);
+
+    return success;
+}
+
+int run_phase_simulation() {
+    constexpr uint16_t period = PwmDefault::MAX_VALUE;
+    int result = 0;
+
+    {
+        SimulatedHal::reset();
+
+        PwmLedController<PwmDefault> rgb(LED_R_PIN, LED_G_PIN, LED_B_PIN);
+        rgb.begin();
+
+        PhaseTotals totals;
+        for (auto r: LEVELS) {
+            for (auto g: LEVELS) {
+                for (auto b: LEVELS) {
+                    rgb.set_color({r, g, b});
+
+                    for (auto brightness: BRIGHTNESS) {
+                        rgb.set_brightness(brightness);
+                        check_output(rgb, 3, period, totals);
+                    }
+                }
+            }
+        }
+
+        if (!report("RGB", totals, period)) result = 1;
+    }
+
+    {
+        SimulatedHal::reset();
+
+        PwmLedController<PwmDefault> cct(LED_R_PIN, LED_G_PIN);
+        cct.begin();
+
+        PhaseTotals totals;
+        for (uint32_t temperature = 0; temperature <= PWM_MAX_VALUE; temperature += PWM_MAX_VALUE / 16) {
+            cct.set_temperature(temperature);
+
+            for (auto brightness: BRIGHTNESS) {
+                cct.set_brightness(brightness);
+                check_output(cct, 2, period, totals);
+            }
+        }
+
+        if (!report("CCT", totals, period)) result = 1;
+    }
+
+    return result;
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+// Host-side scenarios of the `native` environment. Each returns process exit code (0 - success)
+
+int run_tick_simulation();
+int run_boot_simulation();
+int run_night_simulation();
+int run_button_simulation();
+int run_ota_simulation();
+int run_history_simulation();
+int run_sntp_simulation();
+int run_admission_simulation();
+int run_steady_simulation();
+int run_phase_simulation();
+int run_timer_simulation();
+int run_notification_simulation();
+int run_feed_simulation();
+int run_parse_simulation();
+int run_benchmarks();
@@ -0,0 +1,165 @@
+#include <Arduino.h>
+
+#include <cmath>
+#include <cstdlib>
+
+#include "hal.h"
+#include "simulation.h"
+
+#include "network/sntp.h"
+
+static constexpr unsigned long STEP_MS = 5;
+static constexpr unsigned long SECONDS_PER_DAY = 24ul * 60 * 60;
+static constexpr int64_t MAX_JUMP_MS = 60 * 1000;
+
+// 2024-01-01 00:00:00.250 UTC
+static constexpr int64_t START_EPOCH_MS = 1704067200250ll;
+static constexpr uint32_t NTP_UNIX_OFFSET = 2208988800ul;
+
+struct SntpScenario {
+    const char *name;
+
+    double drift_ppm;               // Speed of the true clock against millis()
+    unsigned long days;
+
+    // Network delays in ms (multiple of STEP_MS), cycled per request
+    uint32_t up[4];
+    uint32_t down[4];
+
+    uint32_t lost;                  // First requests that never get a reply
+    uint32_t bogus;                 // Invalid replies sent ahead of every valid one
+
+    int32_t max_error;              // Allowed clock error at the end of the simulation, ms
+
+    uint64_t start = 0;             // millis() at boot
+};
+
+static constexpr SntpScenario SNTP_SCENARIOS[] = {
+    {"symmetric", 0, 1, {20, 20, 20, 20}, {20, 20, 20, 20}, 0, 0, 1},
+    {"jitter", 0, 1, {250, 40, 10, 120}, {10, 300, 10, 60}, 0, 0, 1},
+    {"asymmetric", 0, 1, {200, 200, 200, 200}, {10, 10, 10, 10}, 0, 0, 100},
+    {"drift +100ppm", 100, 4, {20, 20, 20, 20}, {20, 20, 20, 20}, 0, 0, 5},
+    {"drift -40ppm", -40, 4, {20, 20, 20, 20}, {20, 20, 20, 20}, 0, 0, 5},
+    {"loss", 0, 1, {20, 20, 20, 20}, {20, 20, 20, 20}, 6, 0, 1},
+    {"bogus", 0, 1, {20, 20, 20, 20}, {20, 20, 20, 20}, 0, 2, 1},
+
+    // millis() wraps around 6 hours after boot, between two daily syncs
+    {"wraparound", 50, 2, {20, 20, 20, 20}, {20, 20, 20, 20}, 0, 0, 5, 0x100000000ull - 6 * 3600 * 1000},
+};
+
+struct SntpServer {
+    const SntpScenario &scenario;
+    uint32_t requests = 0;
+};
+
+// By the simulated time, millis() wraps around
+static int64_t true_time_ms(const SntpScenario &scenario, uint64_t time) {
+    const auto uptime = (int64_t) (time - scenario.start);
+    return START_EPOCH_MS + uptime + llround((double) uptime * scenario.drift_ppm / 1e6);
+}
+
+static void write_u32(uint8_t *data, uint32_t value) {
+    data[0] = value >> 24;
+    data[1] = value >> 16;
+    data[2] = value >> 8;
+    data[3] = value;
+}
+
+static void write_timestamp(uint8_t *data, int64_t time_ms) {
+    write_u32(data, (uint32_t) (time_ms / 1000 + NTP_UNIX_OFFSET));
+
+    // Rounded up, so the client gets the same millisecond back
+    write_u32(data + 4, (uint32_t) ((((uint64_t) (time_ms % 1000) << 32) + 999) / 1000));
+}
+
+static void respond(const uint8_t *data, size_t length, void *arg) {
+    auto &server = *(SntpServer *) arg;
+    const auto &scenario = server.scenario;
+    const auto index = server.requests++;
+
+    if (length != 48 || (data[0] & 0x07) != 3 || index < scenario.lost) return;
+
+    const auto now = SimulatedHal::time_ms();
+    const auto receive = now + scenario.up[index % 4];
+    const auto transmit = receive + STEP_MS;
+    const auto arrival = transmit + scenario.down[index % 4];
+
+    uint8_t reply[48] = {};
+    reply[0] = 0b00100100;      // LI 0, version 4, mode 4 (server)
+    reply[1] = 2;
+    memcpy(reply + 24, data + 40, 8);
+    write_timestamp(reply + 32, true_time_ms(scenario, receive));
+    write_timestamp(reply + 40, true_time_ms(scenario, transmit));
+
+    for (uint32_t i = 0; i < scenario.bogus; ++i) {
+        uint8_t invalid[48];
+        memcpy(invalid, reply, sizeof(invalid));
+
+        // Kiss-o'-Death or a stale reply to some other request
+        if (i % 2 == 0) invalid[1] = 0;
+        else invalid[24] ^= 0xff;
+
+        SimulatedHal::deliver_udp(invalid, sizeof(invalid), arrival - STEP_MS);
+    }
+
+    SimulatedHal::deliver_udp(reply, sizeof(reply), arrival);
+}
+
+static bool simulate_sntp(const SntpScenario &scenario) {
+    SimulatedHal::reset();
+    SimulatedHal::set_millis(scenario.start);
+
+    SntpServer server{scenario};
+    SimulatedHal::set_udp_responder(respond, &server);
+
+    SntpClient client("simulated");
+    client.begin(0);
+
+    unsigned long first_sync = 0;
+    int32_t max_error = 0;          // Over the whole run, including the uncompensated first day
+    int32_t error = 0;
+
+    // The clock moves by the step, a sync corrects the uncompensated drift by seconds at most
+    uint64_t previous_epoch = 0;
+    uint32_t jumps = 0;
+
+    const unsigned long total_steps = scenario.days * SECONDS_PER_DAY * 1000 / STEP_MS;
+    for (unsigned long step = 0; step < total_steps; ++step) {
+        SimulatedHal::advance_millis(STEP_MS);
+        client.update();
+
+        if (!client.available()) continue;
+        if (first_sync == 0) first_sync = SimulatedHal::time_ms() - scenario.start;
+
+        const auto epoch = client.epoch_ms();
+        if (previous_epoch != 0 && llabs((int64_t) (epoch - previous_epoch) - (int64_t) STEP_MS) > MAX_JUMP_MS) ++jumps;
+        previous_epoch = epoch;
+
+        error = (int32_t) ((int64_t) epoch - true_time_ms(scenario, SimulatedHal::time_ms()));
+        max_error = std::max(max_error, abs(error));
+    }
+
+    const auto &stats = client.stats();
+    // The server is looked up once, and again only after a lost reply
+    const bool success = client.available() && abs(error) <= scenario.max_error && jumps == 0
+                         && stats.lookups >= 1 && stats.lookups <= 1 + stats.timeouts
+                         && stats.lookups == SimulatedHal::dns_lookups()
+                         && stats.timeouts >= std::min<uint32_t>(scenario.lost, stats.requests)
+                         && stats.rejected >= (scenario.bogus > 0 ? stats.replies * scenario.bogus : 0);
+
+    printf("%-14s %s  first sync: %6lu ms  error: %4d/%-4d ms  max: %5d ms  delay: %3u ms  drift: %7d ppb"
+           "  req: %3u  lost: %u  rejected: %u  lookups: %u  jumps: %u\n",
+        scenario.name, success ? "OK  " : "FAIL", first_sync, error, scenario.max_error, max_error,
+        stats.delay, stats.drift, stats.requests, stats.timeouts, stats.rejected, stats.lookups, jumps);
+
+    return success;
+}
+
+int run_sntp_simulation() {
+    int result = 0;
+    for (const auto &scenario: SNTP_SCENARIOS) {
+        if (!simulate_sntp(scenario)) result = 1;
+    }
+
+    return result;
+}
@@ -0,0 +1,152 @@
+#include <Arduino.h>
+
+#include <climits>
+
+#include "hal.h"
+#include "simulation.h"
+
+#include "app/command.h"
+#include "misc/history.h"
+#include "misc/led.h"
+#include "misc/night_mode.h"
+#include "network/admission.h"
+#include "network/history_json.h"
+#include "network/sntp.h"
+#include "utils/json.h"
+
+static constexpr unsigned long STEP_MS = 10;
+static constexpr unsigned long WARM_UP_MS = 60 * 1000;
+static constexpr unsigned long SIMULATION_MS = 2 * 3600 * 1000;
+
+static constexpr unsigned long HISTORY_INTERVAL = 1000;
+static constexpr unsigned long REQUEST_INTERVAL = 100;
+
+// 2024-01-01 21:30:00 UTC, the run crosses the start of the night
+static constexpr uint64_t START_EPOCH_MS = 1704144600000ull;
+static constexpr uint32_t NTP_UNIX_OFFSET = 2208988800ul;
+
+static void write_timestamp(uint8_t *data, uint64_t time_ms) {
+    const uint32_t seconds = time_ms / 1000 + NTP_UNIX_OFFSET;
+    const uint32_t fraction = (((time_ms % 1000) << 32) + 999) / 1000;
+
+    for (int i = 0; i < 4; ++i) {
+        data[i] = seconds >> (24 - i * 8);
+        data[i + 4] = fraction >> (24 - i * 8);
+    }
+}
+
+static void respond(const uint8_t *data, size_t length, void *) {
+    if (length != 48) return;
+
+    uint8_t reply[48] = {};
+    reply[0] = 0b00100100;      // LI 0, version 4, mode 4 (server)
+    reply[1] = 2;
+    memcpy(reply + 24, data + 40, 8);
+    write_timestamp(reply + 32, START_EPOCH_MS + millis() + 20);
+    write_timestamp(reply + 40, START_EPOCH_MS + millis() + 20);
+
+    SimulatedHal::deliver_udp(reply, sizeof(reply), SimulatedHal::time_ms() + 40);
+}
+
+// A page of the largest values must fit the response slot, a smaller slot gets a shorter page
+static bool worst_case_page_fits(const HistoryBuffer &history) {
+    HistoryEvent events[HISTORY_HTTP_PAGE_SIZE];
+    for (auto &event: events) event = {UINT32_MAX, UINT32_MAX, (HistoryEventType) UINT8_MAX, UINT32_MAX};
+
+    char buffer[API_RESPONSE_SIZE];
+    const size_t length = write_history_page_json(buffer, sizeof(buffer), UINT32_MAX, UINT32_MAX, ULONG_MAX,
+                                                   events, HISTORY_HTTP_PAGE_SIZE);
+
+    const bool shrinks = write_history_json(history, history.first_seq(), ULONG_MAX, buffer, API_RESPONSE_SIZE / 4) > 0
+                         && write_history_json(history, history.first_seq(), ULONG_MAX, buffer, 16) < 0;
+
+    const bool success = length > 0 && shrinks;
+    printf("worst page %s  %zu/%u bytes  shrinks: %s\n", success ? "OK  " : "FAIL", length, API_RESPONSE_SIZE,
+        shrinks ? "yes" : "no");
+
+    return success;
+}
+
+// Subsystems are constructed once, then a long run of the loop work must not touch the heap
+int run_steady_simulation() {
+    SimulatedHal::reset();
+    SimulatedHal::set_udp_responder(respond, nullptr);
+
+    Config config;
+    config.brightness = 2048;
+    config.night_mode.enabled = true;
+    config.night_mode.brightness = 10;
+    config.night_mode.start_time = 22 * 3600;
+    config.night_mode.end_time = 6 * 3600;
+    config.night_mode.switch_interval = 15 * 60;
+
+    LedControllerSlot led;
+    led.create(LedType::RGB, 1, 2, 3, PwmProfile::DEFAULT).begin();
+
+    NightModeManager night(config);
+    night.reset();
+
+    SntpClient ntp_time("simulated");
+    ntp_time.begin(0);
+
+    HistoryBuffer history;
+    AdmissionControl admission;
+    CommandQueue commands;
+
+    char response[API_RESPONSE_SIZE];
+    uint32_t cursor = 0;
+
+    uint64_t allocations = 0;
+    uint32_t responses = 0;
+    uint32_t truncated = 0;
+    uint32_t night_steps = 0;
+
+    for (unsigned long time = 0; time < SIMULATION_MS; time += STEP_MS) {
+        if (time == WARM_UP_MS) allocations = SimulatedHal::allocation_count();
+
+        SimulatedHal::advance_millis(STEP_MS);
+
+        ntp_time.update();
+        if (ntp_time.available()) night.handle_night(ntp_time.epoch_tz_ms());
+
+        const uint16_t brightness = night.get_brightness();
+        led->set_brightness(brightness);
+        if (night.is_night_time()) ++night_steps;
+
+        if (time % HISTORY_INTERVAL == 0) {
+            commands.push({CommandType::BRIGHTNESS, brightness});
+
+            Command command;
+            while (commands.pop(command)) history.record(HistoryEventType::BRIGHTNESS, command.value, millis());
+        }
+
+        if (time % REQUEST_INTERVAL == 0) {
+            const uint32_t client = 0x0A000100u + (time / REQUEST_INTERVAL) % ADMISSION_CLIENT_SLOTS;
+            if (admission.admit(client, 40000) == Admission::ACCEPT) {
+                if (write_history_json(history, cursor, millis(), response, sizeof(response)) > 0) ++responses;
+                else ++truncated;
+
+                cursor = history.first_seq();
+                admission.release(client);
+            }
+        }
+    }
+
+    allocations = SimulatedHal::allocation_count() - allocations;
+
+    const bool success = allocations == 0 && ntp_time.available() && night_steps > 0 && truncated == 0
+                         && worst_case_page_fits(history);
+    printf("steady     %s  allocations: %llu  responses: %u  truncated: %u  night: %lu s\n",
+        success ? "OK  " : "FAIL", (unsigned long long) allocations, responses, truncated, night_steps * STEP_MS / 1000);
+
+    printf("\nStatic budget, bytes:\n");
+    printf("  %-16s %6zu\n", "led", sizeof(led));
+    printf("  %-16s %6zu\n", "night", sizeof(night));
+    printf("  %-16s %6zu\n", "ntp", sizeof(ntp_time));
+    printf("  %-16s %6zu\n", "history", sizeof(history));
+    printf("  %-16s %6zu\n", "admission", sizeof(admission));
+    printf("  %-16s %6zu\n", "commands", sizeof(commands));
+    printf("  %-16s %6zu\n", "response slots", (size_t) ADMISSION_MAX_IN_FLIGHT * API_RESPONSE_SIZE);
+
+    return success ? 0 : 1;
+}
@@ -0,0 +1,214 @@
+#include <chrono>
+
+#include <Arduino.h>
+
+#include "hal.h"
+#include "simulation.h"
+
+#include "app/animation.h"
+#include "misc/led.h"
+#include "misc/night_mode.h"
+#include "misc/timer_wheel.h"
+
+static constexpr unsigned long SIMULATION_TICKS = 200000;
+static constexpr unsigned long HOLD_MS = 3000;              // In STAND_BY between the animations
+static constexpr unsigned long TRANSITION_MS = 1500;
+
+struct TickTotals {
+    uint32_t animations = 0;
+    uint32_t wrong_direction = 0;   // Fade moved against its direction
+    uint32_t wrong_end = 0;         // Finished away from its target
+    uint32_t late = 0;              // Finished after its duration plus a tick
+    uint32_t early_flash = 0;       // Flashing before the first flash period is over
+};
+
+// The app loop state machine: connecting, then power on, a preset transition, power off, over and over.
+// The brightness comes from animation_step(), the same code Application::_app_loop runs
+struct LoopModel {
+    Config config;
+    NightModeManager night_mode{config};
+    LedController *led = nullptr;
+    TickTotals totals;
+
+    AppState state = AppState::INITIALIZATION;
+    unsigned long state_change_time = 0;
+    uint16_t transition_from = 0;
+    uint16_t last = 0;
+    uint16_t last_target = 0;       // The night fade moves the target, the direction is checked only while it holds
+
+    void change_state(AppState next) {
+        state = next;
+        state_change_time = millis();
+        ++totals.animations;
+    }
+
+    [[nodiscard]] uint16_t target() const {
+        if (night_mode.is_night_time()) return night_mode.get_brightness();
+        return std::max(config.sys_config.led_min_brightness, config.brightness);
+    }
+
+    void tick() {
+        const auto elapsed = millis() - state_change_time;
+        const bool night = state == AppState::STAND_BY && config.power && night_mode.is_night_time();
+
+        const auto step = animation_step({
+            state, elapsed, config.power, target(), transition_from, TRANSITION_MS,
+            config.sys_config.power_change_timeout, config.sys_config.wifi_connect_flash_timeout,
+            night, night ? night_mode.get_brightness() : (uint16_t) 0,
+        });
+
+        if (step.write) {
+            _check(step, elapsed, target() == last_target);
+            led->set_brightness(step.brightness);
+            last = step.brightness;
+        }
+
+        last_target = target();
+
+        if (step.finished) change_state(AppState::STAND_BY);
+        else if (state != AppState::STAND_BY && state != AppState::INITIALIZATION) return;
+
+        _next(elapsed);
+    }
+
+private:
+    void _check(const AnimationStep &step, unsigned long elapsed, bool steady) {
+        switch (state) {
+            case AppState::INITIALIZATION:
+                if (elapsed < config.sys_config.wifi_connect_flash_timeout) ++totals.early_flash;
+                break;
+
+            case AppState::TURNING_ON:
+                if (steady && step.brightness < last) ++totals.wrong_direction;
+                if (step.finished && step.brightness != target()) ++totals.wrong_end;
+                if (step.finished && elapsed > config.sys_config.power_change_timeout + APP_LOOP_INTERVAL) ++totals.late;
+                break;
+
+            case AppState::TURNING_OFF:
+                if (steady && step.brightness > last) ++totals.wrong_direction;
+                if (step.finished && step.brightness != 0) ++totals.wrong_end;
+                if (step.finished && elapsed > config.sys_config.power_change_timeout + APP_LOOP_INTERVAL) ++totals.late;
+                break;
+
+            case AppState::TRANSITION: {
+                const bool up = target() >= transition_from;
+                if (steady && (up ? step.brightness < last : step.brightness > last)) ++totals.wrong_direction;
+                if (step.finished && step.brightness != target()) ++totals.wrong_end;
+                if (step.finished && elapsed > TRANSITION_MS + APP_LOOP_INTERVAL) ++totals.late;
+                break;
+            }
+
+            default:
+                break;
+        }
+    }
+
+    // What the app does next: set_power(), recall_preset() or the framework reaching READY
+    void _next(unsigned long elapsed) {
+        if (state == AppState::INITIALIZATION) {
+            if (elapsed < 3 * config.sys_config.wifi_connect_flash_timeout) return;
+
+            config.power = false;
+            change_state(AppState::STAND_BY);
+            return;
+        }
+
+        if (millis() - state_change_time < HOLD_MS) return;
+
+        if (!config.power) {
+            config.power = true;
+            last = 0;
+            change_state(AppState::TURNING_ON);
+        } else if (config.brightness == 2048) {
+            transition_from = target();
+            config.brightness = 6000;
+            last = transition_from;
+            change_state(AppState::TRANSITION);
+        } else {
+            config.brightness = 2048;
+            config.power = false;
+            last = target();
+            change_state(AppState::TURNING_OFF);
+        }
+    }
+};
+
+struct WheelLoop {
+    LoopModel *model;
+    unsigned long ticks = 0;
+    unsigned long last_tick = 0;
+    uint32_t off_interval = 0;      // Ticks not APP_LOOP_INTERVAL after the previous one
+};
+
+static bool simulate_ticks(const char *name, LedController &led, bool night) {
+    SimulatedHal::reset();
+
+    LoopModel model;
+    // The night fades in from 100 s into the run
+    model.config.night_mode.enabled = night;
+    model.config.night_mode.start_time = 1000;
+    model.night_mode.reset();
+    model.led = &led;
+    led.begin();
+
+    // Driven as Application::event_loop() does: the wheel fires the app timer, the loop sleeps until its deadline
+    WheelLoop loop{&model};
+
+    TimerWheel wheel;
+    WheelTimer app_timer{[](void *arg) {
+        auto &loop = *(WheelLoop *) arg;
+        if (loop.ticks > 0 && millis() - loop.last_tick != APP_LOOP_INTERVAL) ++loop.off_interval;
+        loop.last_tick = millis();
+        ++loop.ticks;
+
+        loop.model->tick();
+        loop.model->night_mode.handle_night(millis());
+    }, &loop};
+
+    wheel.begin(millis());
+    wheel.schedule(app_timer, APP_LOOP_INTERVAL, APP_LOOP_INTERVAL);
+
+    uint32_t spins = 0;             // Passes that found nothing due and had nothing to sleep for
+    const auto start = std::chrono::steady_clock::now();
+    while (loop.ticks < SIMULATION_TICKS) {
+        wheel.update(millis());
+
+        const unsigned long sleep = std::min<unsigned long>(wheel.next_deadline(millis()), APP_LOOP_INTERVAL);
+        SimulatedHal::advance_millis(sleep > 0 ? sleep : 1);
+        if (sleep == 0) ++spins;
+    }
+
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+
+    const auto &totals = model.totals;
+    const bool success = totals.animations > 100 && totals.wrong_direction == 0 && totals.wrong_end == 0
+                         && totals.late == 0 && totals.early_flash == 0
+                         && loop.off_interval == 0 && spins == 0;
+
+    printf("%-8s %s %8.1f ns/tick  animations: %4u  wrong: %u/%u  late: %u  off interval: %u  spins: %u  writes: %-8u duty: %5d %5d %5d\n",
+        name, success ? "OK  " : "FAIL", (double) ns / SIMULATION_TICKS, totals.animations, totals.wrong_direction,
+        totals.wrong_end, totals.late, loop.off_interval, spins, SimulatedHal::write_count(),
+        SimulatedHal::duty(LED_R_PIN), SimulatedHal::duty(LED_G_PIN), SimulatedHal::duty(LED_B_PIN));
+
+    return success;
+}
+
+int run_tick_simulation() {
+    bool success = true;
+
+    PwmLedController<PwmDefault> single(LED_R_PIN);
+    success &= simulate_ticks("SINGLE", single, false);
+
+    PwmLedController<PwmDefault> cct(LED_R_PIN, LED_G_PIN);
+    success &= simulate_ticks("CCT", cct, false);
+
+    PwmLedController<PwmDefault> rgb(LED_R_PIN, LED_G_PIN, LED_B_PIN);
+    success &= simulate_ticks("RGB", rgb, false);
+
+    // Power fades and transitions run to the night brightness while it fades in
+    PwmLedController<PwmDefault> night(LED_R_PIN);
+    success &= simulate_ticks("NIGHT", night, true);
+
+    return success ? 0 : 1;
+}
@@ -0,0 +1,303 @@
+#include <Arduino.h>
+
+#include <chrono>
+#include <vector>
+
+#include "hal.h"
+#include "simulation.h"
+
+#include "misc/timer_wheel.h"
+
+static constexpr size_t PERIODIC_COUNT = 4096;
+static constexpr size_t ONE_SHOT_COUNT = 1024;
+static constexpr unsigned long SIMULATION_MS = 20 * 60 * 1000;
+static constexpr unsigned long BENCHMARK_MS = 5 * 60 * 1000;
+
+static constexpr unsigned long INTERVALS[] = {10, 20, 50, 100, 250, 1000, 5000, 60000, 600000};
+static constexpr unsigned long BENCHMARK_INTERVALS[] = {100, 250, 1000, 5000, 60000, 600000};
+
+static uint32_t random_state = 0x2545f491;
+
+static uint32_t next_random() {
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 17;
+    random_state ^= random_state << 5;
+    return random_state;
+}
+
+struct TimerTotals {
+    uint64_t fired = 0;
+    uint32_t early = 0;
+    uint32_t late = 0;
+    uint32_t cancelled = 0;
+};
+
+struct TimerContext {
+    WheelTimer timer;
+    TimerWheel *wheel = nullptr;
+    TimerTotals *totals = nullptr;
+
+    unsigned long expected = 0;     // Earliest allowed fire time
+    unsigned long interval = 0;     // 0 for one-shot, rescheduled from the callback
+
+    TimerContext() : timer(fire, this) {}
+
+    void schedule(unsigned long delay, unsigned long repeat) {
+        expected = millis() + delay;
+        interval = repeat;
+        wheel->schedule(timer, delay, repeat);
+    }
+
+    // Times are multiples of the tick, so a timer fires exactly when due
+    static void fire(void *arg) {
+        auto &self = *(TimerContext *) arg;
+        const unsigned long now = millis();
+
+        ++self.totals->fired;
+        if ((long) (now - self.expected) < 0) ++self.totals->early;
+        else if (now - self.expected >= TIMER_WHEEL_TICK) ++self.totals->late;
+
+        if (self.interval > 0) self.expected += self.interval;
+        else self.schedule(1 + next_random() % 600000, 0);
+    }
+};
+
+struct Workload {
+    TimerWheel wheel;
+    TimerTotals totals;
+    std::vector<TimerContext> periodic{PERIODIC_COUNT};
+    std::vector<TimerContext> one_shot{ONE_SHOT_COUNT};
+
+    void begin() {
+        wheel.begin(millis());
+
+        for (size_t i = 0; i < PERIODIC_COUNT; ++i) {
+            auto &context = periodic[i];
+            context.wheel = &wheel;
+            context.totals = &totals;
+
+            const auto interval = INTERVALS[i % std::size(INTERVALS)];
+            context.schedule(TIMER_WHEEL_TICK * (1 + next_random() % (interval / TIMER_WHEEL_TICK)), interval);
+        }
+
+        for (auto &context: one_shot) {
+            context.wheel = &wheel;
+            context.totals = &totals;
+            context.schedule(1 + next_random() % 600000, 0);
+        }
+    }
+
+    // Some one-shot timers are cancelled before they fire and scheduled again
+    void churn() {
+        auto &context = one_shot[next_random() % ONE_SHOT_COUNT];
+        wheel.cancel(context.timer);
+        ++totals.cancelled;
+
+        context.schedule(1 + next_random() % 600000, 0);
+    }
+
+    // Periodic timers fire once per interval, one-shot ones at least once per 10 minutes
+    [[nodiscard]] bool counts_match(unsigned long duration) const {
+        uint64_t expected = 0;
+        for (size_t i = 0; i < PERIODIC_COUNT; ++i) {
+            const auto interval = INTERVALS[i % std::size(INTERVALS)];
+            expected += duration / interval;
+        }
+
+        return totals.fired >= expected && totals.fired <= expected + PERIODIC_COUNT + ONE_SHOT_COUNT * (duration / 1000 + 1)
+               && wheel.size() == PERIODIC_COUNT + ONE_SHOT_COUNT;
+    }
+};
+
+static bool report(const char *name, const Workload &workload, uint32_t wakeups, uint64_t allocations) {
+    const auto &totals = workload.totals;
+    const bool success = totals.early == 0 && totals.late == 0 && allocations == 0 && workload.counts_match(SIMULATION_MS);
+
+    printf("%-8s %s  fired: %8llu  early: %u  late: %u  cancelled: %6u  wakeups: %6u  cascaded: %7u  allocs: %llu\n",
+        name, success ? "OK  " : "FAIL", (unsigned long long) totals.fired, totals.early, totals.late,
+        totals.cancelled, wakeups, workload.wheel.stats().cascaded, (unsigned long long) allocations);
+
+    return success;
+}
+
+// The app loop advances the wheel on every step
+static bool run_stepped() {
+    SimulatedHal::reset();
+
+    Workload workload;
+    workload.begin();
+
+    const auto allocations = SimulatedHal::allocation_count();
+    uint32_t wakeups = 0;
+
+    for (unsigned long time = 0; time < SIMULATION_MS; time += TIMER_WHEEL_TICK) {
+        SimulatedHal::advance_millis(TIMER_WHEEL_TICK);
+
+        workload.wheel.update(millis());
+        workload.churn();
+        ++wakeups;
+    }
+
+    return report("stepped", workload, wakeups, SimulatedHal::allocation_count() - allocations);
+}
+
+// The loop sleeps until the next deadline, so no timer may be late and empty ticks are skipped
+static bool run_sleeping() {
+    SimulatedHal::reset();
+
+    Workload workload;
+    workload.begin();
+
+    // Only the one-shot timers, thousands of periodic ones leave no tick empty
+    for (auto &context: workload.periodic) workload.wheel.cancel(context.timer);
+
+    const auto allocations = SimulatedHal::allocation_count();
+    uint32_t wakeups = 0;
+
+    while (millis() < SIMULATION_MS) {
+        const auto sleep = workload.wheel.next_deadline(millis());
+        SimulatedHal::advance_millis(std::max<unsigned long>(TIMER_WHEEL_TICK, sleep));
+
+        workload.wheel.update(millis());
+        ++wakeups;
+    }
+
+    const auto &totals = workload.totals;
+    const auto active = workload.wheel.size();
+    const bool success = totals.early == 0 && totals.late == 0 && totals.fired > ONE_SHOT_COUNT
+                         && active == ONE_SHOT_COUNT && wakeups < SIMULATION_MS / TIMER_WHEEL_TICK / 4
+                         && SimulatedHal::allocation_count() == allocations;
+
+    printf("%-8s %s  fired: %8llu  early: %u  late: %u  active: %zu  wakeups: %6u of %lu ticks\n",
+        "sleeping", success ? "OK  " : "FAIL", (unsigned long long) totals.fired, totals.early, totals.late,
+        active, wakeups, SIMULATION_MS / TIMER_WHEEL_TICK);
+
+    return success;
+}
+
+struct LongTimer {
+    unsigned long delay;
+    unsigned long fired_at = 0;
+};
+
+static void record_fire(void *arg) {
+    ((LongTimer *) arg)->fired_at = millis();
+}
+
+// Delays past the wheel range wait in the top level and are placed again until they are due
+static bool run_long_delays() {
+    SimulatedHal::reset();
+
+    LongTimer long_timers[] = {{30ul * 3600 * 1000}, {50ul * 3600 * 1000}, {100ul * 3600 * 1000}};
+    WheelTimer timers[] = {{record_fire, &long_timers[0]}, {record_fire, &long_timers[1]}, {record_fire, &long_timers[2]}};
+
+    TimerWheel wheel;
+    wheel.begin(millis());
+    for (size_t i = 0; i < std::size(timers); ++i) wheel.schedule(timers[i], long_timers[i].delay);
+
+    uint32_t wakeups = 0;
+    while (wheel.size() > 0 && wakeups < 100000) {
+        const auto sleep = wheel.next_deadline(millis());
+        SimulatedHal::advance_millis(std::max<unsigned long>(TIMER_WHEEL_TICK, sleep));
+
+        wheel.update(millis());
+        ++wakeups;
+    }
+
+    bool success = wheel.size() == 0;
+    for (const auto &long_timer: long_timers) success &= long_timer.fired_at == long_timer.delay;
+
+    printf("%-8s %s  fired: %8u  wakeups: %u over %lu h\n",
+        "long", success ? "OK  " : "FAIL", wheel.stats().fired, wakeups, millis() / 3600000);
+
+    return success;
+}
+
+// The Bootstrap timer model: every entry is checked on every loop pass
+struct ScanTimer {
+    unsigned long next;
+    unsigned long interval;
+};
+
+static double benchmark_scan(size_t count, uint32_t ticks, uint64_t &fired) {
+    std::vector<ScanTimer> timers(count);
+    for (size_t i = 0; i < count; ++i) {
+        const auto interval = BENCHMARK_INTERVALS[i % std::size(BENCHMARK_INTERVALS)];
+        timers[i] = {TIMER_WHEEL_TICK * (1 + next_random() % (interval / TIMER_WHEEL_TICK)), interval};
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+
+    unsigned long now = 0;
+    for (uint32_t tick = 0; tick < ticks; ++tick) {
+        now += TIMER_WHEEL_TICK;
+        for (auto &timer: timers) {
+            if ((long) (now - timer.next) < 0) continue;
+
+            timer.next += timer.interval;
+            ++fired;
+        }
+    }
+
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / ticks;
+}
+
+static void count_fire(void *arg) {
+    ++*(uint64_t *) arg;
+}
+
+struct CountingTimer {
+    static uint64_t fired;
+    WheelTimer timer{count_fire, &fired};
+};
+
+uint64_t CountingTimer::fired = 0;
+
+static double benchmark_wheel(size_t count, uint32_t ticks, uint64_t &fired) {
+    SimulatedHal::reset();
+
+    TimerWheel wheel;
+    wheel.begin(0);
+
+    CountingTimer::fired = 0;
+    std::vector<CountingTimer> timers(count);
+    for (size_t i = 0; i < count; ++i) {
+        const auto interval = BENCHMARK_INTERVALS[i % std::size(BENCHMARK_INTERVALS)];
+        wheel.schedule(timers[i].timer, TIMER_WHEEL_TICK * (1 + next_random() % (interval / TIMER_WHEEL_TICK)), interval);
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+
+    unsigned long now = 0;
+    for (uint32_t tick = 0; tick < ticks; ++tick) {
+        now += TIMER_WHEEL_TICK;
+        wheel.update(now);
+    }
+
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    fired = CountingTimer::fired;
+
+    return std::chrono::duration<double, std::nano>(elapsed).count() / ticks;
+}
+
+int run_timer_simulation() {
+    int result = 0;
+
+    if (!run_stepped()) result = 1;
+    if (!run_sleeping()) result = 1;
+    if (!run_long_delays()) result = 1;
+
+    printf("\nPer loop tick, %lu s simulated:\n", BENCHMARK_MS / 1000);
+    for (size_t count: {16, 256, 4096, 16384}) {
+        const uint32_t ticks = BENCHMARK_MS / TIMER_WHEEL_TICK;
+
+        uint64_t scan_fired = 0, wheel_fired = 0;
+        const double scan = benchmark_scan(count, ticks, scan_fired);
+        const double wheel = benchmark_wheel(count, ticks, wheel_fired);
+
+        printf("  %5zu timers  scan: %9.1f ns  wheel: %7.1f ns  fired: %llu/%llu\n",
+            count, scan, wheel, (unsigned long long) wheel_fired, (unsigned long long) scan_fired);
+    }
+
+    return result;
+}
@@ -0,0 +1,82 @@
+#include "admission.h"
+
+#include <algorithm>
+
+#include <Arduino.h>
+
+static constexpr uint32_t TOKEN = 1000;
+static constexpr uint32_t BUCKET_CAPACITY = ADMISSION_BURST * TOKEN;
+
+static_assert(ADMISSION_CLIENT_SLOTS > ADMISSION_MAX_IN_FLIGHT, "Every request in flight must keep its client slot");
+
+Admission AdmissionControl::admit(uint32_t client, uint32_t free_heap) {
+    auto &bucket = _bucket(client, millis());
+    if (bucket.in_flight >= ADMISSION_CLIENT_IN_FLIGHT) {
+        ++_stats.rate_limited;
+        return Admission::RATE_LIMITED;
+    }
+
+    // Checked before the tokens: while overloaded, requests shouldn't drain the buckets of well-behaved clients
+    if (_stats.in_flight >= ADMISSION_MAX_IN_FLIGHT) {
+        ++_stats.shed_in_flight;
+        return Admission::OVERLOADED;
+    }
+
+    if (free_heap < ADMISSION_MIN_FREE_HEAP) {
+        ++_stats.shed_heap;
+        return Admission::OVERLOADED;
+    }
+
+    if (bucket.tokens < TOKEN) {
+        ++_stats.rate_limited;
+        return Admission::RATE_LIMITED;
+    }
+
+    bucket.tokens -= TOKEN;
+    ++bucket.in_flight;
+
+    ++_stats.accepted;
+    ++_stats.in_flight;
+    _stats.max_in_flight = std::max(_stats.max_in_flight, _stats.in_flight);
+
+    return Admission::ACCEPT;
+}
+
+void AdmissionControl::release(uint32_t client) {
+    if (_stats.in_flight > 0) --_stats.in_flight;
+
+    if (auto bucket = _find(client); bucket && bucket->in_flight > 0) --bucket->in_flight;
+}
+
+AdmissionControl::Bucket &AdmissionControl::_bucket(uint32_t client, unsigned long now) {
+    if (auto bucket = _find(client)) {
+        // ADMISSION_RATE requests per second is ADMISSION_RATE tokens per ms in TOKEN units
+        const unsigned long elapsed = std::min<unsigned long>(now - bucket->last_refill, BUCKET_CAPACITY);
+        bucket->tokens = std::min<uint32_t>(BUCKET_CAPACITY, bucket->tokens + elapsed * ADMISSION_RATE);
+        bucket->last_refill = now;
+
+        return *bucket;
+    }
+
+    // The table is larger than ADMISSION_MAX_IN_FLIGHT, so there is always an idle slot
+    Bucket *oldest = nullptr;
+    for (auto &bucket: _buckets) {
+        if (bucket.in_flight > 0) continue;
+
+        if (!oldest || bucket.client == 0 || (oldest->client != 0 && now - bucket.last_refill > now - oldest->last_refill)) {
+            oldest = &bucket;
+            if (bucket.client == 0) break;
+        }
+    }
+
+    *oldest = {client, BUCKET_CAPACITY, now, 0};
+    return *oldest;
+}
+
+AdmissionControl::Bucket *AdmissionControl::_find(uint32_t client) {
+    for (auto &bucket: _buckets) {
+        if (bucket.client == client) return &bucket;
+    }
+
+    return nullptr;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+
+#include "lib/utils/enum.h"
+
+#include "constants.h"
+
+MAKE_ENUM_AUTO(Admission, uint8_t,
+    ACCEPT,
+    RATE_LIMITED,       // 429, the client exceeded its token bucket or its share of in-flight requests
+    OVERLOADED          // 503, too many requests in flight or too little heap
+);
+
+struct AdmissionStats {
+    uint32_t accepted = 0;
+    uint32_t rate_limited = 0;
+    uint32_t shed_in_flight = 0;
+    uint32_t shed_heap = 0;
+
+    uint8_t in_flight = 0;
+    uint8_t max_in_flight = 0;
+};
+
+// Decides whether an HTTP request is handled, before any work is done for it.
+// Each client (by IP) has a token bucket of ADMISSION_BURST requests refilled at ADMISSION_RATE per second.
+// A client may have at most ADMISSION_CLIENT_IN_FLIGHT requests in flight, so a slow one can't hold every slot.
+// The least recently seen idle client is evicted when the table is full, it starts again with a full bucket
+class AdmissionControl {
+    struct Bucket {
+        uint32_t client = 0;
+        uint32_t tokens = 0;        // 1/1000 of a request
+        unsigned long last_refill = 0;
+        uint8_t in_flight = 0;
+    };
+
+    Bucket _buckets[ADMISSION_CLIENT_SLOTS]{};
+    AdmissionStats _stats{};
+
+public:
+    // Accepted requests must be finished with release()
+    Admission admit(uint32_t client, uint32_t free_heap);
+    void release(uint32_t client);
+
+    [[nodiscard]] inline const AdmissionStats &stats() const { return _stats; }
+
+private:
+    Bucket &_bucket(uint32_t client, unsigned long now);
+    Bucket *_find(uint32_t client);
+};
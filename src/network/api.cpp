@@ -1,15 +1,48 @@
 #include "api.h"
 
+#include <algorithm>
+#include <climits>
+#include <cstdarg>
+#include <iterator>
+
+#include "network/history_json.h"
 #include "utils/math.h"
+#include "utils/parse.h"
 
 #include "app/application.h"
 
+// Static bodies: a rejected request doesn't take a slot
+static const char RATE_LIMITED_RESPONSE[] PROGMEM = R"({"status":"rate_limited"})";
+static const char OVERLOADED_RESPONSE[] PROGMEM = R"({"status":"busy"})";
+static const char TOO_LARGE_RESPONSE[] PROGMEM = R"({"status":"error"})";
+
+// Appends to a text body. A section that doesn't fit is cut off, `length` becomes `size` and later ones are skipped,
+// so the body ends after the last complete section
+static void _append(char *buffer, size_t size, size_t &length, const char *format, ...) __attribute__((format(printf, 4, 5)));
+
+static void _append(char *buffer, size_t size, size_t &length, const char *format, ...) {
+    if (length >= size) return;
+
+    va_list args;
+    va_start(args, format);
+    const int written = vsnprintf(buffer + length, size - length, format, args);
+    va_end(args);
+
+    if (written < 0 || (size_t) written >= size - length) {
+        buffer[length] = '\0';
+        length = size;
+        return;
+    }
+
+    length += written;
+}
+
 ApiWebServer::ApiWebServer(Application &application, const char *path) : _app(application), _path(path) {}
 
 void ApiWebServer::begin(WebServer &server) {
     _on(server, "/status", HTTP_GET, [this](AsyncWebServerRequest *request) {
         auto brightness = map16(_app.config().brightness, PWM_MAX_VALUE, 100);
-        response_with_json(request, JsonPropListT{
+        _respond_json(request, JsonPropListT{
             {"status", "ok"},
             {"value", _app.config().power},
             {"brightness", brightness}
@@ -17,28 +50,299 @@ void ApiWebServer::begin(WebServer &server) {
     });
 
     _on(server, "/power", HTTP_GET, [this](AsyncWebServerRequest *request) {
-        bool enabled = request->arg("value") == "1";
-        _app.set_power(enabled);
+        const auto &arg = request->arg("value");
+
+        bool enabled;
+        if (!parse_int<bool>(arg.c_str(), arg.length(), enabled)) {
+            _respond_status(request, "error");
+            return;
+        }
 
-        response_with_json_status(request, "ok");
+        _respond_submit(request, {CommandType::POWER, enabled});
     });
 
     _on(server, "/brightness", HTTP_GET, [this](AsyncWebServerRequest *request) {
-        auto new_brightness = map16(request->arg("value").toInt(), 100, PWM_MAX_VALUE);
+        const auto &arg = request->arg("value");
+
+        uint16_t percent;
+        if (!parse_int<uint16_t>(arg.c_str(), arg.length(), percent, 0, 100)) {
+            _respond_status(request, "error");
+            return;
+        }
+
+        _respond_submit(request, {CommandType::BRIGHTNESS, map16(percent, 100, PWM_MAX_VALUE)});
+    });
+
+    _on(server, "/preset", HTTP_GET, [this](AsyncWebServerRequest *request) {
+        const auto &arg = request->arg("value");
+
+        uint8_t index;
+        if (!parse_int<uint8_t>(arg.c_str(), arg.length(), index, 0, PRESET_COUNT - 1)) {
+            _respond_status(request, "error");
+            return;
+        }
+
+        _respond_submit(request, {CommandType::RECALL_PRESET, index});
+    });
+
+    _on(server, "/preset/save", HTTP_GET, [this](AsyncWebServerRequest *request) {
+        const auto &arg = request->arg("value");
+
+        uint8_t index;
+        if (!parse_int<uint8_t>(arg.c_str(), arg.length(), index, 0, PRESET_COUNT - 1)) {
+            _respond_status(request, "error");
+            return;
+        }
+
+        _respond_submit(request, {CommandType::SAVE_PRESET, index});
+    });
+
+    for (uint8_t id = 0; id < ZONE_COUNT; ++id) {
+        char uri[16];
+        snprintf(uri, sizeof(uri), "/zone/%u", id);
+
+        _on(server, uri, HTTP_GET, [this, id](AsyncWebServerRequest *request) { _handle_zone(request, id); });
+    }
+
+    _on(server, "/boot", HTTP_GET, [this](AsyncWebServerRequest *request) {
+        const auto &timings = _app.boot_timings();
+        _respond_json(request, JsonPropListT{
+            {"fs_mount", (long) timings.fs_mount},
+            {"config_load", (long) timings.config_load},
+            {"led_on", (long) timings.led_on},
+            {"wifi_connected", (long) timings.wifi_connected},
+            {"wifi_cache", (long) _app.wifi_cache().result()},
+            {"wifi_lease", (long) _app.wifi_cache().lease_used()},
+            {"wifi_up", (long) timings.wifi_up},
+            {"services_ready", (long) timings.services_ready},
+        });
+    });
+
+    _on(server, "/loop", HTTP_GET, [this](AsyncWebServerRequest *request) {
+        auto &stats = _app.loop_stats();
+        _respond_json(request, JsonPropListT{
+            {"count", (long) stats.count},
+            {"jitter_avg", (long) (stats.count > 0 ? stats.jitter_total / stats.count : 0)},
+            {"jitter_max", (long) stats.jitter_max},
+            {"timers", (long) _app.timers().size()},
+            {"timers_fired", (long) _app.timers().stats().fired},
+            {"timers_next", (long) std::min<unsigned long>(LONG_MAX, _app.timers().next_deadline(millis()))},
+            {"sleep", (long) stats.sleep_total},
+        });
+
+        if (request->hasArg("reset")) stats.reset();
+    });
+
+    _on(server, "/time", HTTP_GET, [this](AsyncWebServerRequest *request) {
+        const auto &ntp_time = _app.ntp_time();
+        const auto &stats = ntp_time.stats();
+        _respond_json(request, JsonPropListT{
+            {"synced", (long) ntp_time.available()},
+            {"epoch", (long) (ntp_time.available() ? ntp_time.epoch() : 0)},
+            {"age", (long) (ntp_time.available() ? ntp_time.sync_age() : 0)},
+            {"offset", (long) stats.offset},
+            {"delay", (long) stats.delay},
+            {"drift", (long) stats.drift},
+            {"syncs", (long) stats.syncs},
+            {"requests", (long) stats.requests},
+            {"timeouts", (long) stats.timeouts},
+            {"rejected", (long) stats.rejected},
+            {"lookups", (long) stats.lookups},
+        });
+    });
+
+    _on(server, "/memory", HTTP_GET, [this](AsyncWebServerRequest *request) {
+        const auto &stats = _app.memory_stats();
+
+        size_t size;
+        auto body = _body(request, size);
+
+        JsonWriter writer(body, size);
+        writer.begin_object();
+        writer.value("heap", ESP.getFreeHeap());
+        writer.value("heap_boot", stats.boot_free_heap);
+        writer.value("heap_min", stats.min_free_heap);
+        writer.value("slots", (unsigned) sizeof(_slots));
 
-        _app.config().brightness = new_brightness;
-        _app.load();
+        writer.begin_object("metadata");
+        writer.value("size", (unsigned) sizeof(ConfigParameters));
+        writer.value("flash", (unsigned) sizeof(PropertyDescriptorTable));
+        writer.value("heap_before", stats.metadata_heap_before);
+        writer.value("heap_after", stats.metadata_heap_after);
+        writer.value("heap_registered", stats.registered_heap_after);
+        writer.end_object();
 
-        response_with_json_status(request, "ok");
+        writer.begin_object("static");
+        for (const auto &item: _app.memory_budget()) writer.value(item.name, item.size);
+        writer.end_object();
+        writer.end_object();
+
+        _respond(request, 200, "application/json", writer.c_str(), writer.length());
+    });
+
+    _on(server, "/notifications", HTTP_GET, [this](AsyncWebServerRequest *request) {
+        const auto &arg = request->arg("cursor");
+
+        uint8_t cursor = 0;
+        if (arg.length() > 0 && !parse_int<uint8_t>(arg.c_str(), arg.length(), cursor)) {
+            _respond_status(request, "error");
+            return;
+        }
+
+        const auto &notifications = _app.notifications();
+        const auto &stats = notifications.stats();
+        const uint8_t end = std::min<uint8_t>(notifications.topic_count(), cursor + NOTIFICATION_HTTP_PAGE_SIZE);
+
+        size_t size;
+        auto body = _body(request, size);
+
+        JsonWriter writer(body, size);
+        writer.begin_object();
+        writer.value("status", "ok");
+        writer.value("cursor", (unsigned) std::max(cursor, end));
+        writer.value("count", (unsigned) notifications.topic_count());
+        writer.value("events", stats.events);
+        writer.value("delivered", stats.delivered);
+        writer.value("filtered", stats.filtered);
+        writer.value("unrouted", stats.unrouted);
+        writer.value("overflows", stats.overflows);
+
+        // [packet type, events, events per second]
+        writer.begin_array("topics");
+        for (uint8_t i = cursor; i < end; ++i) {
+            const auto &topic = notifications.topic(i);
+            writer.begin_array();
+            writer.item((unsigned) topic.key);
+            writer.item(topic.events);
+            writer.item((unsigned) topic.rate);
+            writer.end_array();
+        }
+        writer.end_array();
+        writer.end_object();
+
+        _respond(request, 200, "application/json", writer.c_str(), writer.length());
     });
 
-    _on(server, "/debug", HTTP_GET, [](AsyncWebServerRequest *request) {
-        char result[64] = {};
+    _on(server, "/feed", HTTP_GET, [this](AsyncWebServerRequest *request) {
+        const auto &feed = _app.feed().feed();
+        const auto stats = feed.stats();
+
+        size_t size;
+        auto body = _body(request, size);
+
+        JsonWriter writer(body, size);
+        writer.begin_object();
+        writer.value("entries", (unsigned) feed.entry_count());
+        writer.value("changes", stats.changes);
+        writer.value("coalesced", stats.coalesced);
+        writer.value("skipped", stats.skipped);
+        writer.value("rejected", stats.rejected);
+        writer.value("event_overflows", _app.feed().event_overflows());
+
+        // [client id, bytes, frames, values, refused]
+        writer.begin_array("clients");
+        for (uint8_t i = 0; i < WS_FEED_CLIENT_COUNT; ++i) {
+            const auto client = feed.client(i);
+            if (!client) continue;
+
+            writer.begin_array();
+            writer.item(client->id);
+            writer.item(client->bytes);
+            writer.item(client->frames);
+            writer.item(client->values);
+            writer.item(client->refused);
+            writer.end_array();
+        }
+        writer.end_array();
+        writer.end_object();
+
+        _respond(request, 200, "application/json", writer.c_str(), writer.length());
+    });
+
+    _on(server, "/history", HTTP_GET, [this](AsyncWebServerRequest *request) {
+        const auto &arg = request->arg("cursor");
+
+        uint32_t cursor = 0;
+        if (arg.length() > 0 && !parse_int<uint32_t>(arg.c_str(), arg.length(), cursor)) {
+            _respond_status(request, "error");
+            return;
+        }
+
+        size_t size;
+        auto body = _body(request, size);
 
-        snprintf(result, sizeof(result), "General:\nHeap: %u\nNow: %lu\n",
+        const int length = write_history_json(_app.history(), cursor, millis(), body, size);
+        if (length == 0) {
+            _respond_status(request, "busy");
+        } else if (length < 0) {
+            // Not even an empty page fits the slot
+            request->send_P(500, "application/json", TOO_LARGE_RESPONSE);
+        } else {
+            _respond(request, 200, "application/json", body, length);
+        }
+    });
+
+    _on(server, "/debug", HTTP_GET, [this](AsyncWebServerRequest *request) {
+        size_t size;
+        auto result = _body(request, size);
+        size_t length = 0;
+
+        _append(result, size, length, "General:\nHeap: %u\nNow: %lu\n",
             ESP.getFreeHeap(), millis());
 
-        request->send_P(200, "text/plain", result);
+#ifdef ARDUINO_ARCH_ESP8266
+        _append(result, size, length, "\nMemory:\nMax Block: %u\nFragmentation: %u%%\n",
+            ESP.getMaxFreeBlockSize(), ESP.getHeapFragmentation());
+#else
+        _append(result, size, length, "\nMemory:\nMax Block: %u\n",
+            ESP.getMaxAllocHeap());
+#endif
+
+        _append(result, size, length, "Parameters: %u\nStatic: %u\nMin Heap: %u\n",
+            (unsigned) sizeof(ConfigParameters), (unsigned) sizeof(Application), _app.memory_stats().min_free_heap);
+
+        const auto &commands = _app.commands();
+        _append(result, size, length, "\nCommands:\nDepth: %u/%u\nMax Depth: %u\nOverflow: %u\n",
+            (unsigned) commands.size(), (unsigned) commands.capacity(), commands.max_depth(), commands.overflow_count());
+
+        // Requested against performed, the rest was coalesced into one commit per batch
+        const auto &changes = _app.change_stats();
+        _append(result, size, length,
+            "\nChanges:\nCommits: %u\nLoads: %u/%u\nSaves: %u/%u\nNotifications: %u/%u\n",
+            changes.commits, changes.loads, changes.load_requests, changes.saves, changes.save_requests,
+            changes.notifications, changes.notify_requests);
+
+        const auto &admission = _admission.stats();
+        _append(result, size, length,
+            "\nHTTP:\nIn Flight: %u\nMax In Flight: %u\nAccepted: %u\nRate Limited: %u\nShed (in flight): %u\nShed (heap): %u\n",
+            admission.in_flight, admission.max_in_flight, admission.accepted, admission.rate_limited,
+            admission.shed_in_flight, admission.shed_heap);
+
+        const auto &ntp_time = _app.ntp_time();
+        _append(result, size, length, "\nTime:\nSynced: %u\nAge: %lu\nOffset: %ld\nDelay: %lu\nDrift: %ld\n",
+            ntp_time.available(), ntp_time.available() ? ntp_time.sync_age() : 0ul,
+            (long) ntp_time.stats().offset, (unsigned long) ntp_time.stats().delay, (long) ntp_time.stats().drift);
+
+        _respond(request, 200, "text/plain", result, strlen(result));
+    });
+
+    _on(server, "/update", HTTP_GET, [this](AsyncWebServerRequest *request) {
+        _respond_json(request, JsonPropListT{
+            {"status", _update_error ? _update_error : "ok"},
+            {"time", (long) _update_stats.duration},
+            {"received", (long) _update_stats.received},
+            {"written", (long) _update_stats.written},
+            {"ram", (long) _update_stats.ram_peak},
+        });
+    });
+
+    _on(server, "/update", HTTP_POST, [this](AsyncWebServerRequest *request) {
+        // Admitted with its first chunk. A rejected upload, or a request without a file, is answered here
+        if (!_admitted(request) && !_admit(request)) return;
+
+        _handle_update_result(request);
+    }, [this](AsyncWebServerRequest *request, const String &filename, size_t index, uint8_t *data, size_t length, bool final) {
+        _handle_update_upload(request, filename, index, data, length, final);
     });
 
     _on(server, "/restart", HTTP_GET, [this](AsyncWebServerRequest *request) {
@@ -48,6 +352,271 @@ void ApiWebServer::begin(WebServer &server) {
     });
 }
 
+void ApiWebServer::_handle_update_upload(AsyncWebServerRequest *request, const String &filename, size_t index,
+                                         uint8_t *data, size_t length, bool final) {
+    if (index == 0) {
+        // Counted in flight for the whole transfer. A rejected one is skipped and answered when it ends
+        if (_take_slot(request) != Admission::ACCEPT) return;
+
+        // The request has a single disconnect handler, it releases the slot and the update
+        request->onDisconnect([this, request] {
+            if (_update_request == request) _release_update();
+            _release(request);
+        });
+
+        if (_update_request != nullptr) return;
+
+        const auto &encoding_arg = request->hasArg("encoding") ? request->arg("encoding") : filename;
+
+        FirmwareEncoding encoding = FirmwareEncoding::RAW;
+        if (encoding_arg == "heatshrink" || encoding_arg.endsWith(".hs")) {
+            encoding = FirmwareEncoding::HEATSHRINK;
+        } else if (encoding_arg == "gzip" || encoding_arg.endsWith(".gz")) {
+            encoding = FirmwareEncoding::GZIP;
+        }
+
+        _update_request = request;
+        _update = std::make_unique<FirmwareUpdater>();
+        if (!_update->begin(encoding, request->arg("sha256").c_str())) return;
+    }
+
+    if (_update_request != request || !_update->running()) return;
+
+    if (length > 0) _update->write(data, length);
+    if (final && _update->running()) _update->end();
+}
+
+void ApiWebServer::_handle_update_result(AsyncWebServerRequest *request) {
+    if (_update_request != request) {
+        _respond_status(request, _update_request ? "busy" : "error");
+        return;
+    }
+
+    _update_stats = _update->stats();
+    _update_error = _update->error();
+    _release_update();
+
+    if (_update_error) {
+        _respond_status(request, _update_error);
+        return;
+    }
+
+    _respond_json(request, JsonPropListT{
+        {"status", "ok"},
+        {"time", (long) _update_stats.duration},
+        {"received", (long) _update_stats.received},
+        {"written", (long) _update_stats.written},
+        {"ram", (long) _update_stats.ram_peak},
+    });
+
+    _app.restart();
+}
+
+void ApiWebServer::_release_update() {
+    if (_update) _update->abort();
+
+    _update = nullptr;
+    _update_request = nullptr;
+}
+
+void ApiWebServer::_handle_zone(AsyncWebServerRequest *request, uint8_t id) {
+    struct ZoneArgument {
+        const char *name;
+        CommandType type;
+        uint32_t max;
+    };
+
+    static constexpr ZoneArgument ARGUMENTS[] = {
+        {"power", CommandType::POWER, 1},
+        {"brightness", CommandType::BRIGHTNESS, 100},
+        {"color", CommandType::COLOR, 0xffffff},
+        {"temperature", CommandType::TEMPERATURE, UINT16_MAX},
+    };
+
+    const auto &sys_config = _app.sys_config();
+    const auto *zone = _app.zone(id);
+    if (id > 0 && !zone) {
+        // Disabled, or not started because of its pins
+        _respond_json(request, JsonPropListT{
+            {"status", "error"},
+            {"zone", (long) id},
+            {"pins", (long) _app.zone_pins(id)},
+        });
+        return;
+    }
+
+    const auto temperature_range = sys_config.led_max_temperature - sys_config.led_min_temperature;
+
+    Command commands[std::size(ARGUMENTS)];
+    size_t count = 0;
+    for (const auto &argument : ARGUMENTS) {
+        if (!request->hasArg(argument.name)) continue;
+
+        const auto &arg = request->arg(argument.name);
+
+        uint32_t value;
+        if (!parse_int<uint32_t>(arg.c_str(), arg.length(), value, 0, argument.max)) {
+            _respond_status(request, "error");
+            return;
+        }
+
+        if (argument.type == CommandType::BRIGHTNESS) {
+            value = map16(value, 100, PWM_MAX_VALUE);
+        } else if (argument.type == CommandType::TEMPERATURE) {
+            value = std::max<uint32_t>(sys_config.led_min_temperature, std::min<uint32_t>(sys_config.led_max_temperature, value));
+            value = map16(value - sys_config.led_min_temperature, temperature_range, LED_TEMPERATURE_MAX_VALUE);
+        }
+
+        commands[count++] = {argument.type, value, id};
+    }
+
+    if (count > 0) {
+        bool accepted = true;
+        for (size_t i = 0; i < count; ++i) accepted &= _app.submit(commands[i]);
+
+        _respond_status(request, accepted ? "ok" : "busy");
+        return;
+    }
+
+    const auto &config = _app.config();
+    const bool power = zone ? zone->state().power : config.power;
+    const uint16_t brightness = zone ? zone->state().brightness : config.brightness;
+    const uint32_t color = zone ? zone->state().color : config.color & 0xffffff;
+    const uint16_t temperature = zone ? zone->state().color_temperature : config.color_temperature;
+
+    _respond_json(request, JsonPropListT{
+        {"status", "ok"},
+        {"zone", (long) id},
+        {"pins", (long) _app.zone_pins(id)},
+        {"power", power},
+        {"brightness", (long) map16(brightness, PWM_MAX_VALUE, 100)},
+        {"color", (long) color},
+        {"temperature", (long) (sys_config.led_min_temperature + (uint32_t) temperature * temperature_range / LED_TEMPERATURE_MAX_VALUE)},
+    });
+}
+
+void ApiWebServer::_respond_submit(AsyncWebServerRequest *request, const Command &command) {
+    _respond_status(request, _app.submit(command) ? "ok" : "busy");
+}
+
+void ApiWebServer::_respond(AsyncWebServerRequest *request, int code, const char *content_type,
+                            const char *body, size_t length) {
+    // The body stays in the request slot until the client disconnects, so the response only points to it
+    request->send(request->beginResponse_P(code, content_type, (const uint8_t *) body, length));
+}
+
+void ApiWebServer::_respond_json(AsyncWebServerRequest *request, JsonPropListT props) {
+    size_t size;
+    auto body = _body(request, size);
+
+    JsonWriter writer(body, size);
+    writer.begin_object();
+    write_json(writer, props);
+    writer.end_object();
+
+    _respond(request, 200, "application/json", writer.c_str(), writer.length());
+}
+
+void ApiWebServer::_respond_status(AsyncWebServerRequest *request, const char *status) {
+    _respond_json(request, JsonPropListT{{"status", status}});
+}
+
+char *ApiWebServer::_body(AsyncWebServerRequest *request, size_t &size) {
+    for (auto &slot: _slots) {
+        if (slot.request != request) continue;
+
+        size = sizeof(slot.body);
+        return slot.body;
+    }
+
+    // Every responder is admitted first
+    static char empty[1];
+    size = sizeof(empty);
+    return empty;
+}
+
+bool ApiWebServer::_admitted(AsyncWebServerRequest *request) const {
+    for (const auto &slot: _slots) {
+        if (slot.request == request) return true;
+    }
+
+    return false;
+}
+
+bool ApiWebServer::_admit(AsyncWebServerRequest *request) {
+    switch (_take_slot(request)) {
+        case Admission::ACCEPT:
+            request->onDisconnect([this, request] { _release(request); });
+            return true;
+
+        case Admission::RATE_LIMITED: {
+            auto *response = request->beginResponse_P(429, "application/json",
+                (const uint8_t *) RATE_LIMITED_RESPONSE, sizeof(RATE_LIMITED_RESPONSE) - 1);
+            response->addHeader("Retry-After", "1");
+            request->send(response);
+            return false;
+        }
+
+        case Admission::OVERLOADED:
+            request->send_P(503, "application/json", OVERLOADED_RESPONSE);
+            return false;
+    }
+
+    return false;
+}
+
+Admission ApiWebServer::_take_slot(AsyncWebServerRequest *request) {
+    const uint32_t client = request->client()->remoteIP();
+    auto admission = _admission.admit(client, ESP.getFreeHeap());
+
+    // There is a slot per admitted request, the lookup fails only if the two limits ever diverge
+    ApiRequestSlot *slot = nullptr;
+    if (admission == Admission::ACCEPT) {
+        for (auto &item: _slots) {
+            if (item.request == nullptr) {
+                slot = &item;
+                break;
+            }
+        }
+
+        if (!slot) {
+            _admission.release(client);
+            admission = Admission::OVERLOADED;
+        }
+    }
+
+    if (admission == Admission::ACCEPT) {
+        slot->request = request;
+        slot->client = client;
+        slot->body[0] = '\0';
+    }
+
+    return admission;
+}
+
+void ApiWebServer::_release(AsyncWebServerRequest *request) {
+    for (auto &slot: _slots) {
+        if (slot.request != request) continue;
+
+        _admission.release(slot.client);
+        slot.request = nullptr;
+        return;
+    }
+}
+
 void ApiWebServer::_on(WebServer &server, const char *uri, WebRequestMethodComposite method, const ArRequestHandlerFunction &onRequest) {
-    server.on((_path + uri).c_str(), method, onRequest);
+    char path[64];
+    snprintf(path, sizeof(path), "%s%s", _path, uri);
+
+    server.on(path, method, [this, onRequest](AsyncWebServerRequest *request) {
+        if (_admit(request)) onRequest(request);
+    });
+}
+
+void ApiWebServer::_on(WebServer &server, const char *uri, WebRequestMethodComposite method, const ArRequestHandlerFunction &onRequest,
+                       const ArUploadHandlerFunction &onUpload) {
+    char path[64];
+    snprintf(path, sizeof(path), "%s%s", _path, uri);
+
+    server.on(path, method, onRequest, onUpload);
 }
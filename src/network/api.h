@@ -2,19 +2,58 @@
 
 #include "lib/network/web.h"
 
+#include "admission.h"
+#include "ota.h"
 #include "utils/network.h"
 
 class Application;
+struct Command;
+
+// Every admitted request owns a slot until it disconnects, its response is sent from the slot buffer
+struct ApiRequestSlot {
+    AsyncWebServerRequest *request = nullptr;
+    uint32_t client = 0;
+    char body[API_RESPONSE_SIZE];
+};
 
 class ApiWebServer {
     Application &_app;
-    String _path;
+    const char *_path;
+
+    AdmissionControl _admission{};
+    ApiRequestSlot _slots[ADMISSION_MAX_IN_FLIGHT]{};
+
+    std::unique_ptr<FirmwareUpdater> _update = nullptr;
+    AsyncWebServerRequest *_update_request = nullptr;
+    FirmwareUpdateStats _update_stats{};
+    const char *_update_error = nullptr;
 
 public:
     ApiWebServer(Application &application, const char *path = "/api");
 
     void begin(WebServer &server);
 
+    [[nodiscard]] inline const AdmissionStats &admission_stats() const { return _admission.stats(); }
+
 protected:
+    // Takes a slot or answers 429 / 503, the slot is released on disconnect
+    bool _admit(AsyncWebServerRequest *request);
+    Admission _take_slot(AsyncWebServerRequest *request);
+    [[nodiscard]] bool _admitted(AsyncWebServerRequest *request) const;
+    void _release(AsyncWebServerRequest *request);
+    char *_body(AsyncWebServerRequest *request, size_t &size);
+
+    void _respond(AsyncWebServerRequest *request, int code, const char *content_type, const char *body, size_t length);
+    void _respond_json(AsyncWebServerRequest *request, JsonPropListT props);
+    void _respond_status(AsyncWebServerRequest *request, const char *status);
+    void _respond_submit(AsyncWebServerRequest *request, const Command &command);
+    void _handle_zone(AsyncWebServerRequest *request, uint8_t id);
     void _on(WebServer &server, const char *uri, WebRequestMethodComposite method, const ArRequestHandlerFunction &onRequest);
+    void _on(WebServer &server, const char *uri, WebRequestMethodComposite method, const ArRequestHandlerFunction &onRequest,
+             const ArUploadHandlerFunction &onUpload);
+
+    void _handle_update_upload(AsyncWebServerRequest *request, const String &filename, size_t index,
+                               uint8_t *data, size_t length, bool final);
+    void _handle_update_result(AsyncWebServerRequest *request);
+    void _release_update();
 };
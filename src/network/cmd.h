@@ -11,6 +11,8 @@ MAKE_ENUM(PacketType, uint8_t,
     COLOR, 0x10,
     CALIBRATION, 0x11,
     TEMPERATURE, 0x12,
+    COLOR_16, 0x13,
+    CALIBRATION_16, 0x14,
 
     NIGHT_MODE_ENABLED, 0x20,
     NIGHT_MODE_START, 0x21,
@@ -18,6 +20,15 @@ MAKE_ENUM(PacketType, uint8_t,
     NIGHT_MODE_INTERVAL, 0x23,
     NIGHT_MODE_BRIGHTNESS, 0x24,
 
+    PRESET, 0x30,
+    PRESET_LIST, 0x31,
+
+    HISTORY, 0x41,
+
+    // Zone number goes into the low bits: ZONE_STATE + 1 is zone 1
+    ZONE_STATE, 0x50,
+    ZONE_CONFIG, 0x58,
+
     SYS_CONFIG_MDNS_NAME, 0x60,
 
     SYS_CONFIG_WIFI_MODE, 0x61,
@@ -50,11 +61,23 @@ MAKE_ENUM(PacketType, uint8_t,
     SYS_CONFIG_LED_MIN_BRIGHTNESS, 0x76,
     SYS_CONFIG_LED_MIN_TEMPERATURE, 0x77,
     SYS_CONFIG_LED_MAX_TEMPERATURE, 0x78,
+    SYS_CONFIG_LED_PWM_PROFILE, 0x79,
+
+    SYS_CONFIG_WIFI_STATIC_IP, 0x7A,
+    SYS_CONFIG_WIFI_GATEWAY, 0x7B,
+    SYS_CONFIG_WIFI_SUBNET, 0x7C,
+    SYS_CONFIG_WIFI_DNS, 0x7D,
 
     SYS_CONFIG_BUTTON_ENABLED, 0x80,
     SYS_CONFIG_BUTTON_PIN, 0x81,
     SYS_CONFIG_BUTTON_HIGH_STATE, 0x82,
 
+    BUTTON_ACTION_CLICK_1, 0x83,
+    BUTTON_ACTION_CLICK_2, 0x84,
+    BUTTON_ACTION_CLICK_3, 0x85,
+    BUTTON_ACTION_HOLD_1, 0x86,
+    BUTTON_ACTION_HOLD_2, 0x87,
+
     GET_CONFIG, 0xa0,
     RESTART, 0xb0,
 )
@@ -0,0 +1,44 @@
+#include "history_json.h"
+
+#include "utils/json.h"
+
+size_t write_history_page_json(char *buffer, size_t size, uint32_t next_cursor, uint32_t first, unsigned long now,
+                               const HistoryEvent *events, size_t count) {
+    JsonWriter writer(buffer, size);
+    writer.begin_object();
+    writer.value("status", "ok");
+    writer.value("cursor", next_cursor);
+    writer.value("first", first);
+    writer.value("now", now);
+
+    writer.begin_array("events");
+    for (size_t i = 0; i < count; ++i) {
+        writer.begin_array();
+        writer.item(events[i].seq);
+        writer.item(events[i].time);
+        writer.item((uint8_t) events[i].type);
+        writer.item(events[i].value);
+        writer.end_array();
+    }
+    writer.end_array();
+    writer.end_object();
+
+    return writer.ok() ? writer.length() : 0;
+}
+
+int write_history_json(const HistoryBuffer &history, uint32_t cursor, unsigned long now, char *buffer, size_t size) {
+    HistoryEvent events[HISTORY_HTTP_PAGE_SIZE];
+    size_t count;
+    uint32_t next_cursor;
+    if (!history.read(cursor, events, HISTORY_HTTP_PAGE_SIZE, count, next_cursor)) return 0;
+
+    for (;;) {
+        const size_t length = write_history_page_json(buffer, size, next_cursor, history.first_seq(), now, events, count);
+        if (length > 0) return (int) length;
+        if (count == 0) return -1;
+
+        // The rest is read with the next cursor
+        count /= 2;
+        next_cursor = events[count].seq;
+    }
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "misc/history.h"
+
+// Page of /api/history as JSON, written into a caller-owned buffer:
+//   {"status": "ok", "cursor": next, "first": seq, "now": ms, "events": [[seq, time, type, value], ...]}
+// Returns the length, 0 if it doesn't fit
+size_t write_history_page_json(char *buffer, size_t size, uint32_t next_cursor, uint32_t first, unsigned long now,
+                               const HistoryEvent *events, size_t count);
+
+// Reads a page from `cursor`. A page that doesn't fit is cut to fewer events, its cursor points past the last one.
+// Returns the length, 0 if the history is being written (busy) and -1 if not even an empty page fits
+int write_history_json(const HistoryBuffer &history, uint32_t cursor, unsigned long now, char *buffer, size_t size);
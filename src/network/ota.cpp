@@ -0,0 +1,141 @@
+#include "ota.h"
+
+#include <Arduino.h>
+
+#ifdef ARDUINO_ARCH_ESP8266
+#include <Updater.h>
+#else
+#include <Update.h>
+#endif
+
+#include "lib/debug.h"
+
+bool FirmwareUpdater::begin(FirmwareEncoding encoding, const char *sha256_hex) {
+    _stats = {};
+    _error = nullptr;
+
+    if (sha256_hex == nullptr || strlen(sha256_hex) != Sha256::HEX_SIZE) {
+        _fail("sha256 required");
+        return false;
+    }
+
+#ifndef ARDUINO_ARCH_ESP8266
+    // Only the ESP8266 bootloader is able to unpack gzip images, the build writes a heatshrink one for ESP32
+    if (encoding == FirmwareEncoding::GZIP) {
+        _fail("gzip unsupported, use firmware.bin.hs");
+        return false;
+    }
+#endif
+
+    _encoding = encoding;
+    strncpy(_expected_digest, sha256_hex, Sha256::HEX_SIZE);
+    _expected_digest[Sha256::HEX_SIZE] = '\0';
+
+    _sha256.reset();
+    _decoder.reset();
+
+#ifdef ARDUINO_ARCH_ESP8266
+    Update.runAsync(true);
+    const bool started = Update.begin((ESP.getFreeSketchSpace() - 0x1000) & 0xFFFFF000, U_FLASH);
+#else
+    const bool started = Update.begin(UPDATE_SIZE_UNKNOWN, U_FLASH);
+#endif
+
+    if (!started) {
+        _fail("begin failed");
+        return false;
+    }
+
+    _start_time = millis();
+    _start_free_heap = _min_free_heap = ESP.getFreeHeap();
+    _running = true;
+
+    D_PRINTF("OTA: Started, encoding: %s\r\n", __debug_enum_str(encoding));
+    return true;
+}
+
+bool FirmwareUpdater::write(const uint8_t *data, size_t length) {
+    if (!_running) return false;
+
+    _stats.received += length;
+    _sha256.update(data, length);
+
+    bool result;
+    if (_encoding == FirmwareEncoding::HEATSHRINK) {
+        result = _decoder.feed(data, length, [this](auto chunk, auto chunk_length) {
+            return _write_image(chunk, chunk_length);
+        });
+    } else {
+        result = _write_image(data, length);
+    }
+
+    _min_free_heap = std::min(_min_free_heap, ESP.getFreeHeap());
+    _stats.duration = millis() - _start_time;
+
+    if (!result) _fail("write failed");
+    return result;
+}
+
+bool FirmwareUpdater::end() {
+    if (!_running) return false;
+
+    if (_encoding == FirmwareEncoding::HEATSHRINK && !_decoder.finish([this](auto chunk, auto chunk_length) {
+        return _write_image(chunk, chunk_length);
+    })) {
+        _fail("write failed");
+        return false;
+    }
+
+    _stats.duration = millis() - _start_time;
+    _stats.ram_peak = sizeof(FirmwareUpdater) + (_start_free_heap - _min_free_heap);
+
+    uint8_t digest[Sha256::DIGEST_SIZE];
+    _sha256.finish(digest);
+
+    if (!Sha256::equals_hex(digest, _expected_digest, strlen(_expected_digest))) {
+        _fail("sha256 mismatch");
+        return false;
+    }
+
+    if (!Update.end(true)) {
+        _fail("end failed");
+        return false;
+    }
+
+    _running = false;
+
+    D_PRINTF("OTA: Finished, %u -> %u bytes in %lu ms, RAM: %u\r\n",
+        _stats.received, _stats.written, _stats.duration, _stats.ram_peak);
+
+    return true;
+}
+
+void FirmwareUpdater::abort() {
+    if (!_running) return;
+
+    _running = false;
+
+#ifdef ARDUINO_ARCH_ESP8266
+    // Image is never complete at this point, so end() only drops the update
+    Update.end(false);
+#else
+    Update.abort();
+#endif
+
+    D_PRINT("OTA: Aborted");
+}
+
+bool FirmwareUpdater::_write_image(const uint8_t *data, size_t length) {
+    if (Update.write((uint8_t *) data, length) != length) return false;
+
+    _stats.written += length;
+
+    return true;
+}
+
+void FirmwareUpdater::_fail(const char *error) {
+    _error = error;
+    D_PRINTF("OTA: Error: %s\r\n", error);
+
+    abort();
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+
+#include "lib/utils/enum.h"
+
+#include "sys_constants.h"
+#include "utils/heatshrink.h"
+#include "utils/sha256.h"
+
+MAKE_ENUM_AUTO(FirmwareEncoding, uint8_t,
+    RAW,
+    HEATSHRINK,
+    GZIP
+);
+
+struct FirmwareUpdateStats {
+    unsigned long duration = 0;     // ms, from the first to the last received chunk
+    uint32_t received = 0;          // bytes received
+    uint32_t written = 0;           // bytes written to the OTA partition
+    uint32_t ram_peak = 0;          // bytes, updater state plus the heap drop during transfer
+};
+
+// Streams an uploaded image into the OTA partition, decompressing it on the fly.
+// SHA-256 is computed over the uploaded bytes, whatever the encoding, and checked before the new image is activated
+class FirmwareUpdater {
+    typedef HeatshrinkDecoder<OTA_HEATSHRINK_WINDOW_BITS, OTA_HEATSHRINK_LOOKAHEAD_BITS> Decoder;
+
+    FirmwareEncoding _encoding = FirmwareEncoding::RAW;
+    char _expected_digest[Sha256::HEX_SIZE + 1]{};
+
+    Sha256 _sha256{};
+    Decoder _decoder{};
+
+    unsigned long _start_time = 0;
+    uint32_t _start_free_heap = 0;
+    uint32_t _min_free_heap = 0;
+
+    FirmwareUpdateStats _stats{};
+    const char *_error = nullptr;
+    bool _running = false;
+
+public:
+    bool begin(FirmwareEncoding encoding, const char *sha256_hex);
+    bool write(const uint8_t *data, size_t length);
+    bool end();
+    void abort();
+
+    [[nodiscard]] inline bool running() const { return _running; }
+    [[nodiscard]] inline const char *error() const { return _error; }
+    [[nodiscard]] inline const FirmwareUpdateStats &stats() const { return _stats; }
+
+private:
+    bool _write_image(const uint8_t *data, size_t length);
+    void _fail(const char *error);
+};
@@ -0,0 +1,232 @@
+#include "sntp.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+#include <Arduino.h>
+
+#include "lib/debug.h"
+
+static constexpr size_t SNTP_PACKET_SIZE = 48;
+static constexpr uint32_t SNTP_UNIX_OFFSET = 2208988800ul;    // 1900-01-01 to 1970-01-01, seconds
+
+static uint32_t _read_u32(const uint8_t *data) {
+    return (uint32_t) data[0] << 24 | (uint32_t) data[1] << 16 | (uint32_t) data[2] << 8 | data[3];
+}
+
+static void _write_u32(uint8_t *data, uint32_t value) {
+    data[0] = value >> 24;
+    data[1] = value >> 16;
+    data[2] = value >> 8;
+    data[3] = value;
+}
+
+// NTP timestamp to unix ms. Seconds with the high bit cleared belong to the era starting in 2036
+static int64_t _timestamp_to_ms(const uint8_t *data) {
+    const uint32_t seconds = _read_u32(data);
+    const uint32_t fraction = _read_u32(data + 4);
+
+    const int64_t unix_seconds = (int64_t) seconds + (seconds & 0x80000000ul ? 0 : 0x100000000ll) - SNTP_UNIX_OFFSET;
+    return unix_seconds * 1000 + (((uint64_t) fraction * 1000) >> 32);
+}
+
+SntpClient::SntpClient(const char *server) : _server(server) {}
+
+void SntpClient::begin(float time_zone) {
+    set_time_zone(time_zone);
+
+    _udp.begin(SNTP_LOCAL_PORT);
+    _next_request = millis();
+}
+
+void SntpClient::set_time_zone(float time_zone) {
+    _time_zone_ms = (int32_t) (time_zone * 3600) * 1000;
+}
+
+void SntpClient::update() {
+    const auto now = millis();
+
+    if (_state == State::WAITING) {
+        // Rejected datagrams are skipped in the same call, so they don't delay the matching reply
+        while (_state == State::WAITING && _udp.parsePacket() > 0) _handle_reply();
+
+        if (_state == State::WAITING && (uint32_t) (now - _request_time) >= SNTP_TIMEOUT) {
+            ++_stats.timeouts;
+
+            // The pool may have moved the server, look it up again before the next request
+            _resolve_state.store(ResolveState::NONE, std::memory_order_relaxed);
+            _finish_sample();
+        }
+    } else if ((int32_t) (now - _next_request) >= 0 && _resolve()) {
+        _send_request();
+    }
+}
+
+bool SntpClient::_resolve() {
+    switch (_resolve_state.load(std::memory_order_acquire)) {
+        case ResolveState::RESOLVED:
+            return true;
+
+        case ResolveState::RESOLVING:
+            return false;
+
+        case ResolveState::FAILED:
+            _resolve_state.store(ResolveState::NONE, std::memory_order_relaxed);
+            _next_request = millis() + SNTP_RETRY_INTERVAL;
+            return false;
+
+        case ResolveState::NONE:
+            break;
+    }
+
+    ++_stats.lookups;
+
+    // Set first, the callback may run before dns_gethostbyname() returns
+    _resolve_state.store(ResolveState::RESOLVING, std::memory_order_relaxed);
+
+    // Answered from the lwIP cache or later from the callback, never waits for the network
+    ip_addr_t address;
+    const err_t result = dns_gethostbyname(_server, &address, _dns_found, this);
+
+    if (result == ERR_OK) {
+        _server_ip = IPAddress(ip4_addr_get_u32(ip_2_ip4(&address)));
+        _resolve_state.store(ResolveState::RESOLVED, std::memory_order_release);
+        return true;
+    }
+
+    if (result != ERR_INPROGRESS) _resolve_state.store(ResolveState::FAILED, std::memory_order_release);
+    return false;
+}
+
+void SntpClient::_dns_found(const char *, const ip_addr_t *address, void *arg) {
+    auto &self = *(SntpClient *) arg;
+    if (!address) {
+        D_PRINT("SNTP: Unable to resolve the server");
+        self._resolve_state.store(ResolveState::FAILED, std::memory_order_release);
+        return;
+    }
+
+    self._server_ip = IPAddress(ip4_addr_get_u32(ip_2_ip4(address)));
+    self._resolve_state.store(ResolveState::RESOLVED, std::memory_order_release);
+}
+
+uint64_t SntpClient::epoch_ms() const {
+    return _predicted_epoch(millis());
+}
+
+void SntpClient::_send_request() {
+    uint8_t packet[SNTP_PACKET_SIZE]{};
+    packet[0] = 0b00100011;     // LI 0, version 4, mode 3 (client)
+
+    // The server echoes the transmit timestamp back as the originate one, use it to match the reply.
+    // Not a real timestamp, so the request reveals nothing about the local clock
+    _cookie = _cookie * 1103515245u + 12345u + millis();
+    _write_u32(packet + 40, _cookie);
+    _write_u32(packet + 44, ~_cookie);
+
+    _request_time = millis();
+    _state = State::WAITING;
+    ++_stats.requests;
+
+    if (!_udp.beginPacket(_server_ip, SNTP_PORT)) {
+        _resolve_state.store(ResolveState::NONE, std::memory_order_relaxed);
+        _finish_sample();
+        return;
+    }
+
+    _udp.write(packet, sizeof(packet));
+    _udp.endPacket();
+}
+
+void SntpClient::_handle_reply() {
+    const auto receive_time = millis();
+
+    // Rest of the datagram, if any, is discarded by the next parsePacket()
+    uint8_t packet[SNTP_PACKET_SIZE]{};
+    const auto length = _udp.read(packet, sizeof(packet));
+
+    const uint8_t leap = packet[0] >> 6;
+    const uint8_t mode = packet[0] & 0x07;
+    const uint8_t stratum = packet[1];
+
+    if (length < (int) SNTP_PACKET_SIZE || mode != 4 || leap == 3 || stratum == 0 || stratum > 15
+        || _read_u32(packet + 24) != _cookie || _read_u32(packet + 28) != ~_cookie) {
+        ++_stats.rejected;
+        return;     // Keep waiting, the matching reply may still come
+    }
+
+    ++_stats.replies;
+
+    const int64_t server_receive = _timestamp_to_ms(packet + 32);
+    const int64_t server_transmit = _timestamp_to_ms(packet + 40);
+
+    const uint32_t round_trip = receive_time - _request_time;
+    const int64_t server_time = server_transmit - server_receive;
+    const uint32_t delay = (uint32_t) std::max<int64_t>(0, (int64_t) round_trip - server_time);
+
+    // Epoch at the time of the reply, the request and the reply are assumed to take equal time
+    const int64_t epoch = (server_receive + server_transmit + round_trip) / 2;
+
+    if (!_sample_found || delay < _sample_delay) {
+        _sample_found = true;
+        _sample_epoch = epoch;
+        _sample_time = receive_time;
+        _sample_delay = delay;
+    }
+
+    _finish_sample();
+}
+
+void SntpClient::_finish_sample() {
+    _state = State::IDLE;
+
+    if (++_sample_index < SNTP_SAMPLE_COUNT) {
+        _next_request = millis() + SNTP_SAMPLE_INTERVAL;
+        return;
+    }
+
+    _sample_index = 0;
+    if (_sample_found) {
+        _apply_sync();
+        _next_request = millis() + NTP_UPDATE_INTERVAL;
+    } else {
+        _next_request = millis() + SNTP_RETRY_INTERVAL;
+    }
+
+    _sample_found = false;
+}
+
+void SntpClient::_apply_sync() {
+    if (_synced) {
+        _stats.offset = (int32_t) (_sample_epoch - _predicted_epoch(_sample_time));
+
+        // Too short interval makes the estimate dominated by the sample error
+        const uint32_t interval = _sample_time - _sync_time;
+        if (interval >= SNTP_DRIFT_MIN_INTERVAL) {
+            const int64_t deviation = _sample_epoch - _sync_epoch - interval;
+            const auto drift = (int32_t) (deviation * 1000000000ll / interval);
+
+            if (abs(drift) <= SNTP_MAX_DRIFT_PPB) {
+                _drift_ppb = _has_drift ? (_drift_ppb + 3 * drift) / 4 : drift;
+                _has_drift = true;
+            }
+        }
+    }
+
+    _synced = true;
+    _sync_epoch = _sample_epoch;
+    _sync_time = _sample_time;
+
+    ++_stats.syncs;
+    _stats.delay = _sample_delay;
+    _stats.drift = _drift_ppb;
+
+    D_PRINTF("SNTP: synced, offset correction %ld ms, delay %lu ms, drift %ld ppb\r\n",
+        (long) _stats.offset, (unsigned long) _stats.delay, (long) _stats.drift);
+}
+
+int64_t SntpClient::_predicted_epoch(unsigned long time) const {
+    // Stays correct across the millis() wraparound, every ~49.7 days
+    const auto elapsed = (int64_t) (uint32_t) (time - _sync_time);
+    return _sync_epoch + elapsed + elapsed * _drift_ppb / 1000000000ll;
+}
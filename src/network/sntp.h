@@ -0,0 +1,98 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#include <Arduino.h>
+#include <WiFiUdp.h>
+#include <lwip/dns.h>
+
+#include "constants.h"
+
+struct SntpStats {
+    uint32_t requests = 0;
+    uint32_t replies = 0;
+    uint32_t rejected = 0;          // Malformed, unsynchronized or not matching the request
+    uint32_t timeouts = 0;
+    uint32_t syncs = 0;
+    uint32_t lookups = 0;           // DNS lookups of the server, once at start and after a timeout
+
+    int32_t offset = 0;             // Correction applied at the last sync (ms), the error of the clock model
+    uint32_t delay = 0;             // Round trip of the sample used at the last sync (ms)
+    int32_t drift = 0;              // Estimated drift of millis() against the server (ppb)
+};
+
+// SNTP (RFC 4330) client that never waits for the network: update() sends a request or reads
+// an arrived reply and returns. Each sync is a burst of SNTP_SAMPLE_COUNT requests, the sample with
+// the shortest round trip wins. Between syncs the local clock is corrected by the measured drift.
+// The server name is resolved asynchronously and the address is kept until a request times out
+class SntpClient {
+    enum class State : uint8_t {
+        IDLE,
+        WAITING
+    };
+
+    enum class ResolveState : uint8_t {
+        NONE,
+        RESOLVING,
+        RESOLVED,
+        FAILED
+    };
+
+    WiFiUDP _udp;
+    const char *_server;
+    int32_t _time_zone_ms = 0;
+
+    // Written by the DNS callback, which runs in the network task on ESP32
+    IPAddress _server_ip;
+    std::atomic<ResolveState> _resolve_state{ResolveState::NONE};
+
+    State _state = State::IDLE;
+    unsigned long _next_request = 0;
+    unsigned long _request_time = 0;
+    uint32_t _cookie = 0;
+
+    uint8_t _sample_index = 0;
+    bool _sample_found = false;
+    int64_t _sample_epoch = 0;      // Epoch ms at _sample_time
+    unsigned long _sample_time = 0;
+    uint32_t _sample_delay = 0;
+
+    bool _synced = false;
+    bool _has_drift = false;
+    int64_t _sync_epoch = 0;        // Epoch ms at _sync_time, millis() wraps so only differences are used
+    unsigned long _sync_time = 0;
+    int32_t _drift_ppb = 0;
+
+    SntpStats _stats{};
+
+public:
+    explicit SntpClient(const char *server = SNTP_SERVER);
+
+    void begin(float time_zone);
+    void set_time_zone(float time_zone);
+
+    void update();
+
+    [[nodiscard]] inline bool available() const { return _synced; }
+
+    // UTC and local epoch time, valid once available()
+    [[nodiscard]] uint64_t epoch_ms() const;
+    [[nodiscard]] inline uint64_t epoch_tz_ms() const { return epoch_ms() + _time_zone_ms; }
+    [[nodiscard]] inline unsigned long epoch() const { return epoch_ms() / 1000; }
+    [[nodiscard]] inline unsigned long epoch_tz() const { return epoch_tz_ms() / 1000; }
+
+    [[nodiscard]] inline unsigned long sync_age() const { return (uint32_t) (millis() - _sync_time); }
+    [[nodiscard]] inline const SntpStats &stats() const { return _stats; }
+
+private:
+    bool _resolve();
+    static void _dns_found(const char *name, const ip_addr_t *address, void *arg);
+
+    void _send_request();
+    void _handle_reply();
+    void _finish_sample();
+    void _apply_sync();
+
+    [[nodiscard]] int64_t _predicted_epoch(unsigned long time) const;
+};
@@ -0,0 +1,239 @@
+#include "wifi_cache.h"
+
+#include <Arduino.h>
+
+#include <lwip/dhcp.h>
+#include <lwip/netif.h>
+
+#ifdef ARDUINO_ARCH_ESP8266
+#include <ESP8266WiFi.h>
+#else
+#include <WiFi.h>
+#include <esp_attr.h>
+#include <esp_netif.h>
+#include <esp_netif_net_stack.h>
+#include <esp_wifi.h>
+
+RTC_NOINIT_ATTR static WifiCacheData _rtc_data;
+#endif
+
+#include "lib/debug.h"
+
+static_assert(sizeof(WifiCacheData) % 4 == 0, "RTC memory is accessed in 4-byte blocks");
+
+static bool _parse_ip(const char *str, IPAddress &ip) {
+    return str[0] != '\0' && ip.fromString(str);
+}
+
+void WifiCache::begin(const SysConfig &config) {
+    _start_time = millis();
+    _pending = true;
+
+    IPAddress ip, gateway, subnet, dns;
+    if (_parse_ip(config.wifi_static_ip, ip) && _parse_ip(config.wifi_gateway, gateway)
+        && _parse_ip(config.wifi_subnet, subnet)) {
+        if (!_parse_ip(config.wifi_dns, dns)) dns = gateway;
+
+        WiFi.config(ip, gateway, subnet, dns);
+        _static = true;
+        D_PRINT("WiFi: Using static IP");
+    }
+
+    _valid = _read() && _data.credentials == _credentials_hash(config);
+    if (!_valid || _static || _data.ip == 0 || _data.lease_left < WIFI_LEASE_MIN_LEFT) return;
+
+    WiFi.config(IPAddress(_data.ip), IPAddress(_data.gateway), IPAddress(_data.subnet), IPAddress(_data.dns));
+    _lease_used = true;
+    _lease_time = millis();
+    _lease_left = _data.lease_left;
+
+    // Used once: the next reset has to stamp it again
+    _data.lease_left = 0;
+    _data.checksum = _checksum(_data);
+    _write();
+
+    D_PRINTF("WiFi: Using the cached lease, %u s left\r\n", (unsigned) _lease_left);
+}
+
+void WifiCache::connect(const SysConfig &config) {
+    if (!_valid) return;
+
+    // Same SSID and password as the framework uses, only the scan is skipped
+    WiFi.mode(WIFI_STA);
+    WiFi.begin(config.wifi_ssid, config.wifi_password, _data.channel, _data.bssid);
+
+    _used = true;
+    _start_time = millis();
+    D_PRINTF("WiFi: Direct connect, channel %u\r\n", _data.channel);
+}
+
+bool WifiCache::handle() {
+    // Like the DHCP renewal time T1, the router gets asked while half of the lease is still left
+    if (_lease_used && !_pending && millis() - _lease_time >= _lease_left * 500ul) {
+        D_PRINT("WiFi: Cached lease is half over, handing it to DHCP");
+        _release_lease();
+    }
+
+    if (!_pending) return false;
+
+    if (WiFi.status() == WL_CONNECTED) {
+        if (_used) _result = WifiCacheResult::CONNECTED;
+
+        _pending = false;
+        return true;
+    }
+
+    if (!_used) return false;
+
+    // Not fought over, the framework owns the connection. Reported, so the fast path can be checked
+    if (!_bssid_configured()) {
+        D_PRINT("WiFi: Direct connect was replaced by a full connect");
+
+        _result = WifiCacheResult::REPLACED;
+        _used = false;
+        return false;
+    }
+
+    // The access point moved: fall back to the full scan
+    if (millis() - _start_time >= WIFI_FAST_CONNECT_TIMEOUT) {
+        D_PRINT("WiFi: Direct connect failed, dropping the cache");
+
+        // The full connect gets its address from DHCP, the network may have changed with the access point
+        if (_lease_used) _release_lease();
+        invalidate();
+        _result = WifiCacheResult::TIMEOUT;
+        _used = false;
+    }
+
+    return false;
+}
+
+void WifiCache::store(const SysConfig &config) {
+    _store(config, 0);
+}
+
+void WifiCache::stamp_restart(const SysConfig &config) {
+    if (_static) return;
+
+    const uint32_t left = _lease_remaining();
+    _store(config, left);
+
+    D_PRINTF("WiFi: Restart stamped, lease %u s left\r\n", (unsigned) left);
+}
+
+void WifiCache::_store(const SysConfig &config, uint32_t lease_left) {
+    if (WiFi.status() != WL_CONNECTED) return;
+
+    WifiCacheData data{};
+    data.credentials = _credentials_hash(config);
+
+    if (const auto bssid = WiFi.BSSID()) memcpy(data.bssid, bssid, sizeof(data.bssid));
+    data.channel = WiFi.channel();
+
+    if (!_static) {
+        data.ip = WiFi.localIP();
+        data.gateway = WiFi.gatewayIP();
+        data.subnet = WiFi.subnetMask();
+        data.dns = WiFi.dnsIP();
+        data.lease_left = lease_left;
+    }
+
+    data.checksum = _checksum(data);
+    if (memcmp(&data, &_data, sizeof(data)) == 0) return;
+
+    _data = data;
+    _write();
+}
+
+void WifiCache::invalidate() {
+    _data = {};
+    _write();
+}
+
+void WifiCache::_release_lease() {
+    // Zero addresses turn the DHCP client back on, it asks for a lease from the current address
+    WiFi.config(IPAddress(), IPAddress(), IPAddress());
+
+    _lease_used = false;
+}
+
+uint32_t WifiCache::_lease_remaining() const {
+    if (!_lease_used) return _dhcp_lease_left();
+
+    const uint32_t elapsed = (millis() - _lease_time) / 1000;
+    return elapsed < _lease_left ? _lease_left - elapsed : 0;
+}
+
+// Time left of the bound lease, counted by the lwIP DHCP client in DHCP_COARSE_TIMER_SECS steps, 0 if not bound
+uint32_t WifiCache::_dhcp_lease_left() {
+#ifdef ARDUINO_ARCH_ESP8266
+    netif *station = nullptr;
+    for (auto item = netif_list; item; item = item->next) {
+        if (item->num == STATION_IF) station = item;
+    }
+#else
+    const auto station = (netif *) esp_netif_get_netif_impl(esp_netif_get_handle_from_ifkey("WIFI_STA_DEF"));
+#endif
+
+    if (!station) return 0;
+
+    // Read outside the TCP/IP thread, a value one step stale only shortens the stamp
+    const auto dhcp = netif_dhcp_data(station);
+    if (!dhcp || dhcp->state != DHCP_STATE_BOUND || dhcp->t0_timeout <= dhcp->lease_used) return 0;
+
+    return (uint32_t) (dhcp->t0_timeout - dhcp->lease_used) * DHCP_COARSE_TIMER_SECS;
+}
+
+bool WifiCache::_bssid_configured() {
+#ifdef ARDUINO_ARCH_ESP8266
+    station_config config{};
+    return wifi_station_get_config(&config) && config.bssid_set;
+#else
+    wifi_config_t config{};
+    return esp_wifi_get_config(WIFI_IF_STA, &config) == ESP_OK && config.sta.bssid_set;
+#endif
+}
+
+bool WifiCache::_read() {
+#ifdef ARDUINO_ARCH_ESP8266
+    if (!ESP.rtcUserMemoryRead(WIFI_CACHE_RTC_OFFSET, (uint32_t *) &_data, sizeof(_data))) return false;
+#else
+    memcpy(&_data, &_rtc_data, sizeof(_data));
+#endif
+
+    // RTC memory holds garbage after power up
+    if (_data.checksum != _checksum(_data)) {
+        _data = {};
+        return false;
+    }
+
+    return true;
+}
+
+void WifiCache::_write() {
+#ifdef ARDUINO_ARCH_ESP8266
+    ESP.rtcUserMemoryWrite(WIFI_CACHE_RTC_OFFSET, (uint32_t *) &_data, sizeof(_data));
+#else
+    memcpy(&_rtc_data, &_data, sizeof(_data));
+#endif
+}
+
+// FNV-1a over the data that follows the checksum field
+uint32_t WifiCache::_checksum(const WifiCacheData &data) {
+    const auto bytes = (const uint8_t *) &data;
+
+    uint32_t hash = 2166136261u;
+    for (size_t i = sizeof(data.checksum); i < sizeof(data); ++i) hash = (hash ^ bytes[i]) * 16777619u;
+
+    return hash;
+}
+
+uint32_t WifiCache::_credentials_hash(const SysConfig &config) {
+    uint32_t hash = 2166136261u;
+    for (const char *ch = config.wifi_ssid; *ch; ++ch) hash = (hash ^ (uint8_t) *ch) * 16777619u;
+
+    hash = (hash ^ 0xff) * 16777619u;
+    for (const char *ch = config.wifi_password; *ch; ++ch) hash = (hash ^ (uint8_t) *ch) * 16777619u;
+
+    return hash;
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstdint>
+
+#include "lib/utils/enum.h"
+
+#include "app/config.h"
+
+struct __attribute ((packed)) WifiCacheData {
+    uint32_t checksum = 0;
+    uint32_t credentials = 0;       // Hash of the SSID and password the entry belongs to
+
+    uint8_t bssid[6]{};
+    uint8_t channel = 0;
+    uint8_t reserved = 0;
+
+    // DHCP lease of that connection, 0 with a static IP from the settings
+    uint32_t ip = 0;
+    uint32_t gateway = 0;
+    uint32_t subnet = 0;
+    uint32_t dns = 0;
+    uint32_t lease_left = 0;        // s, stamped by a restart the app asked for, 0 if the time since the write is unknown
+};
+
+MAKE_ENUM_AUTO(WifiCacheResult, uint8_t,
+    NONE,           // Cold boot, no entry or other credentials
+    CONNECTED,      // Connected to the cached access point
+    REPLACED,       // The framework restarted the station without the cached BSSID before it connected
+    TIMEOUT         // The access point didn't answer, the entry is dropped
+);
+
+// Keeps the access point and the DHCP lease of the last successful connection in RTC memory. After a restart
+// the station connects to the known BSSID and channel directly, skipping the scan. If the restart stamped the time
+// left of the lease, the address is applied as well, skipping DHCP; the DHCP client takes over at half the time left,
+// so the lease is renewed before it runs out. RTC memory is lost on power down, so a cold boot does a full connect
+class WifiCache {
+    WifiCacheData _data{};
+
+    bool _valid = false;
+    bool _used = false;
+    bool _pending = false;
+    bool _static = false;           // Static IP from the settings, no lease to keep
+    unsigned long _start_time = 0;
+    WifiCacheResult _result = WifiCacheResult::NONE;
+
+    bool _lease_used = false;
+    unsigned long _lease_time = 0;  // When the cached lease was applied
+    uint32_t _lease_left = 0;       // s, left of it at that moment
+
+public:
+    // Applies the static IP from the config, or the cached lease while it is valid, and reads the entry.
+    // Call before the station starts
+    void begin(const SysConfig &config);
+
+    // Restarts the station towards the cached access point. Call after the framework has started
+    // its own connect, otherwise its WiFi.begin() would replace the cached BSSID with a full scan
+    void connect(const SysConfig &config);
+
+    // Polls the connection while it is pending and hands a cached lease back to DHCP when it is due.
+    // Returns true once, when the station gets connected
+    bool handle();
+
+    // Stores the current connection, RTC memory is written only when something changed
+    void store(const SysConfig &config);
+
+    // Stores the connection with the time left of its lease. Call right before a restart the app asked for:
+    // any other reset can't tell how long ago the entry was written, so its lease isn't reused
+    void stamp_restart(const SysConfig &config);
+    void invalidate();
+
+    [[nodiscard]] inline WifiCacheResult result() const { return _result; }
+    [[nodiscard]] inline bool lease_used() const { return _lease_used; }
+
+private:
+    static bool _bssid_configured();
+
+    void _store(const SysConfig &config, uint32_t lease_left);
+    void _release_lease();
+    [[nodiscard]] uint32_t _lease_remaining() const;
+    static uint32_t _dhcp_lease_left();
+
+    bool _read();
+    void _write();
+
+    static uint32_t _checksum(const WifiCacheData &data);
+    static uint32_t _credentials_hash(const SysConfig &config);
+};
@@ -0,0 +1,95 @@
+#include "ws_feed.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "lib/debug.h"
+
+WsFeedServer::WsFeedServer(const char *path) : _socket(path) {}
+
+void WsFeedServer::begin(WebServer &server) {
+    _socket.onEvent([this](AsyncWebSocket *, AsyncWebSocketClient *client, AwsEventType type, void *arg, uint8_t *data, size_t length) {
+        _on_event(client, type, arg, data, length);
+    });
+
+    server.addHandler(&_socket);
+}
+
+void WsFeedServer::on_request(RequestHandler handler, void *arg) {
+    _request_handler = handler;
+    _request_arg = arg;
+}
+
+void WsFeedServer::_on_event(AsyncWebSocketClient *client, AwsEventType type, void *arg, const uint8_t *data, size_t length) {
+    WsFeedEvent event{};
+    event.client = client->id();
+
+    if (type == WS_EVT_CONNECT) {
+        event.type = WsFeedEvent::Type::CONNECT;
+    } else if (type == WS_EVT_DATA) {
+        // Subscriptions and requests are single binary frames
+        const auto info = (const AwsFrameInfo *) arg;
+        if (!info->final || info->index != 0 || info->len != length || info->opcode != WS_BINARY) return;
+        if (length == 0 || length > sizeof(event.data)) return;
+
+        event.type = length == SubscriptionFeed::BITMAP_SIZE ? WsFeedEvent::Type::SUBSCRIBE : WsFeedEvent::Type::REQUEST;
+        event.length = (uint8_t) length;
+        memcpy(event.data, data, length);
+    } else {
+        // Disconnects are found by handle(), nothing has to be queued for them
+        return;
+    }
+
+    // A lost subscription or request would go unnoticed, let the client reconnect instead
+    if (!_events.push(event)) client->close();
+}
+
+void WsFeedServer::handle() {
+    WsFeedEvent event;
+    while (_events.pop(event)) {
+        switch (event.type) {
+            case WsFeedEvent::Type::CONNECT:
+                if (!_feed.connect(event.client)) {
+                    D_PRINTF("Feed: No free slot, closing client %u\r\n", (unsigned) event.client);
+                    _socket.close(event.client);
+                }
+                break;
+
+            case WsFeedEvent::Type::SUBSCRIBE:
+                _feed.subscribe(event.client, event.data, event.length);
+                break;
+
+            case WsFeedEvent::Type::REQUEST:
+                _answer(event);
+                break;
+        }
+    }
+
+    _drop_closed();
+    _feed.flush(_frame, sizeof(_frame), _send, this);
+}
+
+void WsFeedServer::_answer(const WsFeedEvent &event) {
+    if (!_request_handler || !_socket.client(event.client)) return;
+
+    // The frame buffer is free between flushes, the answer is sent before the next one is built
+    const size_t length = _request_handler(_request_arg, event.data, event.length, _frame, sizeof(_frame));
+    if (length > 0) _socket.binary(event.client, _frame, length);
+}
+
+void WsFeedServer::_drop_closed() {
+    for (uint8_t i = 0; i < WS_FEED_CLIENT_COUNT; ++i) {
+        const auto client = _feed.client(i);
+        if (client && !_socket.client(client->id)) _feed.disconnect(client->id);
+    }
+
+    _socket.cleanupClients(WS_FEED_CLIENT_COUNT);
+}
+
+bool WsFeedServer::_send(void *arg, uint32_t client, const uint8_t *data, size_t length) {
+    auto &self = *(WsFeedServer *) arg;
+    if (!self._socket.availableForWrite(client)) return false;
+
+    self._socket.binary(client, (uint8_t *) data, length);
+    return true;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+
+#include "lib/network/web.h"
+
+#include "misc/subscription_feed.h"
+#include "utils/lock_free_queue.h"
+
+struct WsFeedEvent {
+    enum class Type : uint8_t {
+        CONNECT,
+        SUBSCRIBE,
+        REQUEST
+    };
+
+    Type type;
+    uint32_t client;
+    uint8_t length;
+    uint8_t data[SubscriptionFeed::BITMAP_SIZE];
+};
+
+// Filtered state socket next to the framework one. A client sends the bitmap of the packet types it
+// wants as a binary message and receives only their changes, see SubscriptionFeed for the formats.
+// A shorter message is a request starting with its packet type, answered to that client only.
+// Socket events arrive in the network callback and are queued, handle() applies them and sends from the app loop
+class WsFeedServer {
+public:
+    // Writes the answer to `request` into `response`, returns its length or 0 if there is none
+    typedef size_t (*RequestHandler)(void *arg, const uint8_t *request, size_t length, uint8_t *response, size_t size);
+
+private:
+    SubscriptionFeed _feed{};
+    AsyncWebSocket _socket;
+
+    LockFreeQueue<WsFeedEvent, WS_FEED_EVENT_QUEUE_SIZE> _events{};
+    uint8_t _frame[WS_MAX_PACKET_SIZE]{};
+
+    RequestHandler _request_handler = nullptr;
+    void *_request_arg = nullptr;
+
+public:
+    explicit WsFeedServer(const char *path = "/ws/feed");
+
+    void begin(WebServer &server);
+
+    // Called from the app loop with the request and a WS_MAX_PACKET_SIZE response buffer
+    void on_request(RequestHandler handler, void *arg);
+
+    // Safe to call from any context
+    inline void changed(const AbstractParameter *parameter) { _feed.changed(parameter); }
+
+    inline SubscriptionFeed &feed() { return _feed; }
+    [[nodiscard]] inline const SubscriptionFeed &feed() const { return _feed; }
+    [[nodiscard]] inline uint32_t event_overflows() const { return _events.overflow_count(); }
+
+    void handle();
+
+private:
+    void _on_event(AsyncWebSocketClient *client, AwsEventType type, void *arg, const uint8_t *data, size_t length);
+    void _answer(const WsFeedEvent &event);
+    void _drop_closed();
+
+    static bool _send(void *arg, uint32_t client, const uint8_t *data, size_t length);
+};
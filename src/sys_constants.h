@@ -5,6 +5,9 @@
 
 #define WS_MAX_PACKET_SIZE                      (260u)
 #define WS_MAX_PACKET_QUEUE                     (10u)
+#define WS_FEED_CLIENT_COUNT                    (4u)                    // Clients of the filtered /ws/feed socket
+#define WS_FEED_ENTRY_COUNT                     (64u)                   // Parameters with a packet type the feed can carry
+#define WS_FEED_EVENT_QUEUE_SIZE                (8u)                    // Connects and subscriptions waiting for the app loop
 
 #define PACKET_SIGNATURE                        ((uint16_t) 0xDABA)
 
@@ -12,7 +15,7 @@
 
 #define STORAGE_PATH                            ("/__storage/")
 #define STORAGE_HEADER                          ((uint32_t) 0xd0c1f2c3)
-#define STORAGE_CONFIG_VERSION                  ((uint8_t) 1)
+#define STORAGE_CONFIG_VERSION                  ((uint8_t) 7)
 #define STORAGE_SAVE_INTERVAL                   (60000u)                // Wait before commit settings to FLASH
 
 #define TIMER_GROW_AMOUNT                       (8u)
@@ -20,23 +23,37 @@
 #define PIN_DISABLED                            (LOW)
 #define PIN_ENABLED                             (HIGH)
 
-#define PWM_RESOLUTION                          (14u)
-#define PWM_FREQUENCY                           (22000u)
+#define PWM_RESOLUTION                          (14u)                   // Also the scale of brightness/temperature values
+#define PWM_FREQUENCY                           (22000u)                // PwmProfile::DEFAULT, capped by the board limit
 #define PWM_MAX_VALUE                           ((uint16_t)((1u << PWM_RESOLUTION) - 1))
 
-#ifdef ARDUINO_ARCH_ESP32
-#define PWM_MAX_FREQUENCY                       (40000000ul / (1u << PWM_RESOLUTION))
-#else
-#define PWM_MAX_FREQUENCY                       (60000ul)
-#endif
+#define WIFI_FAST_CONNECT_TIMEOUT               (5000ul)                // Direct connect with the cached AP, then full scan
+#define WIFI_CACHE_RTC_OFFSET                   (64u)                   // ESP8266 RTC user memory block, clear of the OTA command
+#define WIFI_LEASE_MIN_LEFT                     (300u)                  // s, a cached lease with less left goes to DHCP; covers the reboot and the 60 s lease steps
+
+#define ADMISSION_CLIENT_SLOTS                  (8u)                    // Clients tracked by the HTTP rate limiter
+#define ADMISSION_CLIENT_IN_FLIGHT              (2u)                    // Concurrent HTTP API requests per client
+#define API_RESPONSE_SIZE                       (768u)                  // Response buffer of each admitted request, fits a history page
 
 #define NTP_UPDATE_INTERVAL                     (24ul * 3600 * 1000)
+#define SNTP_PORT                               (123u)
+#define SNTP_LOCAL_PORT                         (2390u)
+#define SNTP_TIMEOUT                            (1000ul)
+#define SNTP_SAMPLE_COUNT                       (4u)                    // Requests per sync, the fastest reply wins
+#define SNTP_SAMPLE_INTERVAL                    (2000ul)
+#define SNTP_RETRY_INTERVAL                     (15000ul)               // After a sync without a single reply
+#define SNTP_DRIFT_MIN_INTERVAL                 (3600ul * 1000)         // Shorter intervals don't update the drift
+#define SNTP_MAX_DRIFT_PPB                      (500000l)               // Larger estimates are treated as outliers
 
 #define GAMMA                                   (2.2f)
 
 #define RESTART_DELAY                           (500u)
 #define APP_LOOP_INTERVAL                       (10u)
 
+#define TIMER_WHEEL_TICK                        (APP_LOOP_INTERVAL)     // ms, the app loop runs on the wheel once per tick
+#define TIMER_WHEEL_SLOT_BITS                   (6u)                    // 64 slots per level
+#define TIMER_WHEEL_LEVELS                      (4u)                    // 2^24 ticks, ~46 h at 10 ms; longer delays wait in the top level
+
 #define CONFIG_STRING_SIZE                      (32u)
 
 #define LED_TEMPERATURE_MAX_VALUE               (PWM_MAX_VALUE * 2 + 1)
@@ -46,4 +63,26 @@
 #define BRIGHTNESS_CHANGE_DIVIDER               (50u)
 #define TEMPERATURE_CHANGE_STEPS                (4u)
 
-#define BTN_HOLD_CALL_INTERVAL                  (20u)
\ No newline at end of file
+#define BTN_DEBOUNCE_INTERVAL                   (30u)
+#define BTN_CLICK_TIMEOUT                       (300u)
+#define BTN_HOLD_TIMEOUT                        (500u)
+#define BTN_HOLD_CALL_INTERVAL                  (20u)
+
+#define PRESET_COUNT                            (8u)
+#define ZONE_COUNT                              (4u)                    // Zone 0 is the main light, others are in Config.zones
+#define COMMAND_QUEUE_SIZE                      (16u)
+
+#define OTA_HEATSHRINK_WINDOW_BITS              (10u)                   // heatshrink -w
+#define OTA_HEATSHRINK_LOOKAHEAD_BITS           (5u)                    // heatshrink -l
+
+#define HISTORY_BUFFER_SIZE                     (1024u)                 // Bytes, ~250 events
+#define HISTORY_TIME_RESOLUTION                 (1000u)                 // ms
+#define HISTORY_COALESCE_INTERVAL               (2000u)                 // Merge changes of the same parameter closer than this (ms)
+#define HISTORY_PAGE_SIZE                       (200u)                  // Encoded bytes per WebSocket page
+#define HISTORY_HTTP_PAGE_SIZE                  (16u)                   // Events per /api/history response
+
+#define NOTIFICATION_TOPIC_COUNT                (80u)                   // Parameters with own subscriber lists and counters
+#define NOTIFICATION_SUBSCRIBER_COUNT           (8u)
+#define NOTIFICATION_LINK_COUNT                 (128u)                  // Subscriber-topic pairs, a group takes one per parameter
+#define NOTIFICATION_RATE_INTERVAL              (1000ul)
+#define NOTIFICATION_HTTP_PAGE_SIZE             (16u)                   // Topics per /api/notifications response
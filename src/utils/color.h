@@ -3,6 +3,31 @@
 #include <cstdint>
 #include <cmath>
 
+// Color with 16 bits per channel, the wire and storage format of the high-precision color parameters
+struct __attribute ((packed)) Rgb48 {
+    uint16_t r, g, b;
+
+    inline bool operator==(const Rgb48 &other) const { return r == other.r && g == other.g && b == other.b; }
+    inline bool operator!=(const Rgb48 &other) const { return !(*this == other); }
+};
+
+constexpr Rgb48 RGB48_WHITE{UINT16_MAX, UINT16_MAX, UINT16_MAX};
+
+// 0xAB expands to 0xABAB, so 0xFF maps exactly to 0xFFFF
+constexpr Rgb48 rgb48_from_rgb24(uint32_t color) {
+    return {
+        (uint16_t) (((color >> 16) & 0xff) * 257),
+        (uint16_t) (((color >> 8) & 0xff) * 257),
+        (uint16_t) ((color & 0xff) * 257)
+    };
+}
+
+constexpr uint32_t rgb24_from_rgb48(const Rgb48 &color) {
+    return (uint32_t) ((color.r + 128u) / 257) << 16
+        | (uint32_t) ((color.g + 128u) / 257) << 8
+        | (uint32_t) ((color.b + 128u) / 257);
+}
+
 inline float _clamp(float value, float min, float max) {
     return std::max(min, std::min(value, max));
 }
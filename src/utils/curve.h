@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <Arduino.h>
+
+#include "utils/math.h"
+
+// Response curves over the full 16-bit input range: 257 precomputed knots, linear interpolation between them.
+// Tables are built at compile time, so curve parameters come straight from the constants
+
+constexpr uint8_t CURVE_TABLE_BITS = 8;
+constexpr size_t CURVE_TABLE_SIZE = (1u << CURVE_TABLE_BITS) + 1;
+
+struct CurveTable {
+    uint16_t values[CURVE_TABLE_SIZE];
+};
+
+// fn maps [0, 1] to [0, 1], knots are scaled to max_value
+template<typename Fn>
+constexpr CurveTable build_curve_table(Fn fn, uint16_t max_value) {
+    CurveTable table{};
+
+    for (size_t i = 0; i < CURVE_TABLE_SIZE; ++i) {
+        const double y = fn((double) i / (CURVE_TABLE_SIZE - 1)) * max_value + 0.5;
+
+        table.values[i] = y <= 0 ? 0 : y >= max_value ? max_value : (uint16_t) y;
+    }
+
+    return table;
+}
+
+constexpr CurveTable build_gamma_table(double gamma, uint16_t max_value = UINT16_MAX) {
+    return build_curve_table([gamma](double x) {
+        return x > 0 ? _constexpr_exp(gamma * _constexpr_ln(x)) : 0.0;
+    }, max_value);
+}
+
+// Perceived brightness: 1 - log10(10 - 9x)
+constexpr CurveTable build_brightness_table(uint16_t max_value) {
+    constexpr double LN10 = 2.30258509299404568402;
+
+    return build_curve_table([](double x) {
+        return 1 - _constexpr_ln(10 - 9 * x) / LN10;
+    }, max_value);
+}
+
+inline uint16_t interpolate_curve(const CurveTable &table, uint16_t value) {
+    if (value == UINT16_MAX) return pgm_read_word(&table.values[CURVE_TABLE_SIZE - 1]);
+
+    const uint16_t index = value >> (16 - CURVE_TABLE_BITS);
+    const uint16_t fraction = value & ((1u << (16 - CURVE_TABLE_BITS)) - 1);
+
+    const uint16_t from = pgm_read_word(&table.values[index]);
+    const uint16_t to = pgm_read_word(&table.values[index + 1]);
+
+    return from + (((uint32_t) (to - from) * fraction) >> (16 - CURVE_TABLE_BITS));
+}
+
+extern const CurveTable GAMMA_TABLE;
+
+inline uint16_t apply_gamma16(uint16_t value) {
+    return interpolate_curve(GAMMA_TABLE, value);
+}
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// Streaming decoder for the heatshrink LZSS format (https://github.com/atomicobject/heatshrink).
+// The stream is a sequence of MSB-first bit fields:
+//   1 <literal:8>                                  - literal byte
+//   0 <offset - 1:WindowBits> <count - 1:LookaheadBits> - copy `count` bytes from `offset` bytes back
+// Window and lookahead sizes are not stored in the stream, so they must match the encoder (`-w` and `-l`).
+// Decoded bytes are passed to `sink(const uint8_t *data, size_t length) -> bool` in chunks of up to OutputSize
+
+template<uint8_t WindowBits, uint8_t LookaheadBits, size_t OutputSize = 256>
+class HeatshrinkDecoder {
+    static_assert(WindowBits >= 4 && WindowBits <= 15, "WindowBits must be in range [4, 15]");
+    static_assert(LookaheadBits >= 3 && LookaheadBits < WindowBits, "LookaheadBits must be in range [3, WindowBits)");
+
+    static constexpr uint16_t WINDOW_SIZE = 1u << WindowBits;
+    static constexpr uint16_t WINDOW_MASK = WINDOW_SIZE - 1;
+
+    enum class State : uint8_t {
+        TAG,
+        LITERAL,
+        OFFSET,
+        COUNT,
+    };
+
+    uint8_t _window[WINDOW_SIZE]{};
+    uint16_t _head = 0;
+
+    uint8_t _output[OutputSize]{};
+    size_t _output_length = 0;
+
+    uint32_t _bits = 0;
+    uint8_t _bit_count = 0;
+
+    State _state = State::TAG;
+    uint16_t _offset = 0;
+
+    bool _failed = false;
+    uint32_t _total_output = 0;
+
+public:
+    void reset() {
+        memset(_window, 0, sizeof(_window));
+        _head = 0;
+        _output_length = 0;
+        _bits = 0;
+        _bit_count = 0;
+        _state = State::TAG;
+        _offset = 0;
+        _failed = false;
+        _total_output = 0;
+    }
+
+    // Returns false if the sink rejected data, the decoder stays failed until reset()
+    template<typename Sink>
+    bool feed(const uint8_t *data, size_t length, Sink &&sink) {
+        for (size_t i = 0; i < length && !_failed; ++i) {
+            _bits = (_bits << 8) | data[i];
+            _bit_count += 8;
+
+            for (uint8_t need = _field_size(); _bit_count >= need && !_failed; need = _field_size()) {
+                _bit_count -= need;
+                _step((_bits >> _bit_count) & ((1u << need) - 1), sink);
+            }
+        }
+
+        return !_failed && _flush(sink);
+    }
+
+    // Flushes buffered output. Trailing bits are the encoder's zero padding and are ignored
+    template<typename Sink>
+    bool finish(Sink &&sink) {
+        return !_failed && _flush(sink);
+    }
+
+    [[nodiscard]] inline uint32_t total_output() const { return _total_output; }
+    [[nodiscard]] static constexpr size_t memory_size() { return sizeof(HeatshrinkDecoder); }
+
+private:
+    [[nodiscard]] inline uint8_t _field_size() const {
+        switch (_state) {
+            case State::TAG: return 1;
+            case State::LITERAL: return 8;
+            case State::OFFSET: return WindowBits;
+            case State::COUNT: return LookaheadBits;
+        }
+
+        return 1;
+    }
+
+    template<typename Sink>
+    void _step(uint16_t value, Sink &sink) {
+        switch (_state) {
+            case State::TAG:
+                _state = value ? State::LITERAL : State::OFFSET;
+                break;
+
+            case State::LITERAL:
+                _emit((uint8_t) value, sink);
+                _state = State::TAG;
+                break;
+
+            case State::OFFSET:
+                _offset = value + 1;
+                _state = State::COUNT;
+                break;
+
+            case State::COUNT:
+                for (uint16_t count = value + 1; count > 0 && !_failed; --count) {
+                    _emit(_window[(uint16_t) (_head - _offset) & WINDOW_MASK], sink);
+                }
+
+                _state = State::TAG;
+                break;
+        }
+    }
+
+    template<typename Sink>
+    inline void _emit(uint8_t value, Sink &sink) {
+        _window[_head++ & WINDOW_MASK] = value;
+        _output[_output_length++] = value;
+
+        if (_output_length == OutputSize) _failed = !_flush(sink);
+    }
+
+    template<typename Sink>
+    bool _flush(Sink &sink) {
+        if (_output_length == 0) return true;
+
+        const bool result = sink((const uint8_t *) _output, _output_length);
+        _total_output += _output_length;
+        _output_length = 0;
+
+        return result;
+    }
+};
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+// Writes JSON into a caller-owned buffer without allocations.
+// Keys and values are separated automatically, nesting is limited to 8 levels.
+// Output that doesn't fit is cut and ok() turns false, the buffer always stays null-terminated
+class JsonWriter {
+    char *_buffer;
+    size_t _size;
+    size_t _length = 0;
+
+    uint8_t _depth = 0;
+    uint8_t _filled = 0;        // Bit per level, set once the container has an item
+    bool _overflow = false;
+
+public:
+    JsonWriter(char *buffer, size_t size) : _buffer(buffer), _size(size) {
+        if (_size > 0) _buffer[0] = '\0';
+    }
+
+    void begin_object(const char *key = nullptr) { _item(key); _open('{'); }
+    void end_object() { _close('}'); }
+
+    void begin_array(const char *key = nullptr) { _item(key); _open('['); }
+    void end_array() { _close(']'); }
+
+    void value(const char *key, const char *value) {
+        _item(key);
+        _string(value);
+    }
+
+    void value(const char *key, bool value) {
+        _item(key);
+        _raw(value ? "true" : "false");
+    }
+
+    void value(const char *key, int value) { _item(key); _printf("%d", value); }
+    void value(const char *key, unsigned value) { _item(key); _printf("%u", value); }
+    void value(const char *key, long value) { _item(key); _printf("%ld", value); }
+    void value(const char *key, unsigned long value) { _item(key); _printf("%lu", value); }
+    void value(const char *key, long long value) { _item(key); _printf("%lld", value); }
+    void value(const char *key, unsigned long long value) { _item(key); _printf("%llu", value); }
+    void value(const char *key, double value) { _item(key); _printf("%.3f", value); }
+
+    // Array items
+    template<typename T>
+    void item(T value) { this->value(nullptr, value); }
+
+    [[nodiscard]] inline const char *c_str() const { return _buffer; }
+    [[nodiscard]] inline size_t length() const { return _length; }
+    [[nodiscard]] inline bool ok() const { return !_overflow && _depth == 0; }
+
+private:
+    void _item(const char *key) {
+        if (_depth > 0) {
+            if (_filled & (1u << (_depth - 1))) _put(',');
+            _filled |= 1u << (_depth - 1);
+        }
+
+        if (key) {
+            _string(key);
+            _put(':');
+        }
+    }
+
+    void _open(char ch) {
+        _put(ch);
+        if (_depth < 8) _filled &= ~(1u << _depth);
+        ++_depth;
+    }
+
+    void _close(char ch) {
+        if (_depth > 0) --_depth;
+        _put(ch);
+    }
+
+    void _string(const char *str) {
+        _put('"');
+        for (; *str; ++str) {
+            const auto ch = (uint8_t) *str;
+            if (ch == '"' || ch == '\\') {
+                _put('\\');
+                _put((char) ch);
+            } else if (ch < 0x20) {
+                _printf("\\u%04x", ch);
+            } else {
+                _put((char) ch);
+            }
+        }
+        _put('"');
+    }
+
+    void _raw(const char *str) {
+        for (; *str; ++str) _put(*str);
+    }
+
+    template<typename T>
+    void _printf(const char *format, T value) {
+        char tmp[24];
+        snprintf(tmp, sizeof(tmp), format, value);
+        _raw(tmp);
+    }
+
+    void _put(char ch) {
+        if (_length + 1 >= _size) {
+            _overflow = true;
+            return;
+        }
+
+        _buffer[_length++] = ch;
+        _buffer[_length] = '\0';
+    }
+};
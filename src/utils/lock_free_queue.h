@@ -0,0 +1,97 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Bounded lock-free MPMC queue (D. Vyukov). Producers never block: push fails when the queue is full.
+// Capacity must be a power of two
+
+template<typename T, size_t Capacity>
+class LockFreeQueue {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T data;
+    };
+
+    Cell _cells[Capacity];
+
+    std::atomic<size_t> _enqueue_pos{0};
+    std::atomic<size_t> _dequeue_pos{0};
+
+    std::atomic<uint32_t> _overflow_count{0};
+    std::atomic<uint32_t> _max_depth{0};
+
+public:
+    LockFreeQueue() {
+        for (size_t i = 0; i < Capacity; ++i) _cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    LockFreeQueue(const LockFreeQueue &) = delete;
+    LockFreeQueue &operator=(const LockFreeQueue &) = delete;
+
+    bool push(const T &value) {
+        size_t pos = _enqueue_pos.load(std::memory_order_relaxed);
+        Cell *cell;
+
+        for (;;) {
+            cell = &_cells[pos & (Capacity - 1)];
+            const size_t seq = cell->sequence.load(std::memory_order_acquire);
+            const auto diff = (intptr_t) seq - (intptr_t) pos;
+
+            if (diff == 0) {
+                if (_enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            } else if (diff < 0) {
+                _overflow_count.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            } else {
+                pos = _enqueue_pos.load(std::memory_order_relaxed);
+            }
+        }
+
+        cell->data = value;
+        cell->sequence.store(pos + 1, std::memory_order_release);
+
+        const uint32_t depth = size();
+        uint32_t max_depth = _max_depth.load(std::memory_order_relaxed);
+        while (depth > max_depth && !_max_depth.compare_exchange_weak(max_depth, depth, std::memory_order_relaxed)) {}
+
+        return true;
+    }
+
+    bool pop(T &value) {
+        size_t pos = _dequeue_pos.load(std::memory_order_relaxed);
+        Cell *cell;
+
+        for (;;) {
+            cell = &_cells[pos & (Capacity - 1)];
+            const size_t seq = cell->sequence.load(std::memory_order_acquire);
+            const auto diff = (intptr_t) seq - (intptr_t) (pos + 1);
+
+            if (diff == 0) {
+                if (_dequeue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = _dequeue_pos.load(std::memory_order_relaxed);
+            }
+        }
+
+        value = cell->data;
+        cell->sequence.store(pos + Capacity, std::memory_order_release);
+
+        return true;
+    }
+
+    [[nodiscard]] size_t size() const {
+        const size_t enqueue = _enqueue_pos.load(std::memory_order_relaxed);
+        const size_t dequeue = _dequeue_pos.load(std::memory_order_relaxed);
+        return enqueue >= dequeue ? enqueue - dequeue : 0;
+    }
+
+    [[nodiscard]] static constexpr size_t capacity() { return Capacity; }
+    [[nodiscard]] uint32_t overflow_count() const { return _overflow_count.load(std::memory_order_relaxed); }
+    [[nodiscard]] uint32_t max_depth() const { return _max_depth.load(std::memory_order_relaxed); }
+};
@@ -33,3 +33,43 @@ inline uint16_t map16(uint16_t value, uint16_t limit_src, uint16_t limit_dst) {
     value = std::max((uint16_t) 0, std::min(limit_src, value));
     return (int32_t) value * limit_dst / limit_src;
 }
+
+constexpr double _constexpr_ln(double x) {
+    // ln(x) = 2 * atanh((x - 1) / (x + 1)), converges for any x > 0 but slowly far from 1, so reduce by powers of two
+    constexpr double LN2 = 0.69314718055994530942;
+
+    int exponent = 0;
+    while (x > 1.5) { x /= 2; ++exponent; }
+    while (x < 0.75) { x *= 2; --exponent; }
+
+    const double y = (x - 1) / (x + 1);
+    const double y2 = y * y;
+
+    double term = y;
+    double sum = 0;
+    for (int i = 1; i < 60; i += 2) {
+        sum += term / i;
+        term *= y2;
+    }
+
+    return 2 * sum + exponent * LN2;
+}
+
+constexpr double _constexpr_exp(double x) {
+    // Split into integer and fractional parts to keep the Taylor series short
+    int whole = 0;
+    while (x > 0.5) { x -= 1; ++whole; }
+    while (x < -0.5) { x += 1; --whole; }
+
+    double term = 1, sum = 1;
+    for (int i = 1; i < 30; ++i) {
+        term *= x / i;
+        sum += term;
+    }
+
+    constexpr double E = 2.71828182845904523536;
+    for (; whole > 0; --whole) sum *= E;
+    for (; whole < 0; ++whole) sum /= E;
+
+    return sum;
+}
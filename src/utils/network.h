@@ -2,31 +2,13 @@
 
 #include <variant>
 
-#include <ArduinoJson.h>
-#include <ESPAsyncWebServer.h>
+#include "json.h"
 
 typedef std::variant<bool, int, long, long long, float, double, const char *> JsonPropVariantT;
 typedef std::initializer_list<std::pair<const char *, JsonPropVariantT>> JsonPropListT;
 
-inline void response_with_json(AsyncWebServerRequest *request, JsonDocument &doc) {
-    auto *response = request->beginResponseStream("application/json");
-    serializeJson(doc, *response);
-    request->send(response);
-}
-
-
-inline void response_with_json(AsyncWebServerRequest *request, JsonPropListT props) {
-    JsonDocument doc;
+inline void write_json(JsonWriter &writer, JsonPropListT props) {
     for (auto prop: props) {
-        std::visit([&](auto &&arg) { doc[prop.first] = arg; }, prop.second);
+        std::visit([&](auto &&arg) { writer.value(prop.first, arg); }, prop.second);
     }
-
-    response_with_json(request, doc);
-}
-
-inline void response_with_json_status(AsyncWebServerRequest *request, const char *status) {
-    JsonDocument doc;
-    doc["status"] = status;
-
-    response_with_json(request, doc);
 }
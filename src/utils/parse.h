@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+inline bool _is_space(char ch) {
+    return ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n';
+}
+
+// Parses decimal integer from a bounded (not necessarily null-terminated) span without allocations.
+// Returns false and keeps `out` untouched if the span is malformed or the value is outside [min, max]
+template<typename T>
+bool parse_int(const char *data, size_t length, T &out,
+               T min = std::numeric_limits<T>::min(), T max = std::numeric_limits<T>::max()) {
+    if (data == nullptr) return false;
+
+    const char *begin = data;
+    const char *end = data + length;
+
+    while (begin < end && _is_space(*begin)) ++begin;
+    while (end > begin && _is_space(*(end - 1))) --end;
+
+    bool negative = false;
+    if (begin < end && (*begin == '-' || *begin == '+')) {
+        negative = *begin == '-';
+        ++begin;
+    }
+
+    if (begin == end) return false;
+
+    // Enough to hold any 32-bit value, longer input can't pass the range check anyway
+    constexpr int64_t limit = (int64_t) 1 << 40;
+
+    int64_t value = 0;
+    for (; begin < end; ++begin) {
+        if (*begin < '0' || *begin > '9') return false;
+
+        value = value * 10 + (*begin - '0');
+        if (value > limit) return false;
+    }
+
+    if (negative) value = -value;
+    if (value < (int64_t) min || value > (int64_t) max) return false;
+
+    out = (T) value;
+    return true;
+}
+
+// Formats integer into a fixed buffer. Returns length without terminating zero, or 0 if the buffer is too small
+template<typename T>
+size_t format_int(char *buffer, size_t size, T value) {
+    char digits[24];
+    size_t count = 0;
+
+    bool negative = false;
+    uint64_t abs_value = (uint64_t) value;
+    if constexpr (std::is_signed_v<T>) {
+        negative = value < 0;
+        if (negative) abs_value = (uint64_t) -(int64_t) value;
+    }
+
+    do {
+        digits[count++] = (char) ('0' + abs_value % 10);
+        abs_value /= 10;
+    } while (abs_value > 0);
+
+    const size_t length = count + (negative ? 1 : 0);
+    if (length + 1 > size) return 0;
+
+    size_t pos = 0;
+    if (negative) buffer[pos++] = '-';
+    while (count > 0) buffer[pos++] = digits[--count];
+    buffer[pos] = '\0';
+
+    return length;
+}
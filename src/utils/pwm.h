@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstdint>
+#include <algorithm>
+
+#include "sys_constants.h"
+
+#ifdef ARDUINO_ARCH_ESP32
+#include <soc/soc_caps.h>
+#endif
+
+// Brightness and temperature travel through config and protocol in a fixed logical scale (PWM_MAX_VALUE).
+// PwmTraits describes the hardware side: the duty range and carrier frequency for one board,
+// every conversion between the two is resolved at compile time to shifts and multiplies
+
+constexpr uint8_t PWM_LOGICAL_RESOLUTION = PWM_RESOLUTION;
+
+// Widest duty the LEDC timer takes: 20 bits on ESP32, 14 on ESP32-C3/S2/S3. ledcSetup() fails above it
+#ifdef SOC_LEDC_TIMER_BIT_WIDE_NUM
+constexpr uint8_t PWM_HARDWARE_RESOLUTION = std::min(16, SOC_LEDC_TIMER_BIT_WIDE_NUM);
+#else
+constexpr uint8_t PWM_HARDWARE_RESOLUTION = 16;
+#endif
+
+// PWM outputs shared by every controller, zones included: LEDC channels on ESP32, any pin on ESP8266
+#ifdef SOC_LEDC_CHANNEL_NUM
+constexpr uint8_t PWM_CHANNEL_COUNT = SOC_LEDC_CHANNEL_NUM;
+#else
+constexpr uint8_t PWM_CHANNEL_COUNT = UINT8_MAX;
+#endif
+
+constexpr uint32_t pwm_max_frequency(uint8_t resolution) {
+#ifdef ARDUINO_ARCH_ESP32
+    return 40000000ul >> resolution;
+#else
+    (void) resolution;
+    return 60000ul;
+#endif
+}
+
+// Bit replication keeps both ends exact: 0 -> 0, PWM_MAX_VALUE -> UINT16_MAX
+constexpr uint16_t pwm_logical_to_16(uint16_t value) {
+    static_assert(2 * PWM_LOGICAL_RESOLUTION >= 16, "Logical resolution is too low for bit replication");
+
+    return (uint16_t) (value << (16 - PWM_LOGICAL_RESOLUTION))
+        | (uint16_t) (value >> (2 * PWM_LOGICAL_RESOLUTION - 16));
+}
+
+// Resolution is capped to what the board supports, like the frequency
+template<uint8_t Resolution, uint32_t Frequency>
+struct PwmTraits {
+    static_assert(Resolution >= 8 && Resolution <= 16, "PWM resolution must be within 8..16 bits");
+
+    static constexpr uint8_t RESOLUTION = std::min(Resolution, PWM_HARDWARE_RESOLUTION);
+    static constexpr uint16_t MAX_VALUE = (uint16_t) ((1ul << RESOLUTION) - 1);
+    static constexpr uint32_t FREQUENCY = std::min<uint32_t>(Frequency, pwm_max_frequency(RESOLUTION));
+
+    static constexpr uint16_t from_16(uint16_t value) {
+        return value >> (16 - RESOLUTION);
+    }
+
+    static constexpr uint16_t from_logical(uint16_t value) {
+        return from_16(pwm_logical_to_16(value));
+    }
+
+    // round(a * b / MAX_VALUE) for a, b <= MAX_VALUE, division by 2^n - 1 folded into shifts
+    static constexpr uint16_t scale(uint16_t a, uint16_t b) {
+        const uint32_t x = (uint32_t) a * b + (1ul << (RESOLUTION - 1));
+        return (uint16_t) ((x + (x >> RESOLUTION)) >> RESOLUTION);
+    }
+};
+
+// Start offsets that spread the on-times of channels sharing one PWM period, so the supply doesn't see
+// every channel switching on at once. Channels are packed one after another, a channel that doesn't fit
+// the rest of the period is aligned to its end. Duty is unchanged, and channels overlap only as far as
+// their sum exceeds the period. LEDC can't wrap an on-time around the period end, hence no wrapping here
+inline void pwm_stagger(const uint16_t *duty, uint16_t *phase, uint8_t count, uint16_t period) {
+    uint32_t offset = 0;
+    for (uint8_t i = 0; i < count; ++i) {
+        const uint16_t on = std::min(duty[i], period);
+        if (offset + on <= period) {
+            phase[i] = offset;
+            offset += on;
+        } else {
+            phase[i] = period - on;
+        }
+    }
+}
+
+typedef PwmTraits<PWM_RESOLUTION, PWM_FREQUENCY> PwmDefault;
+typedef PwmTraits<16, 1000> PwmHighResolution;
+typedef PwmTraits<10, 39000> PwmHighFrequency;
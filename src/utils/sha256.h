@@ -0,0 +1,169 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// Portable streaming SHA-256 (FIPS 180-4). Used to verify firmware images, so it must produce
+// the same digest on the device and on the host
+
+class Sha256 {
+public:
+    static constexpr size_t DIGEST_SIZE = 32;
+    static constexpr size_t HEX_SIZE = DIGEST_SIZE * 2;
+
+private:
+    static constexpr size_t BLOCK_SIZE = 64;
+
+    uint32_t _state[8]{};
+    uint8_t _block[BLOCK_SIZE]{};
+    size_t _block_length = 0;
+    uint64_t _total_length = 0;
+
+public:
+    Sha256() { reset(); }
+
+    void reset() {
+        static constexpr uint32_t INITIAL_STATE[8] = {
+            0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+        };
+
+        memcpy(_state, INITIAL_STATE, sizeof(_state));
+        _block_length = 0;
+        _total_length = 0;
+    }
+
+    void update(const uint8_t *data, size_t length) {
+        _total_length += length;
+
+        if (_block_length > 0) {
+            const size_t count = std::min(length, BLOCK_SIZE - _block_length);
+            memcpy(_block + _block_length, data, count);
+
+            _block_length += count;
+            data += count;
+            length -= count;
+
+            if (_block_length < BLOCK_SIZE) return;
+
+            _transform(_block);
+            _block_length = 0;
+        }
+
+        for (; length >= BLOCK_SIZE; data += BLOCK_SIZE, length -= BLOCK_SIZE) _transform(data);
+
+        memcpy(_block, data, length);
+        _block_length = length;
+    }
+
+    void finish(uint8_t (&digest)[DIGEST_SIZE]) {
+        const uint64_t bit_length = _total_length * 8;
+
+        _block[_block_length++] = 0x80;
+        if (_block_length > BLOCK_SIZE - 8) {
+            memset(_block + _block_length, 0, BLOCK_SIZE - _block_length);
+            _transform(_block);
+            _block_length = 0;
+        }
+
+        memset(_block + _block_length, 0, BLOCK_SIZE - 8 - _block_length);
+        for (size_t i = 0; i < 8; ++i) _block[BLOCK_SIZE - 1 - i] = (uint8_t) (bit_length >> (i * 8));
+        _transform(_block);
+
+        for (size_t i = 0; i < 8; ++i) {
+            digest[i * 4] = (uint8_t) (_state[i] >> 24);
+            digest[i * 4 + 1] = (uint8_t) (_state[i] >> 16);
+            digest[i * 4 + 2] = (uint8_t) (_state[i] >> 8);
+            digest[i * 4 + 3] = (uint8_t) _state[i];
+        }
+    }
+
+    // Case-insensitive comparison with a hex encoded digest
+    static bool equals_hex(const uint8_t (&digest)[DIGEST_SIZE], const char *hex, size_t length) {
+        if (hex == nullptr || length != HEX_SIZE) return false;
+
+        for (size_t i = 0; i < DIGEST_SIZE; ++i) {
+            const int hi = _hex_value(hex[i * 2]);
+            const int lo = _hex_value(hex[i * 2 + 1]);
+            if (hi < 0 || lo < 0 || digest[i] != (uint8_t) (hi << 4 | lo)) return false;
+        }
+
+        return true;
+    }
+
+    static void to_hex(const uint8_t (&digest)[DIGEST_SIZE], char (&out)[HEX_SIZE + 1]) {
+        static constexpr char DIGITS[] = "0123456789abcdef";
+
+        for (size_t i = 0; i < DIGEST_SIZE; ++i) {
+            out[i * 2] = DIGITS[digest[i] >> 4];
+            out[i * 2 + 1] = DIGITS[digest[i] & 0xf];
+        }
+
+        out[HEX_SIZE] = '\0';
+    }
+
+private:
+    static int _hex_value(char ch) {
+        if (ch >= '0' && ch <= '9') return ch - '0';
+        if (ch >= 'a' && ch <= 'f') return ch - 'a' + 10;
+        if (ch >= 'A' && ch <= 'F') return ch - 'A' + 10;
+
+        return -1;
+    }
+
+    static inline uint32_t _rotr(uint32_t value, uint8_t bits) {
+        return (value >> bits) | (value << (32 - bits));
+    }
+
+    void _transform(const uint8_t *block) {
+        static constexpr uint32_t K[64] = {
+            0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+            0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+            0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+            0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+            0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+            0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+            0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+            0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+        };
+
+        uint32_t w[64];
+        for (size_t i = 0; i < 16; ++i) {
+            w[i] = (uint32_t) block[i * 4] << 24 | (uint32_t) block[i * 4 + 1] << 16
+                   | (uint32_t) block[i * 4 + 2] << 8 | (uint32_t) block[i * 4 + 3];
+        }
+
+        for (size_t i = 16; i < 64; ++i) {
+            const uint32_t s0 = _rotr(w[i - 15], 7) ^ _rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+            const uint32_t s1 = _rotr(w[i - 2], 17) ^ _rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+            w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+
+        uint32_t a = _state[0], b = _state[1], c = _state[2], d = _state[3];
+        uint32_t e = _state[4], f = _state[5], g = _state[6], h = _state[7];
+
+        for (size_t i = 0; i < 64; ++i) {
+            const uint32_t t1 = h + (_rotr(e, 6) ^ _rotr(e, 11) ^ _rotr(e, 25)) + ((e & f) ^ (~e & g)) + K[i] + w[i];
+            const uint32_t t2 = (_rotr(a, 2) ^ _rotr(a, 13) ^ _rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+
+            h = g;
+            g = f;
+            f = e;
+            e = d + t1;
+            d = c;
+            c = b;
+            b = a;
+            a = t1 + t2;
+        }
+
+        _state[0] += a;
+        _state[1] += b;
+        _state[2] += c;
+        _state[3] += d;
+        _state[4] += e;
+        _state[5] += f;
+        _state[6] += g;
+        _state[7] += h;
+    }
+};
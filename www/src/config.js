@@ -2,6 +2,7 @@ import {AppConfigBase} from "./lib/index.js";
 
 import {PropertyConfig} from "./props.js";
 import {PacketType} from "./cmd.js";
+import {PRESET_COUNT, ZONE_COUNT} from "./sys_constants.js";
 
 
 export class Config extends AppConfigBase {
@@ -13,6 +14,10 @@ export class Config extends AppConfigBase {
 
     sysConfig;
 
+    preset;
+    presets;
+    buttonActions;
+
     ledType;
     singleLedMode
     rgbMode;
@@ -32,7 +37,22 @@ export class Config extends AppConfigBase {
             {code: 0, name: "Single"},
             {code: 1, name: "RGB"},
             {code: 2, name: "CCT"},
-        ]
+        ];
+
+        this.lists["pwmProfile"] = [
+            {code: 0, name: "Default"},
+            {code: 1, name: "High Resolution"},
+            {code: 2, name: "High Frequency"},
+        ];
+
+        this.lists["buttonAction"] = [
+            {code: 0, name: "None"},
+            {code: 1, name: "Power"},
+            {code: 2, name: "Temperature"},
+            {code: 3, name: "Next Preset"},
+            {code: 4, name: "Brightness Up"},
+            {code: 5, name: "Brightness Down"},
+        ];
     }
 
     get cmd() {return PacketType.GET_CONFIG;}
@@ -65,6 +85,11 @@ export class Config extends AppConfigBase {
             wifiConnectionCheckInterval: parser.readUint32(),
             wifiMaxConnectionAttemptInterval: parser.readUint32(),
 
+            wifiStaticIp: parser.readFixedString(32),
+            wifiGateway: parser.readFixedString(32),
+            wifiSubnet: parser.readFixedString(32),
+            wifiDns: parser.readFixedString(32),
+
             ledType: this.ledType = parser.readUint8(),
 
             ledRPin: parser.readUint8(),
@@ -74,6 +99,7 @@ export class Config extends AppConfigBase {
             ledMinBrightness: parser.readUint16(),
             ledMinTemperature: parser.readUint16(),
             ledMaxTemperature: parser.readUint16(),
+            ledPwmProfile: parser.readUint8(),
 
             button_enabled: parser.readBoolean(),
             button_pin: parser.readUint8(),
@@ -96,6 +122,39 @@ export class Config extends AppConfigBase {
             mqttConvertBrightness: parser.readBoolean(),
         };
 
+        this.preset = parser.readUint8();
+        this.presets = Array.from({length: PRESET_COUNT}, () => ({
+            brightness: parser.readUint16(),
+            color: parser.readUint32(),
+            colorTemperature: parser.readUint16(),
+            transition: parser.readUint32(),
+        }));
+
+        this.buttonActions = {
+            click1: parser.readUint8(),
+            click2: parser.readUint8(),
+            click3: parser.readUint8(),
+            hold1: parser.readUint8(),
+            hold2: parser.readUint8(),
+        };
+
+        this.color16 = Array.from({length: 3}, () => parser.readUint16());
+        this.calibration16 = Array.from({length: 3}, () => parser.readUint16());
+
+        this.zones = Array.from({length: ZONE_COUNT - 1}, () => ({
+            enabled: parser.readBoolean(),
+            ledType: parser.readUint8(),
+            ledRPin: parser.readUint8(),
+            ledGPin: parser.readUint8(),
+            ledBPin: parser.readUint8(),
+
+            power: parser.readBoolean(),
+            brightness: parser.readUint16(),
+            color: parser.readUint32(),
+            colorTemperature: parser.readUint16(),
+            nightMode: parser.readBoolean(),
+        }));
+
         this.refreshLedMode();
     }
 
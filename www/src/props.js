@@ -74,6 +74,7 @@ export const PropertyConfig = [{
         {key: "sysConfig.ledMinTemperature", title: "Min Temperature", type: "int", kind: "Uint16", cmd: PacketType.SYS_CONFIG_LED_MIN_TEMPERATURE, visibleIf: "showTemperature"},
         {key: "sysConfig.ledMaxTemperature", title: "Max Temperature", type: "int", kind: "Uint16", cmd: PacketType.SYS_CONFIG_LED_MAX_TEMPERATURE, visibleIf: "showTemperature"},
         {key: "sysConfig.ledMinBrightness", title: "Min Brightness", type: "int", kind: "Uint16", cmd: PacketType.SYS_CONFIG_LED_MIN_BRIGHTNESS},
+        {key: "sysConfig.ledPwmProfile", title: "PWM Profile", type: "select", kind: "Uint8", cmd: PacketType.SYS_CONFIG_LED_PWM_PROFILE, list: "pwmProfile"},
 
         {type: "title", label: "Actions", extra: {m_top: true}},
         {key: "apply_led_config", type: "button", label: "Apply Settings"}
@@ -91,10 +92,21 @@ export const PropertyConfig = [{
         {key: "sysConfig.wifiConnectionCheckInterval", title: "Connection Check Interval", type: "int", kind: "Uint32", cmd: PacketType.SYS_CONFIG_WIFI_CONNECTION_CHECK_INTERVAL},
         {key: "sysConfig.wifiMaxConnectionAttemptInterval", title: "Max Connection Attempt Interval", type: "int", kind: "Uint32", cmd: PacketType.SYS_CONFIG_WIFI_MAX_CONNECTION_ATTEMPT_INTERVAL},
 
+        {type: "title", label: "Static IP"},
+        {key: "sysConfig.wifiStaticIp", title: "IP Address", type: "text", kind: "FixedString", maxLength: 32, cmd: PacketType.SYS_CONFIG_WIFI_STATIC_IP},
+        {key: "sysConfig.wifiGateway", title: "Gateway", type: "text", kind: "FixedString", maxLength: 32, cmd: PacketType.SYS_CONFIG_WIFI_GATEWAY},
+        {key: "sysConfig.wifiSubnet", title: "Subnet Mask", type: "text", kind: "FixedString", maxLength: 32, cmd: PacketType.SYS_CONFIG_WIFI_SUBNET},
+        {key: "sysConfig.wifiDns", title: "DNS", type: "text", kind: "FixedString", maxLength: 32, cmd: PacketType.SYS_CONFIG_WIFI_DNS},
+
         {type: "title", label: "Button"},
         {key: "sysConfig.button_enabled", title: "Enabled", type: "trigger", kind: "Boolean", cmd: PacketType.SYS_CONFIG_BUTTON_ENABLED},
         {key: "sysConfig.button_pin", title: "Pin", type: "int", kind: "Uint8", cmd: PacketType.SYS_CONFIG_BUTTON_PIN, min: 0, max: 32},
         {key: "sysConfig.button_high_state", title: "High State", type: "trigger", kind: "Boolean", cmd: PacketType.SYS_CONFIG_BUTTON_HIGH_STATE},
+        {key: "buttonActions.click1", title: "Click", type: "select", kind: "Uint8", cmd: PacketType.BUTTON_ACTION_CLICK_1, list: "buttonAction"},
+        {key: "buttonActions.click2", title: "Double Click", type: "select", kind: "Uint8", cmd: PacketType.BUTTON_ACTION_CLICK_2, list: "buttonAction"},
+        {key: "buttonActions.click3", title: "Triple Click", type: "select", kind: "Uint8", cmd: PacketType.BUTTON_ACTION_CLICK_3, list: "buttonAction"},
+        {key: "buttonActions.hold1", title: "Hold", type: "select", kind: "Uint8", cmd: PacketType.BUTTON_ACTION_HOLD_1, list: "buttonAction"},
+        {key: "buttonActions.hold2", title: "Click + Hold", type: "select", kind: "Uint8", cmd: PacketType.BUTTON_ACTION_HOLD_2, list: "buttonAction"},
 
         {type: "title", label: "SYSTEM EXTRA"},
         {key: "sysConfig.powerChangeTimeout", title: "Power Change Timeout", type: "int", kind: "Uint32", cmd: PacketType.SYS_CONFIG_POWER_CHANGE_TIMEOUT},
@@ -1,3 +1,6 @@
 export const PWM_RESOLUTION = 14;
 export const PWM_MAX_VALUE = (2 ** PWM_RESOLUTION - 1);
-export const TEMPERATURE_MAX_VALUE = PWM_MAX_VALUE * 2;
\ No newline at end of file
+export const TEMPERATURE_MAX_VALUE = PWM_MAX_VALUE * 2;
+
+export const PRESET_COUNT = 8;
+export const ZONE_COUNT = 4;
@@ -0,0 +1,190 @@
+// Load generator for the binary WebSocket protocol.
+// Ramps up concurrent clients, sends signed packets at a fixed rate per client and reports
+// ack latency (p50/p99), dropped requests and device-side loop jitter (/api/loop) per stage.
+//
+// Requires Node.js 22+ (global WebSocket and fetch).
+// Usage: node tools/ws_load.mjs --host esp_led.local [--clients 8] [--step 1] [--rate 10] [--duration 10] [--mode get|set]
+
+const PACKET_SIGNATURE = 0xDABA;
+const REQUEST_TIMEOUT = 2000;
+
+// Keep in sync with src/cmd.js
+const PacketType = {
+    BRIGHTNESS: 0x02,
+    GET_CONFIG: 0xa0,
+};
+
+function parseArgs(argv) {
+    const result = {host: "esp_led.local", clients: 8, step: 1, rate: 10, duration: 10, mode: "get", auth: null};
+    for (let i = 0; i < argv.length; i += 2) {
+        const key = argv[i].replace(/^--/, "");
+        if (!(key in result)) throw new Error(`Unknown argument: ${argv[i]}`);
+
+        result[key] = typeof result[key] === "number" ? Number(argv[i + 1]) : argv[i + 1];
+    }
+
+    return result;
+}
+
+// Header (little-endian): signature u16, request id u16, packet type u8, payload size u8
+function buildPacket(requestId, type, payload = new Uint8Array(0)) {
+    const buffer = new ArrayBuffer(6 + payload.length);
+    const view = new DataView(buffer);
+
+    view.setUint16(0, PACKET_SIGNATURE, true);
+    view.setUint16(2, requestId, true);
+    view.setUint8(4, type);
+    view.setUint8(5, payload.length);
+    new Uint8Array(buffer, 6).set(payload);
+
+    return buffer;
+}
+
+class StageStats {
+    sent = 0;
+    received = 0;
+    dropped = 0;
+    latencies = [];
+
+    percentile(p) {
+        if (this.latencies.length === 0) return NaN;
+
+        const sorted = [...this.latencies].sort((a, b) => a - b);
+        return sorted[Math.min(sorted.length - 1, Math.floor(sorted.length * p))];
+    }
+}
+
+class LoadClient {
+    #url;
+    #mode;
+    #interval;
+    #socket = null;
+    #timer = null;
+    #requestId = 0;
+    #pending = new Map();
+
+    stats = null;
+
+    constructor(url, rate, mode) {
+        this.#url = url;
+        this.#mode = mode;
+        this.#interval = 1000 / rate;
+    }
+
+    start() {
+        return new Promise((resolve, reject) => {
+            this.#socket = new WebSocket(this.#url);
+            this.#socket.binaryType = "arraybuffer";
+
+            this.#socket.onopen = () => {
+                this.#timer = setInterval(() => this.#tick(), this.#interval);
+                resolve();
+            };
+
+            this.#socket.onerror = (e) => reject(new Error(`Unable to connect to ${this.#url}: ${e.message ?? e}`));
+            this.#socket.onmessage = (e) => this.#onMessage(e.data);
+        });
+    }
+
+    stop() {
+        clearInterval(this.#timer);
+        this.#socket?.close();
+    }
+
+    #tick() {
+        const now = performance.now();
+        for (const [id, sentAt] of this.#pending) {
+            if (now - sentAt < REQUEST_TIMEOUT) continue;
+
+            this.#pending.delete(id);
+            if (this.stats) this.stats.dropped++;
+        }
+
+        const id = this.#requestId = (this.#requestId + 1) & 0xffff;
+        let packet;
+        if (this.#mode === "set") {
+            const value = new Uint8Array(2);
+            new DataView(value.buffer).setUint16(0, 1024 + (id % 1024), true);
+            packet = buildPacket(id, PacketType.BRIGHTNESS, value);
+        } else {
+            packet = buildPacket(id, PacketType.GET_CONFIG);
+        }
+
+        this.#pending.set(id, now);
+        this.#socket.send(packet);
+        if (this.stats) this.stats.sent++;
+    }
+
+    #onMessage(data) {
+        if (!(data instanceof ArrayBuffer) || data.byteLength < 6) return;
+
+        const view = new DataView(data);
+        if (view.getUint16(0, true) !== PACKET_SIGNATURE) return;
+
+        const id = view.getUint16(2, true);
+        const sentAt = this.#pending.get(id);
+        if (sentAt === undefined) return;
+
+        this.#pending.delete(id);
+        if (this.stats) {
+            this.stats.received++;
+            this.stats.latencies.push(performance.now() - sentAt);
+        }
+    }
+}
+
+async function fetchLoopStats(args, reset) {
+    const headers = args.auth ? {Authorization: `Basic ${Buffer.from(args.auth).toString("base64")}`} : {};
+    try {
+        const response = await fetch(`http://${args.host}/api/loop${reset ? "?reset=1" : ""}`, {headers});
+        return await response.json();
+    } catch {
+        return null;
+    }
+}
+
+async function main() {
+    const args = parseArgs(process.argv.slice(2));
+    const url = `ws://${args.host}/ws`;
+
+    console.log(`Target: ${url}, mode: ${args.mode}, rate: ${args.rate} req/s per client`);
+    console.log("clients  sent  recv  drop    p50 ms    p99 ms  loop avg us  loop max us");
+
+    const clients = [];
+    try {
+        for (let count = args.step; count <= args.clients; count += args.step) {
+            while (clients.length < count) {
+                const client = new LoadClient(url, args.rate, args.mode);
+                await client.start();
+                clients.push(client);
+            }
+
+            const stats = new StageStats();
+            await fetchLoopStats(args, true);
+            for (const client of clients) client.stats = stats;
+
+            await new Promise(resolve => setTimeout(resolve, args.duration * 1000));
+
+            for (const client of clients) client.stats = null;
+            const loop = await fetchLoopStats(args, false);
+
+            console.log([
+                String(count).padStart(7),
+                String(stats.sent).padStart(5),
+                String(stats.received).padStart(5),
+                String(stats.dropped).padStart(5),
+                stats.percentile(0.5).toFixed(1).padStart(9),
+                stats.percentile(0.99).toFixed(1).padStart(9),
+                String(loop?.jitter_avg ?? "-").padStart(12),
+                String(loop?.jitter_max ?? "-").padStart(12),
+            ].join(" "));
+        }
+    } finally {
+        for (const client of clients) client.stop();
+    }
+}
+
+main().catch(e => {
+    console.error(e.message);
+    process.exit(1);
+});